@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# Compares Google Benchmark JSON results against a baseline
+# Usage: compare.py baseline.json results.json [threshold percentage]
+# Exits with 1 when any benchmark is slower than baseline by more than threshold
+
+import json
+import os
+import sys
+
+def load(path):
+	with open(path) as file:
+		data = json.load(file)
+	results = {}
+	for item in data["benchmarks"]:
+		# Medians are used when repetitions were run as they are less sensitive to noise
+		if item.get("run_type") == "aggregate" and item.get("aggregate_name") != "median":
+			continue
+		name = item.get("run_name", item["name"])
+		# Multithreaded benchmarks are measured in wall time, the rest in CPU time
+		metric = "real_time" if name.endswith("/real_time") else "cpu_time"
+		results[name] = (item[metric], item["time_unit"])
+	return results
+
+def main():
+	if len(sys.argv) < 3:
+		print("Usage: " + sys.argv[0] + " baseline.json results.json [threshold]")
+		return 2
+	if not os.path.exists(sys.argv[1]):
+		print("No baseline found at " + sys.argv[1] + ", record one with benchmark-baseline target")
+		return 0
+	baseline, results = load(sys.argv[1]), load(sys.argv[2])
+	threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 10.0
+	regressions = 0
+
+	print("%-60s %14s %14s %9s" % ("Benchmark", "Baseline", "Current", "Change"))
+	for name, (time, unit) in results.items():
+		if name not in baseline:
+			print("%-60s %14s %11.1f %s %9s" % (name, "-", time, unit, "new"))
+			continue
+		base_time, base_unit = baseline[name]
+		if base_unit != unit:
+			print("%-60s time unit changed, skipped" % name)
+			continue
+		change = (time - base_time) * 100.0 / base_time if base_time > 0 else 0.0
+		mark = ""
+		if change > threshold:
+			mark = " REGRESSION"
+			regressions += 1
+		print("%-60s %11.1f %s %11.1f %s %+8.1f%%%s" % (name, base_time, unit, time, unit, change, mark))
+
+	if regressions > 0:
+		print(str(regressions) + " benchmark(s) are more than " + str(threshold) + "% slower than baseline")
+		return 1
+	return 0
+
+if __name__ == "__main__":
+	sys.exit(main())
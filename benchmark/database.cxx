@@ -0,0 +1,62 @@
+#include "fixtures.hxx"
+
+#include <benchmark/benchmark.h>
+
+using namespace StormByte::VideoConvert;
+
+/* Queue sizes of a fresh install, a big library and an exaggerated one */
+#define QUEUE_SIZES ->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond)
+
+/* Films inserted per iteration, as interactive, manifest and sweep batch them */
+static const unsigned int INSERT_BATCH_SIZE = 200;
+
+/* Claim is always released so queue is unchanged between iterations */
+static void BM_get_film_for_process(benchmark::State& state) {
+	auto& database = Benchmark::Fixtures::database(state.range(0));
+	for (auto _: state) {
+		auto ffmpeg = database.get_film_for_process();
+		if (!ffmpeg) {
+			state.SkipWithError("Queue is empty");
+			break;
+		}
+		database.release_film_process(*ffmpeg);
+	}
+}
+BENCHMARK(BM_get_film_for_process) QUEUE_SIZES;
+
+/* Inserted films are told apart from the queue by their priority so they can be removed (untimed) afterwards */
+static void BM_insert_films(benchmark::State& state) {
+	auto& database = Benchmark::Fixtures::database(state.range(0));
+	std::list<Database::Data::film> films;
+	for (unsigned int i = 0; i < INSERT_BATCH_SIZE; i++)
+		films.push_back(Benchmark::Fixtures::film(state.range(0) + i, Database::Data::film::IMPORTANT));
+
+	for (auto _: state) {
+		if (!database.insert_films(films)) {
+			state.SkipWithError("Films could not be inserted");
+			break;
+		}
+		state.PauseTiming();
+		Benchmark::Fixtures::remove_films(state.range(0), Database::Data::film::IMPORTANT);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * INSERT_BATCH_SIZE);
+}
+BENCHMARK(BM_insert_films) QUEUE_SIZES;
+
+static void BM_finish_film_process(benchmark::State& state) {
+	auto& database = Benchmark::Fixtures::database(state.range(0));
+	const auto film = Benchmark::Fixtures::film(state.range(0), Database::Data::film::IMPORTANT);
+
+	for (auto _: state) {
+		state.PauseTiming();
+		const auto film_id = database.insert_film(film);
+		state.ResumeTiming();
+		if (!film_id) {
+			state.SkipWithError("Film could not be inserted");
+			break;
+		}
+		database.finish_film_process(*film_id, true);
+	}
+}
+BENCHMARK(BM_finish_film_process) QUEUE_SIZES;
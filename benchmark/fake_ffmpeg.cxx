@@ -0,0 +1,223 @@
+/*
+ * Stand-in for both ffmpeg and ffprobe used by scheduler simulations (-DENABLE_SIMULATION=ON)
+ *
+ * Inputs are not media but files starting with a one line JSON descriptor (the rest of the file
+ * can be sparse so it has the size of the film it represents):
+ *	duration, frame_rate, bitrate			Probed film data
+ *	width, height, video_codec, hdr		First video stream
+ *	audio								Channels of each audio stream
+ *	subtitles							Number of subtitle streams
+ *	encode_seconds						Time the encode takes
+ *	output_size							Bytes of written output (sparse)
+ *	fail, crash							Encode exits with error or is killed by a signal halfway
+ *	progress								Seconds between progress lines in stderr, 0 disables them
+ *
+ * Environment:
+ *	VIDEOCONVERT_FAKE_SPEED				Times the clock runs faster than real time (1 by default)
+ *	VIDEOCONVERT_FAKE_JOURNAL			File where encode start and end are appended as
+ *										"start <steady ns> <input>" and "end <steady ns> <ok|fail|crash> <input>"
+ */
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <jsoncpp/json/json.h>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const std::chrono::milliseconds TICK = std::chrono::milliseconds(50); // Longest real sleep so progress and signals are timely
+
+static std::optional<Json::Value> read_descriptor(const std::string& file) {
+	std::ifstream input(file);
+	std::string line;
+	Json::Value descriptor;
+	if (!input || !std::getline(input, line) || !Json::Reader().parse(line, descriptor, false) || !descriptor.isObject())
+		return {};
+	return descriptor;
+}
+
+static void journal(const std::string& event, const std::string& file) {
+	const char* journal_file = std::getenv("VIDEOCONVERT_FAKE_JOURNAL");
+	if (!journal_file) return;
+	const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	const std::string line = event.substr(0, event.find(' ')) + " " + std::to_string(now) + (event.find(' ') == std::string::npos ? "" : event.substr(event.find(' '))) + " " + file + "\n";
+	// A single append write is atomic so concurrent encodes do not mix their lines
+	const int fd = open(journal_file, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (fd != -1) {
+		[[maybe_unused]] const ssize_t written = write(fd, line.c_str(), line.size());
+		close(fd);
+	}
+}
+
+static Json::Value color_output(const Json::Value& descriptor) {
+	Json::Value frame;
+	const bool hdr = descriptor["hdr"].asBool();
+	frame["pix_fmt"] = hdr ? "yuv420p10le" : "yuv420p";
+	frame["color_space"] = hdr ? "bt2020nc" : "bt709";
+	frame["color_primaries"] = hdr ? "bt2020" : "bt709";
+	frame["color_transfer"] = hdr ? "smpte2084" : "bt709";
+	if (hdr) {
+		Json::Value mastering, light;
+		mastering["side_data_type"] = "Mastering display metadata";
+		mastering["red_x"] = "35400/50000"; mastering["red_y"] = "14600/50000";
+		mastering["green_x"] = "8500/50000"; mastering["green_y"] = "39850/50000";
+		mastering["blue_x"] = "6550/50000"; mastering["blue_y"] = "2300/50000";
+		mastering["white_point_x"] = "15635/50000"; mastering["white_point_y"] = "16450/50000";
+		mastering["min_luminance"] = "50/10000"; mastering["max_luminance"] = "40000000/10000";
+		light["side_data_type"] = "Content light level metadata";
+		light["max_content"] = 1000; light["max_average"] = 400;
+		frame["side_data_list"].append(mastering);
+		frame["side_data_list"].append(light);
+	}
+	Json::Value result;
+	result["frames"].append(frame);
+	return result;
+}
+
+static Json::Value streams_output(const Json::Value& descriptor, const std::string& selection) {
+	Json::Value result;
+	result["streams"] = Json::Value(Json::arrayValue);
+	if (selection == "V") {
+		Json::Value stream;
+		stream["index"] = 0;
+		stream["codec_name"] = descriptor.get("video_codec", "h264").asString();
+		result["streams"].append(stream);
+	}
+	else if (selection == "a") {
+		for (Json::ArrayIndex i = 0; i < descriptor["audio"].size(); i++) {
+			Json::Value stream;
+			stream["index"] = i + 1;
+			stream["codec_name"] = descriptor["audio"][i].asUInt() > 2 ? "ac3" : "aac";
+			stream["channels"] = descriptor["audio"][i].asInt();
+			stream["tags"]["language"] = "eng";
+			result["streams"].append(stream);
+		}
+	}
+	else if (selection == "s") {
+		for (unsigned int i = 0; i < descriptor["subtitles"].asUInt(); i++) {
+			Json::Value stream;
+			stream["index"] = descriptor["audio"].size() + i + 1;
+			stream["codec_name"] = "subrip";
+			stream["tags"]["language"] = "eng";
+			result["streams"].append(stream);
+		}
+	}
+	return result;
+}
+
+static Json::Value resolution_output(const Json::Value& descriptor) {
+	Json::Value stream, result;
+	stream["codec_name"] = descriptor.get("video_codec", "h264").asString();
+	stream["width"] = descriptor["width"].asUInt();
+	stream["height"] = descriptor["height"].asUInt();
+	stream["r_frame_rate"] = std::to_string(static_cast<unsigned int>(descriptor.get("frame_rate", 24.0).asDouble() * 1000)) + "/1000";
+	stream["color_transfer"] = descriptor["hdr"].asBool() ? "smpte2084" : "bt709";
+	result["streams"].append(stream);
+	result["format"]["duration"] = std::to_string(descriptor["duration"].asDouble());
+	result["format"]["bit_rate"] = std::to_string(descriptor["bitrate"].asUInt64());
+	return result;
+}
+
+static int ffprobe(const std::vector<std::string>& arguments) {
+	const auto descriptor = read_descriptor(arguments.back());
+	if (!descriptor) {
+		std::cerr << arguments.back() << ": Invalid data found when processing input" << std::endl;
+		return 1;
+	}
+
+	std::string selection;
+	for (size_t i = 0; i + 1 < arguments.size(); i++)
+		if (arguments[i] == "-select_streams") selection = arguments[i + 1];
+
+	Json::Value output;
+	if (selection == "V:0")
+		output = color_output(*descriptor);
+	else if (selection == "v:0")
+		output = resolution_output(*descriptor);
+	else
+		output = streams_output(*descriptor, selection);
+	std::cout << Json::StyledWriter().write(output);
+	return 0;
+}
+
+static int ffmpeg(const std::vector<std::string>& arguments) {
+	std::string input;
+	for (size_t i = 0; i + 1 < arguments.size(); i++)
+		if (arguments[i] == "-i") input = arguments[i + 1];
+	const std::string output = arguments.back();
+	const auto descriptor = read_descriptor(input);
+	if (!descriptor) {
+		std::cerr << input << ": Invalid data found when processing input" << std::endl;
+		return 1;
+	}
+
+	const char* speed_text = std::getenv("VIDEOCONVERT_FAKE_SPEED");
+	const double speed = speed_text ? std::max(std::atof(speed_text), 0.001) : 1.0;
+	const double encode_seconds = (*descriptor)["encode_seconds"].asDouble();
+	const double stop_at = (*descriptor)["fail"].asBool() || (*descriptor)["crash"].asBool() ? encode_seconds / 2 : encode_seconds;
+	const double progress = (*descriptor)["progress"].asDouble();
+	const double frame_rate = descriptor->get("frame_rate", 24.0).asDouble();
+	const double duration = (*descriptor)["duration"].asDouble();
+
+	journal("start", input);
+	const auto start = std::chrono::steady_clock::now();
+	double elapsed = 0, next_progress = progress; // In simulated seconds
+	while (elapsed < stop_at) {
+		const auto remaining = std::chrono::duration<double>((stop_at - elapsed) / speed);
+		std::this_thread::sleep_for(std::min(std::chrono::duration_cast<std::chrono::steady_clock::duration>(remaining), std::chrono::duration_cast<std::chrono::steady_clock::duration>(TICK)));
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * speed;
+		if (progress > 0 && elapsed >= next_progress) {
+			const double position = encode_seconds > 0 ? duration * std::min(elapsed, stop_at) / encode_seconds : duration;
+			char line[160];
+			std::snprintf(line, sizeof(line), "frame=%.0f fps=%.1f time=%02d:%02d:%05.2f speed=%.3fx", position * frame_rate, position * frame_rate / elapsed, static_cast<int>(position / 3600), static_cast<int>(position / 60) % 60, position - 60 * static_cast<int>(position / 60), position / elapsed);
+			std::cerr << line << std::endl;
+			next_progress += progress;
+		}
+	}
+
+	if ((*descriptor)["crash"].asBool()) {
+		journal("end crash", input);
+		std::signal(SIGSEGV, SIG_DFL);
+		std::raise(SIGSEGV);
+	}
+	if ((*descriptor)["fail"].asBool()) {
+		journal("end fail", input);
+		std::cerr << "Simulated encoder failure for " << input << std::endl;
+		return 1;
+	}
+
+	// Output keeps the descriptor so it can be probed as well
+	{
+		std::ofstream file(output, std::ios::trunc);
+		if (!file) {
+			std::cerr << output << ": No such file or directory" << std::endl;
+			return 1;
+		}
+		file << Json::FastWriter().write(*descriptor);
+	}
+	if (truncate(output.c_str(), (*descriptor)["output_size"].asUInt64()) != 0) {
+		std::cerr << output << ": Could not set output size" << std::endl;
+		return 1;
+	}
+	journal("end ok", input);
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	const std::vector<std::string> arguments(argv + 1, argv + argc);
+	if (arguments.empty()) {
+		std::cerr << "Fake ffmpeg and ffprobe for scheduler simulations, inputs are JSON descriptors" << std::endl;
+		return 1;
+	}
+	// Only ffprobe is asked to print JSON
+	for (const auto& argument: arguments)
+		if (argument == "-print_format")
+			return ffprobe(arguments);
+	return ffmpeg(arguments);
+}
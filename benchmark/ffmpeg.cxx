@@ -0,0 +1,69 @@
+#include "task/execute/ffmpeg/base.hxx"
+#include "ffmpeg/stream/video/copy.hxx"
+#include "ffmpeg/stream/audio/copy.hxx"
+#include "ffmpeg/stream/subtitle/copy.hxx"
+#ifdef ENABLE_HEVC
+#include "ffmpeg/stream/video/hevc.hxx"
+#endif
+#ifdef ENABLE_AAC
+#include "ffmpeg/stream/audio/aac.hxx"
+#endif
+
+#include <benchmark/benchmark.h>
+
+using namespace StormByte::VideoConvert;
+
+/* Exposes the command line building done before ffmpeg is executed */
+class CommandLine: public Task::Execute::FFmpeg::Base {
+	public:
+		CommandLine(const FFmpeg& ffmpeg):Task::Execute::FFmpeg::Base(ffmpeg) {}
+
+		inline const std::string& build() {
+			m_executables[0].m_arguments = "-i \"" + m_ffmpeg.get_input_file().string() + "\"";
+			pre_run_actions();
+			return m_executables[0].m_arguments;
+		}
+};
+
+/* Same film the worker would get from a 4K HDR source with several audio and subtitle tracks */
+static FFmpeg hdr_film() {
+	FFmpeg ffmpeg(1, "/media/films/Film/Film.mkv");
+	ffmpeg.set_duration(8142.3);
+	ffmpeg.set_resolution(3);
+	ffmpeg.set_frame_rate(24000.0 / 1001.0);
+	#ifdef ENABLE_HEVC
+	Stream::Video::HEVC video(0);
+	video.set_HDR(Stream::Video::HEVC::HDR(35400, 14600, 8500, 39850, 6550, 2300, 15635, 16450, 50, 40000000, 1000, 400));
+	ffmpeg.add_stream(video);
+	#else
+	ffmpeg.add_stream(Stream::Video::Copy(0));
+	#endif
+	#ifdef ENABLE_AAC
+	ffmpeg.add_stream(Stream::Audio::AAC(0));
+	#endif
+	for (unsigned short i = 1; i < 4; i++)
+		ffmpeg.add_stream(Stream::Audio::Copy(i));
+	ffmpeg.add_stream(Stream::Subtitle::Copy(-1));
+	return ffmpeg;
+}
+
+static void BM_ffmpeg_add_streams(benchmark::State& state) {
+	for (auto _: state)
+		benchmark::DoNotOptimize(hdr_film());
+}
+BENCHMARK(BM_ffmpeg_add_streams);
+
+static void BM_ffmpeg_stream_parameters(benchmark::State& state) {
+	const FFmpeg ffmpeg = hdr_film();
+	for (auto _: state)
+		for (const auto& stream: ffmpeg.get_streams())
+			benchmark::DoNotOptimize(stream->ffmpeg_parameters());
+}
+BENCHMARK(BM_ffmpeg_stream_parameters);
+
+static void BM_ffmpeg_command_line(benchmark::State& state) {
+	CommandLine command(hdr_film());
+	for (auto _: state)
+		benchmark::DoNotOptimize(command.build());
+}
+BENCHMARK(BM_ffmpeg_command_line);
@@ -0,0 +1,41 @@
+#include "fixtures.hxx"
+#include "ffprobe/ffprobe.hxx"
+
+#include <benchmark/benchmark.h>
+
+using namespace StormByte::VideoConvert;
+
+/* Recorded outputs of the probes initialize runs, one per member of the fixture */
+struct recorded_probe {
+	std::string m_color, m_video, m_audio, m_subtitle, m_resolution;
+};
+
+static recorded_probe load(const std::string& fixture) {
+	Json::Value root;
+	Json::Reader().parse(Benchmark::Fixtures::read(fixture), root, false);
+	Json::StreamWriterBuilder writer;
+	return recorded_probe {
+		Json::writeString(writer, root["color"]),
+		Json::writeString(writer, root["video"]),
+		Json::writeString(writer, root["audio"]),
+		Json::writeString(writer, root["subtitle"]),
+		Json::writeString(writer, root["resolution"])
+	};
+}
+
+static void BM_ffprobe_parse(benchmark::State& state, const std::string& fixture) {
+	const recorded_probe probe = load(fixture);
+	for (auto _: state)
+		benchmark::DoNotOptimize(FFprobe::from_outputs(probe.m_color, probe.m_video, probe.m_audio, probe.m_subtitle, probe.m_resolution));
+	state.SetBytesProcessed(state.iterations() * (probe.m_color.size() + probe.m_video.size() + probe.m_audio.size() + probe.m_subtitle.size() + probe.m_resolution.size()));
+}
+BENCHMARK_CAPTURE(BM_ffprobe_parse, sdr_1080p, std::string("sdr_1080p.json"));
+BENCHMARK_CAPTURE(BM_ffprobe_parse, hdr_4k, std::string("hdr_4k.json"));
+
+/* Only what sweep needs, parsed once per file */
+static void BM_ffprobe_parse_resolution(benchmark::State& state, const std::string& fixture) {
+	const recorded_probe probe = load(fixture);
+	for (auto _: state)
+		benchmark::DoNotOptimize(FFprobe::from_outputs("", "", "", "", probe.m_resolution));
+}
+BENCHMARK_CAPTURE(BM_ffprobe_parse_resolution, hdr_4k, std::string("hdr_4k.json"));
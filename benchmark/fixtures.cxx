@@ -0,0 +1,98 @@
+#include "fixtures.hxx"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace StormByte::VideoConvert;
+
+std::map<unsigned int, std::unique_ptr<Benchmark::Fixtures::temporary_database>> Benchmark::Fixtures::s_databases;
+
+std::string Benchmark::Fixtures::read(const std::string& name) {
+	std::ifstream file(Types::path_t(BENCHMARK_FIXTURES_DIR) / name);
+	if (!file) throw std::runtime_error("Fixture " + name + " could not be read");
+	std::stringstream buffer;
+	buffer << file.rdbuf();
+	return buffer.str();
+}
+
+Database::Data::film Benchmark::Fixtures::film(const unsigned int& number, const Database::Data::film::priority& priority) {
+	Database::Data::film film;
+	film.m_file			= "/media/films/Film " + std::to_string(number) + "/Film " + std::to_string(number) + ".mkv";
+	film.m_priority		= priority;
+	film.m_duration		= 6000.0 + number % 3000;
+	film.m_resolution	= 2; // 1080p
+	film.m_frame_rate	= 24000.0 / 1001.0;
+	film.m_content		= Database::Data::film::content { 8000000000ULL + number, number * 2654435761ULL };
+
+	Database::Data::film::stream video, audio, commentary, subtitle;
+	video.m_id = 0; video.m_codec = Database::Data::film::stream::VIDEO_HEVC;
+	audio.m_id = 0; audio.m_codec = Database::Data::film::stream::AUDIO_COPY;
+	commentary.m_id = 1; commentary.m_codec = Database::Data::film::stream::AUDIO_COPY;
+	subtitle.m_id = -1; subtitle.m_codec = Database::Data::film::stream::SUBTITLE_COPY;
+	film.m_streams = { video, audio, commentary, subtitle };
+	return film;
+}
+
+Database::SQLite3& Benchmark::Fixtures::database(const unsigned int& films) {
+	auto it = s_databases.find(films);
+	if (it == s_databases.end()) {
+		const Types::path_t file = std::filesystem::temp_directory_path() / ("StormByte-videoconvert-benchmark-" + std::to_string(getpid()) + "-" + std::to_string(films) + ".sqlite");
+		it = s_databases.emplace(films, std::make_unique<temporary_database>(file, films)).first;
+	}
+	return *it->second->m_database;
+}
+
+void Benchmark::Fixtures::remove_films(const unsigned int& films, const Database::Data::film::priority& priority) {
+	database(films);
+	const std::string condition = "SELECT id FROM films WHERE prio = " + std::to_string(priority);
+	sqlite3* handle = s_databases.at(films)->m_handle;
+	execute(handle, "BEGIN");
+	execute(handle, "DELETE FROM converted_content");
+	execute(handle, "DELETE FROM stream_hdr WHERE film_id IN (" + condition + ")");
+	execute(handle, "DELETE FROM streams WHERE film_id IN (" + condition + ")");
+	execute(handle, "DELETE FROM films WHERE prio = " + std::to_string(priority));
+	execute(handle, "COMMIT");
+}
+
+void Benchmark::Fixtures::execute(sqlite3* handle, const std::string& sql) {
+	char* error = nullptr;
+	if (sqlite3_exec(handle, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+		const std::string message = error ? error : "Unknown error";
+		sqlite3_free(error);
+		throw std::runtime_error("Benchmark database: " + message);
+	}
+}
+
+/* Populated with bulk statements: inserting one by one through the library takes hours for the biggest sizes */
+Benchmark::Fixtures::temporary_database::temporary_database(const Types::path_t& file, const unsigned int& films):m_file(file), m_handle(nullptr) {
+	std::filesystem::remove(m_file);
+	m_database = std::make_unique<Database::SQLite3>(m_file); // Creates schema
+	if (sqlite3_open(m_file.c_str(), &m_handle) != SQLITE_OK)
+		throw std::runtime_error("Benchmark database could not be opened");
+
+	// Same values Fixtures::film generates
+	execute(m_handle, "BEGIN");
+	execute(m_handle,
+		"WITH RECURSIVE sequence(n) AS (SELECT 0 UNION ALL SELECT n + 1 FROM sequence WHERE n + 1 < " + std::to_string(films) + ") "
+		"INSERT INTO films(file, prio, duration, resolution, frame_rate, size, fingerprint) "
+		"SELECT '/media/films/Film ' || n || '/Film ' || n || '.mkv', " + std::to_string(Database::Data::film::NORMAL) + ", 6000.0 + n % 3000, 2, 24000.0 / 1001.0, 8000000000 + n, n * 2654435761 FROM sequence"
+	);
+	const std::list<std::pair<short, Database::Data::film::stream::codec>> streams = {
+		{ 0, Database::Data::film::stream::VIDEO_HEVC },
+		{ 0, Database::Data::film::stream::AUDIO_COPY },
+		{ 1, Database::Data::film::stream::AUDIO_COPY },
+		{ -1, Database::Data::film::stream::SUBTITLE_COPY }
+	};
+	for (const auto& stream: streams)
+		execute(m_handle, "INSERT INTO streams(id, film_id, codec) SELECT " + std::to_string(stream.first) + ", id, " + std::to_string(stream.second) + " FROM films");
+	execute(m_handle, "COMMIT");
+}
+
+Benchmark::Fixtures::temporary_database::~temporary_database() {
+	m_database.reset();
+	sqlite3_close(m_handle);
+	std::error_code error;
+	std::filesystem::remove(m_file, error);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "database/sqlite3.hxx"
+
+#include <map>
+#include <sqlite3.h>
+#include <memory>
+#include <string>
+
+namespace StormByte::VideoConvert::Benchmark {
+	/* Shared setup for all benchmarks, everything is built once per process and cached */
+	class Fixtures {
+		public:
+			/* Raw content of a file in fixtures folder */
+			static std::string read(const std::string& name);
+			/* Film as interactive mode would queue it: HEVC video with 2 audio and 1 subtitle streams */
+			static Database::Data::film film(const unsigned int& number, const Database::Data::film::priority& priority = Database::Data::film::NORMAL);
+			/* Temporary database already holding that many queued films with NORMAL priority, removed at exit */
+			static Database::SQLite3& database(const unsigned int& films);
+			/* Removes films added by a benchmark to that database (untimed cleanup, queue operations are not used) */
+			static void remove_films(const unsigned int& films, const Database::Data::film::priority& priority);
+
+		private:
+			struct temporary_database {
+				temporary_database(const Types::path_t& file, const unsigned int& films);
+				~temporary_database();
+				Types::path_t m_file;
+				std::unique_ptr<Database::SQLite3> m_database;
+				sqlite3* m_handle; // Own connection for bulk statements
+			};
+
+			static void execute(sqlite3* handle, const std::string& sql);
+			static std::map<unsigned int, std::unique_ptr<temporary_database>> s_databases;
+	};
+}
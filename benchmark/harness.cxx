@@ -0,0 +1,98 @@
+#include "harness.hxx"
+
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sqlite3.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace StormByte::VideoConvert;
+
+void Benchmark::Harness::prepare_folder(const Types::path_t& folder, const unsigned int& sleep) {
+	for (std::string item: { "input", "output", "work" })
+		std::filesystem::create_directories(folder / item);
+
+	std::ofstream config(folder / "config.conf");
+	config << "database = \"" << (folder / "database.sqlite").string() << "\";" << std::endl;
+	config << "input = \"" << (folder / "input").string() << "\";" << std::endl;
+	config << "output = \"" << (folder / "output").string() << "\";" << std::endl;
+	config << "work = \"" << (folder / "work").string() << "\";" << std::endl;
+	config << "logfile = \"" << (folder / "daemon.log").string() << "\";" << std::endl;
+	config << "loglevel = 3;" << std::endl; // Timings are logged as INFO
+	config << "sleep = " << sleep << ";" << std::endl;
+	config << "pause = 0;" << std::endl;
+	config << "minfree = 0;" << std::endl;
+	config << "onfinish = \"move\";" << std::endl;
+}
+
+pid_t Benchmark::Harness::start_daemon(const Types::path_t& folder) {
+	const std::string config = (folder / "config.conf").string();
+	const std::string output = (folder / "daemon.out").string();
+
+	const pid_t daemon = fork();
+	if (daemon == -1)
+		throw std::runtime_error("Daemon could not be started: " + std::string(std::strerror(errno)));
+	if (daemon == 0) {
+		setpgid(0, 0);
+		const int fd = open(output.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+		if (fd != -1) {
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+			close(fd);
+		}
+		execl(VIDEOCONVERT_EXECUTABLE, VIDEOCONVERT_EXECUTABLE, "-c", config.c_str(), "-d", static_cast<char*>(nullptr));
+		_exit(127);
+	}
+	setpgid(daemon, daemon); // Also from here so there is no race with the child
+	return daemon;
+}
+
+void Benchmark::Harness::stop_daemon(const pid_t& daemon, const int& signal) {
+	// Graceful stop is only sent to daemon as it stops its children by itself
+	if (signal == SIGKILL)
+		kill(-daemon, SIGKILL);
+	else
+		kill(daemon, signal);
+	waitpid(daemon, nullptr, 0);
+}
+
+unsigned int Benchmark::Harness::count_films(const Types::path_t& folder, const std::string& condition) {
+	unsigned int result = 0;
+	sqlite3* handle;
+	if (sqlite3_open_v2((folder / "database.sqlite").c_str(), &handle, SQLITE_OPEN_READONLY, nullptr) == SQLITE_OK) {
+		sqlite3_busy_timeout(handle, 5000);
+		sqlite3_stmt* stmt;
+		const std::string sql = "SELECT COUNT(*) FROM films WHERE " + condition;
+		if (sqlite3_prepare_v2(handle, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+			if (sqlite3_step(stmt) == SQLITE_ROW)
+				result = sqlite3_column_int(stmt, 0);
+			sqlite3_finalize(stmt);
+		}
+	}
+	sqlite3_close(handle);
+	return result;
+}
+
+Benchmark::Harness::phase_totals Benchmark::Harness::read_timings(const Types::path_t& folder) {
+	static const std::string MARK = " (ms): ";
+	phase_totals result;
+	std::ifstream log(folder / "daemon.log");
+	std::string line;
+	while (std::getline(log, line)) {
+		const size_t position = line.rfind(MARK);
+		if (line.find("Timings for ") == std::string::npos || position == std::string::npos) continue;
+		std::istringstream phases(line.substr(position + MARK.size()));
+		std::string phase;
+		while (phases >> phase) {
+			const size_t equal = phase.find('=');
+			if (equal == std::string::npos) continue;
+			auto& total = result[phase.substr(0, equal)];
+			total.first += std::stod(phase.substr(equal + 1));
+			total.second++;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "types.hxx"
+
+#include <map>
+#include <string>
+#include <csignal>
+#include <sys/types.h>
+
+namespace StormByte::VideoConvert::Benchmark {
+	/* Helpers to run the real daemon binary over a temporary setup */
+	class Harness {
+		public:
+			/* Accumulated milliseconds and how many films reported each phase */
+			using phase_totals = std::map<std::string, std::pair<double, unsigned int>>;
+
+			/* Creates input, output and work folders and the configuration file inside folder */
+			static void prepare_folder(const Types::path_t& folder, const unsigned int& sleep);
+			/* Daemon runs in its own process group so its children can be stopped along with it */
+			static pid_t start_daemon(const Types::path_t& folder);
+			static void stop_daemon(const pid_t& daemon, const int& signal = SIGTERM);
+			/* Films in queue database matching SQL condition, read through its own read only connection */
+			static unsigned int count_films(const Types::path_t& folder, const std::string& condition);
+			/* Daemon and finalizer log a "Timings for <file> (ms): phase=milliseconds ..." line per film */
+			static phase_totals read_timings(const Types::path_t& folder);
+	};
+}
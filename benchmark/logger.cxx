@@ -0,0 +1,33 @@
+#include "utils/logger.hxx"
+
+#include <benchmark/benchmark.h>
+
+using namespace StormByte::VideoConvert;
+
+/* Writer thread output is discarded so only the producer side is measured */
+static Utils::Logger& logger(const Utils::Logger::FORMAT& format) {
+	static Utils::Logger text("/dev/null", Utils::Logger::LEVEL_INFO, Utils::Logger::FORMAT_TEXT);
+	static Utils::Logger json("/dev/null", Utils::Logger::LEVEL_INFO, Utils::Logger::FORMAT_JSON);
+	return format == Utils::Logger::FORMAT_JSON ? json : text;
+}
+
+static void BM_logger_message_line(benchmark::State& state, const Utils::Logger::FORMAT& format) {
+	auto& log = logger(format);
+	const Types::path_t file = "/media/films/Film/Film.mkv";
+	unsigned int film_id = 0;
+	for (auto _: state)
+		log.message_line(Utils::Logger::LEVEL_INFO, "Film ", file, " (ID ", film_id++, ") converted in ", 5432.1, " seconds");
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_logger_message_line, text, Utils::Logger::FORMAT_TEXT)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_logger_message_line, json, Utils::Logger::FORMAT_JSON)->ThreadRange(1, 8)->UseRealTime();
+
+/* Messages under display level have to be almost free */
+static void BM_logger_filtered(benchmark::State& state) {
+	auto& log = logger(Utils::Logger::FORMAT_TEXT);
+	const Types::path_t file = "/media/films/Film/Film.mkv";
+	for (auto _: state)
+		log.message_line(Utils::Logger::LEVEL_DEBUG, "Film ", file, " probed");
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_logger_filtered)->ThreadRange(1, 8)->UseRealTime();
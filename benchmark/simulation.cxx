@@ -0,0 +1,466 @@
+#include "simulation.hxx"
+#include "ffmpeg_path.h"
+#include "control/client.hxx"
+#include "control/protocol.hxx"
+#include "ffprobe/ffprobe.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <sys/wait.h>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+
+using namespace StormByte::VideoConvert;
+
+/* Share of a typical library and the speed libx265 reaches on them on a mid range CPU */
+const std::vector<Benchmark::Simulation::profile> Benchmark::Simulation::PROFILES = {
+	{ 854,	480,	false,	0.15,	4.0,	2500000 },
+	{ 1280,	720,	false,	0.25,	2.0,	5000000 },
+	{ 1920,	1080,	false,	0.35,	1.0,	10000000 },
+	{ 1920,	1080,	true,	0.10,	0.8,	15000000 },
+	{ 3840,	2160,	true,	0.15,	0.24,	40000000 }
+};
+/* Indexed by Database::Data::film::priority */
+const std::vector<double> Benchmark::Simulation::PRIORITY_SHARES = { 0.20, 0.60, 0.15, 0.05 };
+const std::chrono::milliseconds Benchmark::Simulation::POLL_INTERVAL = std::chrono::milliseconds(20);
+
+Benchmark::Simulation::Simulation(const options& opts):m_options(opts), m_restarts(0) {
+	char folder[] = "/tmp/StormByte-videoconvert-simulation-XXXXXX";
+	if (!mkdtemp(folder)) throw std::runtime_error("Temporary folder could not be created");
+	m_folder = folder;
+	Harness::prepare_folder(m_folder, 1);
+}
+
+Benchmark::Simulation::~Simulation() {
+	if (m_options.m_keep)
+		std::cout << "Simulation files kept in " << m_folder << std::endl;
+	else {
+		std::error_code error;
+		std::filesystem::remove_all(m_folder, error);
+	}
+}
+
+int Benchmark::Simulation::run() {
+	// A real encoder would make this take days
+	if (Types::path_t(FFMPEG_EXECUTABLE).filename() != "videoconvert-fake-ffmpeg") {
+		std::cerr << "Daemon uses " << FFMPEG_EXECUTABLE << ", configure with -DENABLE_SIMULATION=ON to build it against the fake ffmpeg" << std::endl;
+		return 1;
+	}
+
+	if (m_options.m_workload) {
+		if (!load_workload(*m_options.m_workload)) return 1;
+	}
+	else
+		generate_workload();
+	if (m_options.m_save_workload)
+		save_workload(*m_options.m_save_workload);
+	write_inputs();
+
+	std::cout << "Replaying " << m_jobs.size() << " films at " << m_options.m_speed << "x in " << m_folder << std::endl;
+	if (!replay()) return 1;
+
+	read_journal();
+	report();
+	return 0;
+}
+
+void Benchmark::Simulation::generate_workload() {
+	std::mt19937_64 random(m_options.m_seed);
+	std::discrete_distribution<size_t> profile_choice, priority_choice(PRIORITY_SHARES.begin(), PRIORITY_SHARES.end());
+	{
+		std::vector<double> shares;
+		for (const auto& item: PROFILES) shares.push_back(item.m_share);
+		profile_choice = std::discrete_distribution<size_t>(shares.begin(), shares.end());
+	}
+	std::uniform_real_distribution<double> duration(20 * 60, 180 * 60), chance(0, 1);
+	std::uniform_int_distribution<unsigned int> audio_streams(1, 3), subtitle_streams(0, 3);
+	const std::vector<unsigned int> channels = { 2, 6, 8 };
+
+	double total_encode = 0;
+	for (unsigned int i = 0; i < m_options.m_films; i++) {
+		const profile& item = PROFILES[profile_choice(random)];
+		job film;
+		std::ostringstream name;
+		name << "film-" << std::setw(6) << std::setfill('0') << i + 1 << ".mkv";
+		film.m_file = name.str();
+		film.m_priority = static_cast<unsigned short>(priority_choice(random));
+
+		Json::Value& descriptor = film.m_descriptor;
+		descriptor["file"] = film.m_file;
+		descriptor["priority"] = film.m_priority;
+		descriptor["duration"] = std::round(duration(random));
+		descriptor["width"] = item.m_width;
+		descriptor["height"] = item.m_height;
+		descriptor["frame_rate"] = 23.976;
+		descriptor["hdr"] = item.m_is_HDR;
+		descriptor["video_codec"] = item.m_height > 1080 ? "hevc" : "h264";
+		descriptor["bitrate"] = item.m_bitrate;
+		descriptor["audio"] = Json::Value(Json::arrayValue);
+		for (unsigned int stream = audio_streams(random); stream > 0; stream--)
+			descriptor["audio"].append(channels[random() % channels.size()]);
+		descriptor["subtitles"] = subtitle_streams(random);
+		descriptor["encode_seconds"] = descriptor["duration"].asDouble() / item.m_encode_speed;
+		descriptor["input_size"] = Json::UInt64(descriptor["duration"].asDouble() * item.m_bitrate / 8);
+		descriptor["output_size"] = Json::UInt64(descriptor["input_size"].asUInt64() / 2);
+		const double outcome = chance(random);
+		descriptor["fail"] = outcome < 0.02;
+		descriptor["crash"] = outcome >= 0.02 && outcome < 0.025;
+		descriptor["progress"] = 60;
+		total_encode += descriptor["encode_seconds"].asDouble();
+		m_jobs.push_back(std::move(film));
+	}
+
+	// Poisson arrivals so that encode time offered is load times the time elapsed
+	double arrival = 0;
+	std::exponential_distribution<double> interval(m_jobs.empty() || m_options.m_load <= 0 ? 1 : m_options.m_load * m_jobs.size() / total_encode);
+	for (auto& film: m_jobs) {
+		if (m_options.m_load > 0) arrival += interval(random);
+		film.m_arrival = arrival;
+		film.m_descriptor["arrival"] = arrival;
+	}
+}
+
+bool Benchmark::Simulation::load_workload(const Types::path_t& file) {
+	std::ifstream input(file);
+	if (!input) {
+		std::cerr << "Workload " << file << " could not be read" << std::endl;
+		return false;
+	}
+	std::string line;
+	unsigned int number = 0;
+	while (std::getline(input, line)) {
+		number++;
+		if (line.empty() || line[0] == '#') continue;
+		auto descriptor = Control::Protocol::parse(line);
+		if (!descriptor || !(*descriptor)["file"].isString() || !(*descriptor)["encode_seconds"].isNumeric()) {
+			std::cerr << "Workload line " << number << " is not a valid film descriptor" << std::endl;
+			return false;
+		}
+		job film;
+		film.m_file = (*descriptor)["file"].asString();
+		film.m_arrival = (*descriptor)["arrival"].asDouble();
+		film.m_priority = std::min<unsigned short>((*descriptor)["priority"].asUInt(), Database::Data::film::MAX - 1);
+		film.m_descriptor = std::move(*descriptor);
+		m_jobs.push_back(std::move(film));
+	}
+	std::stable_sort(m_jobs.begin(), m_jobs.end(), [](const job& a, const job& b) { return a.m_arrival < b.m_arrival; });
+	return true;
+}
+
+void Benchmark::Simulation::save_workload(const Types::path_t& file) const {
+	std::ofstream output(file);
+	for (const auto& film: m_jobs)
+		output << Control::Protocol::serialize(film.m_descriptor);
+}
+
+void Benchmark::Simulation::write_inputs() const {
+	// Files are sparse so declared sizes only count for storage admission
+	for (const auto& film: m_jobs) {
+		const Types::path_t file = m_folder / "input" / film.m_file;
+		{
+			std::ofstream output(file, std::ios::trunc);
+			output << Control::Protocol::serialize(film.m_descriptor);
+		}
+		if (film.m_descriptor["input_size"].isNumeric())
+			std::filesystem::resize_file(file, std::max<uintmax_t>(film.m_descriptor["input_size"].asUInt64(), std::filesystem::file_size(file)));
+	}
+}
+
+bool Benchmark::Simulation::replay() {
+	setenv("VIDEOCONVERT_FAKE_SPEED", std::to_string(m_options.m_speed).c_str(), 1);
+	setenv("VIDEOCONVERT_FAKE_JOURNAL", (m_folder / "journal").c_str(), 1);
+
+	m_start = std::chrono::steady_clock::now();
+	pid_t daemon = Harness::start_daemon(m_folder);
+	double next_kill = m_options.m_kill_interval;
+	auto next = m_jobs.begin();
+	while (true) {
+		int status;
+		if (waitpid(daemon, &status, WNOHANG) == daemon) {
+			std::cerr << "Daemon exited, see " << (m_folder / "daemon.out") << " and " << (m_folder / "daemon.log") << std::endl;
+			return false;
+		}
+
+		if (m_options.m_kill_interval > 0 && now() >= next_kill) {
+			// Simulates a power loss, children die along with daemon
+			Harness::stop_daemon(daemon, SIGKILL);
+			daemon = Harness::start_daemon(m_folder);
+			m_restarts++;
+			next_kill = now() + m_options.m_kill_interval;
+		}
+
+		auto due = next;
+		while (due != m_jobs.end() && due->m_arrival <= now()) due++;
+		if (due != next && enqueue(next, due))
+			next = due;
+
+		if (next == m_jobs.end() && Harness::count_films(m_folder, "unsupported = FALSE") == 0)
+			break;
+		std::this_thread::sleep_for(POLL_INTERVAL);
+	}
+
+	// Pending finalizations are waited for by a graceful stop
+	Harness::stop_daemon(daemon);
+	return true;
+}
+
+bool Benchmark::Simulation::enqueue(std::vector<job>::iterator begin, std::vector<job>::iterator end) {
+	Control::Client client(Types::path_t(m_folder / "database.sqlite").string() + ".sock");
+	if (!client.connect()) return false; // Still starting, retried on next poll
+
+	Json::Value request = Control::Protocol::request("enqueue");
+	for (auto it = begin; it != end; it++) {
+		Database::Data::film film;
+		film.m_file			= it->m_file;
+		film.m_priority		= static_cast<Database::Data::film::priority>(it->m_priority);
+		film.m_duration		= it->m_descriptor["duration"].asDouble();
+		film.m_frame_rate	= it->m_descriptor.get("frame_rate", 23.976).asDouble();
+		if (auto resolution = FFprobe::resolution_from_height(it->m_descriptor["height"].asUInt()))
+			film.m_resolution = *resolution;
+		// Unique content so duplicate detection does not drop any of them
+		film.m_content		= Database::Data::film::content { it->m_descriptor["input_size"].asUInt64(), std::hash<std::string>()(it->m_file) };
+
+		Database::Data::film::stream video, audio;
+		video.m_id = 0;
+		video.m_codec = Database::Data::film::stream::VIDEO_HEVC;
+		audio.m_id = -1;
+		audio.m_codec = Database::Data::film::stream::AUDIO_AAC;
+		film.m_streams = { video, audio };
+		request["films"].append(Control::Protocol::film_to_json(film));
+	}
+
+	// Taken before sending as daemon can start the encode before answering
+	const double enqueued = now();
+	Json::Value response;
+	try {
+		response = client.request(request);
+	}
+	catch (const std::exception&) {
+		return false; // Daemon was killed meanwhile
+	}
+	if (!response["ok"].asBool()) {
+		// Batch could have been stored right before a kill, so the ones already there are skipped
+		if (response["error"].asString().find("already in database") == std::string::npos) {
+			std::cerr << "Daemon refused films: " << response["error"].asString() << std::endl;
+			return false;
+		}
+		for (auto it = begin; it != end; it++) {
+			Json::Value single = Control::Protocol::request("enqueue");
+			single["films"].append(request["films"][static_cast<Json::ArrayIndex>(it - begin)]);
+			const double sent = now();
+			try {
+				response = client.request(single);
+			}
+			catch (const std::exception&) {
+				return false;
+			}
+			if (!response["ok"].asBool() && response["error"].asString().find("already in database") == std::string::npos)
+				return false;
+			if (!it->m_enqueued) it->m_enqueued = response["ok"].asBool() ? sent : enqueued;
+		}
+		return true;
+	}
+	for (auto it = begin; it != end; it++)
+		it->m_enqueued = enqueued;
+	return true;
+}
+
+void Benchmark::Simulation::read_journal() {
+	std::map<std::string, job*> films;
+	for (auto& film: m_jobs) films[film.m_file] = &film;
+
+	std::ifstream journal(m_folder / "journal");
+	std::string line;
+	const auto start = std::chrono::duration_cast<std::chrono::nanoseconds>(m_start.time_since_epoch()).count();
+	while (std::getline(journal, line)) {
+		std::istringstream fields(line);
+		std::string event, status, file;
+		long long time;
+		fields >> event >> time;
+		if (event == "end") fields >> status;
+		std::getline(fields >> std::ws, file);
+		auto film = films.find(Types::path_t(file).filename().string());
+		if (film == films.end()) continue;
+
+		const double simulated = static_cast<double>(time - start) / 1e9 * m_options.m_speed;
+		if (event == "start") {
+			if (!film->second->m_started) film->second->m_started = simulated;
+			film->second->m_encodes++;
+		}
+		else {
+			film->second->m_finished = simulated;
+			film->second->m_status = status;
+		}
+	}
+}
+
+void Benchmark::Simulation::report() const {
+	static const std::vector<std::string> PRIORITY_NAMES = { "low", "normal", "high", "important" };
+	struct summary {
+		double mean = 0, p50 = 0, p95 = 0, max = 0;
+		size_t count = 0;
+	};
+	auto summarize = [](std::vector<double> values) {
+		summary result;
+		if (values.empty()) return result;
+		std::sort(values.begin(), values.end());
+		result.count = values.size();
+		for (const auto& value: values) result.mean += value;
+		result.mean /= values.size();
+		result.p50 = values[values.size() / 2];
+		result.p95 = values[std::min(values.size() - 1, values.size() * 95 / 100)];
+		result.max = values.back();
+		return result;
+	};
+
+	std::vector<double> waits, latencies;
+	std::vector<std::vector<double>> priority_waits(PRIORITY_NAMES.size());
+	std::vector<std::pair<double, double>> busy; // Encoding intervals
+	double makespan = 0, encoding = 0;
+	unsigned int failed = 0, crashed = 0, reencodes = 0, missing = 0;
+	for (const auto& film: m_jobs) {
+		if (!film.m_started || !film.m_enqueued) {
+			missing++;
+			continue;
+		}
+		const double wait = *film.m_started - *film.m_enqueued;
+		waits.push_back(wait);
+		priority_waits[std::min<size_t>(film.m_priority, PRIORITY_NAMES.size() - 1)].push_back(wait);
+		if (film.m_encodes > 1) reencodes += film.m_encodes - 1;
+		if (film.m_finished) {
+			latencies.push_back(*film.m_finished - *film.m_enqueued);
+			makespan = std::max(makespan, *film.m_finished);
+			encoding += *film.m_finished - *film.m_started;
+		}
+		if (film.m_status == "fail") failed++;
+		else if (film.m_status == "crash") crashed++;
+	}
+
+	// Times a film started while one with higher priority was already waiting
+	unsigned int inversions = 0;
+	{
+		std::vector<std::tuple<double, int, unsigned short>> events; // Time, 0 arrival or 1 start, priority
+		for (const auto& film: m_jobs) {
+			if (!film.m_started || !film.m_enqueued) continue;
+			events.emplace_back(*film.m_enqueued, 0, film.m_priority);
+			events.emplace_back(*film.m_started, 1, film.m_priority);
+		}
+		std::sort(events.begin(), events.end());
+		std::vector<unsigned int> waiting(Database::Data::film::MAX, 0);
+		for (const auto& [time, kind, priority]: events) {
+			if (kind == 0) {
+				waiting[priority]++;
+				continue;
+			}
+			waiting[priority]--;
+			for (unsigned short higher = priority + 1; higher < waiting.size(); higher++)
+				if (waiting[higher] > 0) {
+					inversions++;
+					break;
+				}
+		}
+	}
+
+	const summary wait = summarize(waits), latency = summarize(latencies);
+	const double utilization = makespan > 0 ? 100.0 * encoding / makespan : 0;
+	const double real = makespan / m_options.m_speed;
+	auto hours = [](const double& seconds) { return seconds / 3600; };
+
+	std::cout << std::fixed << std::setprecision(2) << std::endl;
+	std::cout << "Films:                 " << m_jobs.size() << " (" << failed << " failed, " << crashed << " crashed, " << missing << " never started)" << std::endl;
+	std::cout << "Simulated makespan:    " << hours(makespan) << " h in " << real << " s" << std::endl;
+	std::cout << "Encoder utilization:   " << utilization << " %" << std::endl;
+	std::cout << "Queue wait (h):        mean " << hours(wait.mean) << ", p50 " << hours(wait.p50) << ", p95 " << hours(wait.p95) << ", max " << hours(wait.max) << std::endl;
+	std::cout << "Latency (h):           mean " << hours(latency.mean) << ", p50 " << hours(latency.p50) << ", p95 " << hours(latency.p95) << ", max " << hours(latency.max) << std::endl;
+	std::cout << "Priority inversions:   " << inversions << std::endl;
+	std::cout << "Daemon restarts:       " << m_restarts << " (" << reencodes << " encodes repeated)" << std::endl;
+	std::cout << std::endl << std::left << std::setw(12) << "Priority" << std::right << std::setw(8) << "Films" << std::setw(14) << "Mean wait" << std::setw(14) << "p95 wait" << std::endl;
+	for (size_t i = 0; i < PRIORITY_NAMES.size(); i++) {
+		const summary item = summarize(priority_waits[i]);
+		std::cout << std::left << std::setw(12) << PRIORITY_NAMES[i] << std::right << std::setw(8) << item.count << std::setw(12) << hours(item.mean) << " h" << std::setw(12) << hours(item.p95) << " h" << std::endl;
+	}
+	std::cout << std::endl << "Note: daemon overhead between encodes runs in real time, so it weighs " << m_options.m_speed << " times more than in a real run" << std::endl;
+
+	if (m_options.m_output) {
+		Json::Value root, benchmarks(Json::arrayValue);
+		root["context"]["simulated_films"] = static_cast<Json::UInt>(m_jobs.size());
+		root["context"]["speed"] = m_options.m_speed;
+		root["context"]["load"] = m_options.m_load;
+		auto add = [&](const std::string& name, const double& seconds) {
+			Json::Value item;
+			item["name"] = name;
+			item["run_type"] = "iteration";
+			item["iterations"] = 1;
+			item["real_time"] = seconds;
+			item["cpu_time"] = seconds;
+			item["time_unit"] = "s";
+			benchmarks.append(item);
+		};
+		add("simulation/makespan", makespan);
+		add("simulation/wait_mean", wait.mean);
+		add("simulation/wait_p95", wait.p95);
+		add("simulation/latency_mean", latency.mean);
+		add("simulation/latency_p95", latency.p95);
+		for (size_t i = 0; i < PRIORITY_NAMES.size(); i++)
+			add("simulation/wait_mean/" + PRIORITY_NAMES[i], summarize(priority_waits[i]).mean);
+		benchmarks[0]["utilization"] = utilization;
+		benchmarks[0]["priority_inversions"] = inversions;
+		root["benchmarks"] = benchmarks;
+
+		std::ofstream file(*m_options.m_output);
+		std::unique_ptr<Json::StreamWriter> writer(Json::StreamWriterBuilder().newStreamWriter());
+		writer->write(root, &file);
+		std::cout << std::endl << "Results written to " << *m_options.m_output << std::endl;
+	}
+}
+
+double Benchmark::Simulation::now() const {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count() * m_options.m_speed;
+}
+
+int main(int argc, char** argv) {
+	Benchmark::Simulation::options options;
+	for (int i = 1; i < argc; i++) {
+		const std::string argument = argv[i];
+		if ((argument == "-n" || argument == "--films") && i + 1 < argc)
+			options.m_films = std::stoul(argv[++i]);
+		else if (argument == "--seed" && i + 1 < argc)
+			options.m_seed = std::stoul(argv[++i]);
+		else if ((argument == "-s" || argument == "--speed") && i + 1 < argc)
+			options.m_speed = std::max(1.0, std::stod(argv[++i]));
+		else if ((argument == "-l" || argument == "--load") && i + 1 < argc)
+			options.m_load = std::max(0.0, std::stod(argv[++i]));
+		else if (argument == "--kill-interval" && i + 1 < argc)
+			options.m_kill_interval = std::max(0.0, std::stod(argv[++i]));
+		else if ((argument == "-w" || argument == "--workload") && i + 1 < argc)
+			options.m_workload = argv[++i];
+		else if (argument == "--save-workload" && i + 1 < argc)
+			options.m_save_workload = argv[++i];
+		else if ((argument == "-o" || argument == "--output") && i + 1 < argc)
+			options.m_output = argv[++i];
+		else if (argument == "-k" || argument == "--keep")
+			options.m_keep = true;
+		else {
+			std::cout << "Usage: " << argv[0] << " [--films count] [--seed number] [--speed times] [--load ratio] [--kill-interval seconds] [--workload file] [--save-workload file] [--output results.json] [--keep]" << std::endl;
+			return argument == "-h" || argument == "--help" ? 0 : 1;
+		}
+	}
+
+	try {
+		Benchmark::Simulation simulation(options);
+		return simulation.run();
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "harness.hxx"
+
+#include <chrono>
+#include <jsoncpp/json/json.h>
+#include <vector>
+
+namespace StormByte::VideoConvert::Benchmark {
+	/* Replays a queue workload on the real daemon built against the fake ffmpeg, which runs on a sped up clock */
+	class Simulation {
+		public:
+			struct options {
+				unsigned int m_films = 10000;
+				unsigned int m_seed = 1;
+				double m_speed = 50000; // Simulated seconds per real second
+				double m_load = 0.9; // Offered encode time over available time, 0 queues every film at start
+				double m_kill_interval = 0; // Simulated seconds between daemon kills (crash recovery), 0 disables it
+				Types::optional_path_t m_workload; // Replays films from a file instead of generating them
+				Types::optional_path_t m_save_workload;
+				Types::optional_path_t m_output; // JSON results, comparable with compare.py
+				bool m_keep = false;
+			};
+
+			Simulation(const options& opts);
+			Simulation(const Simulation&) = delete;
+			Simulation(Simulation&&) = delete;
+			Simulation& operator=(const Simulation&) = delete;
+			Simulation& operator=(Simulation&&) = delete;
+			~Simulation();
+
+			int run();
+
+		private:
+			/* Descriptor is what the fake ffmpeg reads from input, workload files hold one per line */
+			struct job {
+				std::string m_file;
+				double m_arrival; // Simulated seconds since start
+				unsigned short m_priority;
+				Json::Value m_descriptor;
+				std::optional<double> m_enqueued, m_started, m_finished; // Filled after run, simulated seconds
+				unsigned int m_encodes = 0;
+				std::string m_status;
+			};
+			struct profile {
+				unsigned short m_width, m_height;
+				bool m_is_HDR;
+				double m_share; // Of generated films
+				double m_encode_speed; // Film seconds encoded per second
+				unsigned int m_bitrate;
+			};
+			static const std::vector<profile> PROFILES;
+			static const std::vector<double> PRIORITY_SHARES;
+			static const std::chrono::milliseconds POLL_INTERVAL;
+
+			options m_options;
+			Types::path_t m_folder;
+			std::vector<job> m_jobs; // Sorted by arrival
+			std::chrono::steady_clock::time_point m_start;
+			unsigned int m_restarts;
+
+			void generate_workload();
+			bool load_workload(const Types::path_t& file);
+			void save_workload(const Types::path_t& file) const;
+			void write_inputs() const;
+			bool replay();
+			/* Sends films through control socket, false if daemon is not listening */
+			bool enqueue(std::vector<job>::iterator begin, std::vector<job>::iterator end);
+			bool enqueue_one(const job& item);
+			void read_journal();
+			void report() const;
+			double now() const;
+	};
+}
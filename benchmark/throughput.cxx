@@ -0,0 +1,245 @@
+#include "throughput.hxx"
+#include "ffmpeg_path.h"
+#include "database/sqlite3.hxx"
+#include "ffprobe/ffprobe.hxx"
+#include "task/execute/base.hxx"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <jsoncpp/json/json.h>
+#include <memory>
+#include <sys/wait.h>
+#include <thread>
+
+using namespace StormByte::VideoConvert;
+
+/* From 480p to 4K with the audio layouts most found: stereo, 5.1 and 7.1 */
+const std::list<Benchmark::Throughput::clip> Benchmark::Throughput::CLIPS = {
+	{ "sdr_480p",	854,	480,	false,	{ 2 } },
+	{ "sdr_720p",	1280,	720,	false,	{ 2, 6 } },
+	{ "sdr_1080p",	1920,	1080,	false,	{ 6, 2 } },
+	{ "hdr_1080p",	1920,	1080,	true,	{ 6 } },
+	{ "hdr_4k",		3840,	2160,	true,	{ 8, 2 } }
+};
+const std::chrono::milliseconds Benchmark::Throughput::POLL_INTERVAL = std::chrono::milliseconds(100);
+
+Benchmark::Throughput::Throughput(const options& opts):m_options(opts), m_frames(0) {
+	char folder[] = "/tmp/StormByte-videoconvert-throughput-XXXXXX";
+	if (!mkdtemp(folder)) throw std::runtime_error("Temporary folder could not be created");
+	m_folder = folder;
+	Harness::prepare_folder(m_folder, 1);
+}
+
+Benchmark::Throughput::~Throughput() {
+	if (m_options.m_keep)
+		std::cout << "Benchmark files kept in " << m_folder << std::endl;
+	else {
+		std::error_code error;
+		std::filesystem::remove_all(m_folder, error);
+	}
+}
+
+int Benchmark::Throughput::run() {
+	std::cout << "Generating " << CLIPS.size() << " clips of " << m_options.m_duration << " seconds in " << m_folder << std::endl;
+	if (!generate_clips() || !enqueue()) return 1;
+
+	std::cout << "Running daemon over " << m_files.size() << " queued films..." << std::endl;
+	auto wall = run_daemon();
+	if (!wall) return 1;
+
+	report(*wall, Harness::read_timings(m_folder));
+	return 0;
+}
+
+bool Benchmark::Throughput::generate_clips() {
+	for (const auto& item: CLIPS) {
+		const Types::path_t file = item.m_name + ".mkv";
+		Task::Execute::Base task(FFMPEG_EXECUTABLE, clip_arguments(item, m_folder / "input" / file));
+		if (task.run() != Task::HALT_OK) {
+			std::cerr << "Clip " << item.m_name << " could not be generated (FFmpeg needs libx264 and libx265):" << std::endl << task.get_stderr() << std::endl;
+			return false;
+		}
+		m_files.push_back(file);
+		for (unsigned int copy = 1; copy < m_options.m_copies; copy++) {
+			const Types::path_t copy_file = item.m_name + "-" + std::to_string(copy) + ".mkv";
+			std::filesystem::copy_file(m_folder / "input" / file, m_folder / "input" / copy_file);
+			m_files.push_back(copy_file);
+		}
+	}
+	return true;
+}
+
+std::string Benchmark::Throughput::clip_arguments(const clip& item, const Types::path_t& file) const {
+	const std::string duration = std::to_string(m_options.m_duration);
+	std::string result = "-hide_banner -loglevel error -y";
+	result += " -f lavfi -i testsrc2=size=" + std::to_string(item.m_width) + "x" + std::to_string(item.m_height) + ":rate=24000/1001:duration=" + duration;
+	unsigned int frequency = 440;
+	for (size_t i = 0; i < item.m_audio_channels.size(); i++, frequency += 110)
+		result += " -f lavfi -i sine=frequency=" + std::to_string(frequency) + ":sample_rate=48000:duration=" + duration;
+
+	result += " -map 0:v";
+	for (size_t i = 0; i < item.m_audio_channels.size(); i++)
+		result += " -map " + std::to_string(i + 1) + ":a";
+
+	if (item.m_is_HDR)
+		result += " -c:v libx265 -preset ultrafast -pix_fmt yuv420p10le -color_primaries bt2020 -color_trc smpte2084 -colorspace bt2020nc"
+			" -x265-params hdr10=1:repeat-headers=1:colorprim=bt2020:transfer=smpte2084:colormatrix=bt2020nc"
+			":master-display=G(13250,34500)B(7500,3000)R(34000,16000)WP(15635,16450)L(10000000,1):max-cll=1000,400";
+	else
+		result += " -c:v libx264 -preset ultrafast -pix_fmt yuv420p -color_primaries bt709 -color_trc bt709 -colorspace bt709";
+
+	size_t index = 0;
+	for (const auto& channels: item.m_audio_channels) {
+		const std::string stream = std::to_string(index++);
+		result += " -c:a:" + stream + (channels == 6 ? " ac3" : " aac") + " -ac:a:" + stream + " " + std::to_string(channels);
+	}
+
+	return result + " \"" + file.string() + "\"";
+}
+
+/* As interactive mode would queue them: HEVC keeping detected HDR and every audio stream converted */
+bool Benchmark::Throughput::enqueue() {
+	Database::SQLite3 database(m_folder / "database.sqlite");
+	for (const auto& file: m_files) {
+		const FFprobe probe = FFprobe::from_file(m_folder / "input" / file);
+		Database::Data::film film;
+		film.m_file			= file;
+		film.m_duration		= probe.get_duration();
+		film.m_frame_rate	= probe.get_frame_rate();
+		if (probe.get_resolution())
+			film.m_resolution = *probe.get_resolution();
+		if (probe.get_duration() && probe.get_frame_rate())
+			m_frames += *probe.get_duration() * *probe.get_frame_rate();
+
+		Database::Data::film::stream video, audio;
+		video.m_id = 0;
+		#ifdef ENABLE_HEVC
+		video.m_codec = Database::Data::film::stream::VIDEO_HEVC;
+		if (probe.is_HDR_detected())
+			video.m_hdr = probe.get_HDR().data();
+		#else
+		video.m_codec = Database::Data::film::stream::VIDEO_COPY;
+		#endif
+		audio.m_id = -1;
+		#ifdef ENABLE_AAC
+		audio.m_codec = Database::Data::film::stream::AUDIO_AAC;
+		#else
+		audio.m_codec = Database::Data::film::stream::AUDIO_COPY;
+		#endif
+		film.m_streams = { video, audio };
+
+		if (!database.insert_film(film)) {
+			std::cerr << "Film " << file << " could not be queued" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+std::optional<std::chrono::steady_clock::duration> Benchmark::Throughput::run_daemon() const {
+	const auto start = std::chrono::steady_clock::now();
+	const pid_t daemon = Harness::start_daemon(m_folder);
+
+	// Converted films are deleted from queue and failed ones kept as unsupported
+	std::optional<std::chrono::steady_clock::duration> wall;
+	while (true) {
+		if (waitpid(daemon, nullptr, WNOHANG) == daemon) {
+			std::cerr << "Daemon exited before queue was drained, see " << (m_folder / "daemon.out") << " and " << (m_folder / "daemon.log") << std::endl;
+			return {};
+		}
+		if (Harness::count_films(m_folder, "unsupported = FALSE") == 0) {
+			wall = std::chrono::steady_clock::now() - start;
+			break;
+		}
+		std::this_thread::sleep_for(POLL_INTERVAL);
+	}
+
+	Harness::stop_daemon(daemon);
+	return wall;
+}
+
+void Benchmark::Throughput::report(const std::chrono::steady_clock::duration& wall, const Harness::phase_totals& phases) const {
+	const unsigned int failed = Harness::count_films(m_folder, "unsupported = TRUE");
+	const unsigned int converted = m_files.size() - failed;
+	const double wall_ms = std::chrono::duration<double, std::milli>(wall).count();
+	const double encode_ms = phases.contains("encode") ? phases.at("encode").first : 0;
+	double loop_ms = 0; // Everything done by daemon main loop, finalizer runs in parallel
+	for (std::string phase: { "claim", "probe", "schedule", "prepare", "encode", "record" })
+		if (phases.contains(phase)) loop_ms += phases.at(phase).first;
+
+	const double films_per_hour = converted * 3600000.0 / wall_ms;
+	const double encode_fps = encode_ms > 0 ? m_frames * 1000.0 / encode_ms : 0;
+	const double overhead_ms = wall_ms - encode_ms;
+	char line[256];
+	std::cout << std::endl;
+	std::snprintf(line, sizeof(line), "Films: %u converted, %u failed in %.3f s", converted, failed, wall_ms / 1000.0); std::cout << line << std::endl;
+	std::snprintf(line, sizeof(line), "Throughput: %.1f films/hour, %.1f encode fps", films_per_hour, encode_fps); std::cout << line << std::endl;
+	std::snprintf(line, sizeof(line), "Overhead outside ffmpeg: %.3f s (%.1f%% of wall time), %.1f ms per film", overhead_ms / 1000.0, overhead_ms * 100.0 / wall_ms, overhead_ms / m_files.size()); std::cout << line << std::endl;
+	std::snprintf(line, sizeof(line), "Not in any phase (startup, pauses, polling and shutdown): %.3f s", (wall_ms - loop_ms) / 1000.0); std::cout << line << std::endl;
+	std::cout << std::endl;
+	std::snprintf(line, sizeof(line), "%-20s %14s %14s %8s", "Phase", "Total ms", "Mean ms", "Films"); std::cout << line << std::endl;
+	for (const auto& phase: phases) {
+		std::snprintf(line, sizeof(line), "%-20s %14.3f %14.3f %8u", phase.first.c_str(), phase.second.first, phase.second.first / phase.second.second, phase.second.second);
+		std::cout << line << std::endl;
+	}
+
+	if (m_options.m_output) {
+		// Same layout as Google Benchmark so compare.py can be used between builds or settings
+		Json::Value root, benchmarks(Json::arrayValue);
+		root["context"]["films"] = static_cast<Json::UInt>(m_files.size());
+		root["context"]["clip_duration"] = m_options.m_duration;
+		auto add = [&benchmarks](const std::string& name, const double& milliseconds) {
+			Json::Value item;
+			item["name"] = name;
+			item["run_name"] = name;
+			item["run_type"] = "iteration";
+			item["real_time"] = milliseconds;
+			item["cpu_time"] = milliseconds;
+			item["time_unit"] = "ms";
+			benchmarks.append(item);
+		};
+		add("throughput/wall_per_film", wall_ms / m_files.size());
+		add("throughput/overhead_per_film", overhead_ms / m_files.size());
+		if (m_frames > 0) add("throughput/encode_per_frame", encode_ms / m_frames);
+		for (const auto& phase: phases)
+			add("throughput/phase/" + phase.first, phase.second.first / phase.second.second);
+		benchmarks[0]["films_per_hour"] = films_per_hour;
+		benchmarks[0]["encode_fps"] = encode_fps;
+		root["benchmarks"] = benchmarks;
+
+		std::ofstream file(*m_options.m_output);
+		std::unique_ptr<Json::StreamWriter> writer(Json::StreamWriterBuilder().newStreamWriter());
+		writer->write(root, &file);
+		std::cout << std::endl << "Results written to " << *m_options.m_output << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	Benchmark::Throughput::options options;
+	for (int i = 1; i < argc; i++) {
+		const std::string argument = argv[i];
+		if ((argument == "-d" || argument == "--duration") && i + 1 < argc)
+			options.m_duration = std::stoul(argv[++i]);
+		else if ((argument == "-c" || argument == "--copies") && i + 1 < argc)
+			options.m_copies = std::max(1ul, std::stoul(argv[++i]));
+		else if ((argument == "-o" || argument == "--output") && i + 1 < argc)
+			options.m_output = argv[++i];
+		else if (argument == "-k" || argument == "--keep")
+			options.m_keep = true;
+		else {
+			std::cout << "Usage: " << argv[0] << " [--duration seconds] [--copies count] [--output results.json] [--keep]" << std::endl;
+			return argument == "-h" || argument == "--help" ? 0 : 1;
+		}
+	}
+
+	try {
+		Benchmark::Throughput throughput(options);
+		return throughput.run();
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "harness.hxx"
+
+#include <chrono>
+#include <list>
+#include <string>
+
+namespace StormByte::VideoConvert::Benchmark {
+	/* End to end run of the daemon over locally generated clips to measure its orchestration overhead */
+	class Throughput {
+		public:
+			struct options {
+				unsigned int m_duration = 10; // Seconds of each clip
+				unsigned int m_copies = 1; // Times each clip is queued
+				Types::optional_path_t m_output; // JSON results, comparable with compare.py
+				bool m_keep = false; // Keep generated folder for inspection
+			};
+
+			Throughput(const options& opts);
+			Throughput(const Throughput&) = delete;
+			Throughput(Throughput&&) = delete;
+			Throughput& operator=(const Throughput&) = delete;
+			Throughput& operator=(Throughput&&) = delete;
+			~Throughput();
+
+			int run();
+
+		private:
+			struct clip {
+				std::string m_name;
+				unsigned short m_width, m_height;
+				bool m_is_HDR;
+				std::list<unsigned short> m_audio_channels; // One stream per item
+			};
+			static const std::list<clip> CLIPS;
+			static const std::chrono::milliseconds POLL_INTERVAL;
+
+			options m_options;
+			Types::path_t m_folder;
+			std::list<Types::path_t> m_files; // Relative to input folder
+			double m_frames; // Total frames queued
+
+			bool generate_clips();
+			std::string clip_arguments(const clip& item, const Types::path_t& file) const;
+			bool enqueue();
+			/* Wall time from daemon start until every film is converted or failed */
+			std::optional<std::chrono::steady_clock::duration> run_daemon() const;
+			void report(const std::chrono::steady_clock::duration& wall, const Harness::phase_totals& phases) const;
+	};
+}
@@ -1,6 +1,7 @@
 #include "configuration.hxx"
 #include "utils/filesystem.hxx"
 #include "utils/logger.hxx"
+#include "utils/input.hxx"
 #include "definitions.h"
 
 #include <list>
@@ -49,14 +50,23 @@ const std::list<Database::Data::film::stream::codec> Frontend::Configuration::SU
 const Types::path_t Frontend::Configuration::DEFAULT_CONFIG_FILE	= "/etc/conf.d/" + std::string(PROGRAM_NAME) + ".conf";
 const unsigned int Frontend::Configuration::DEFAULT_SLEEP_TIME		= 3600;
 const unsigned int Frontend::Configuration::DEFAULT_PAUSE_TIME		= 60;
+const unsigned int Frontend::Configuration::DEFAULT_MIN_FREE_SPACE	= 1024;
+const unsigned int Frontend::Configuration::DEFAULT_PREFETCH		= 0;
+const unsigned int Frontend::Configuration::DEFAULT_PREFETCH_RATE	= 0;
+const unsigned int Frontend::Configuration::DEFAULT_STALL_TIMEOUT	= 1800;
+const unsigned int Frontend::Configuration::DEFAULT_MAX_STALLS		= 3;
+const unsigned int Frontend::Configuration::DEFAULT_SLOW_QUERY_THRESHOLD	= 500;
 const std::string Frontend::Configuration::DEFAULT_ONFINISH			= "move";
+const std::string Frontend::Configuration::DEFAULT_LOG_FORMAT		= "text";
+const std::string Frontend::Configuration::DEFAULT_CONTROL_SOCKET_EXTENSION	= ".sock";
 
 const std::list<std::string> Frontend::Configuration::MANDATORY_STRING_VALUES = { "database", "input", "output", "work", "logfile" };
 const std::list<std::string> Frontend::Configuration::MANDATORY_INT_VALUES = { "loglevel" };
-const std::list<std::string> Frontend::Configuration::OPTIONAL_STRING_VALUES = { "onfinish" };
-const std::list<std::string> Frontend::Configuration::OPTIONAL_INT_VALUES = { "sleep", "pause" };
+const std::list<std::string> Frontend::Configuration::OPTIONAL_STRING_VALUES = { "onfinish", "logformat", "controlsocket" };
+const std::list<std::string> Frontend::Configuration::OPTIONAL_INT_VALUES = { "sleep", "pause", "minfree", "prefetch", "prefetchrate", "stalltimeout", "maxstalls", "slowquery" };
+const std::list<std::string> Frontend::Configuration::OPTIONAL_GROUP_LIST_VALUES = { "storage" };
 
-Frontend::Configuration::Configuration():VideoConvert::Configuration::Base(MANDATORY_STRING_VALUES, MANDATORY_INT_VALUES, OPTIONAL_STRING_VALUES, OPTIONAL_INT_VALUES) {}
+Frontend::Configuration::Configuration():VideoConvert::Configuration::Base(MANDATORY_STRING_VALUES, MANDATORY_INT_VALUES, OPTIONAL_STRING_VALUES, OPTIONAL_INT_VALUES, OPTIONAL_GROUP_LIST_VALUES) {}
 
 bool Frontend::Configuration::check() const {
 	/* Folder checks */
@@ -90,7 +100,7 @@ bool Frontend::Configuration::check() const {
 	}
 
 	/* Optional positive integer checks */
-	for (std::string item:  { "loglevel", "sleep", "pause" }) {
+	for (std::string item:  { "loglevel", "sleep", "pause", "minfree", "prefetch", "prefetchrate", "stalltimeout", "maxstalls", "slowquery" }) {
 		if(m_values_int.contains(item)) {
 			const int value = m_values_int.at(item);
 			if (value < 0)
@@ -119,6 +129,39 @@ bool Frontend::Configuration::check() const {
 		}
 	}
 
+	if (m_values_string.contains("logformat")) {
+		if (!m_errors.contains("logformat")) {
+			const std::string value = m_values_string.at("logformat");
+			if (value != "text" && value != "json")
+				m_errors["logformat"] = "Unrecognized value " + value + "; it should be either text either json";
+		}
+	}
+
+	if (m_values_string.contains("controlsocket")) {
+		const Types::path_t file = Types::path_t(m_values_string.at("controlsocket"));
+		if (!file.has_filename())
+			m_errors["controlsocket"] = file.string() + " is not a valid socket file";
+		else if (!Utils::Filesystem::is_folder_readable_and_writable(file.parent_path()))
+			m_errors["controlsocket"] = "Directory " + file.parent_path().string() + " is not readable or not writable";
+	}
+
+	/* Storage roots check */
+	if (m_values_group_list.contains("storage") && !m_errors.contains("storage")) {
+		for (const group_t& group: m_values_group_list.at("storage")) {
+			if (!group.contains("path") || !group.contains("role"))
+				m_errors["storage"] = "Every storage root needs path and role";
+			else if (group.at("role") != "work" && group.at("role") != "output" && group.at("role") != "mirror")
+				m_errors["storage"] = "Unrecognized role " + group.at("role") + "; it should be work, output or mirror";
+			else if (!std::filesystem::is_directory(group.at("path")) || !Utils::Filesystem::is_folder_readable_and_writable(group.at("path")))
+				m_errors["storage"] = "Directory " + group.at("path") + " is not a directory or it is not readable or not writable";
+			for (std::string item: { "concurrency", "bandwidth" }) {
+				int value;
+				if (group.contains(item) && !Utils::Input::to_int_positive(group.at(item), value))
+					m_errors["storage"] = "Value " + group.at(item) + " for " + item + " is not a positive integer";
+			}
+		}
+	}
+
 	return m_errors.empty();
 }
 
@@ -138,6 +181,70 @@ unsigned int Frontend::Configuration::get_pause_time() const {
 	return m_values_int.contains("pause") ? m_values_int.at("pause") : DEFAULT_PAUSE_TIME;
 }
 
+unsigned int Frontend::Configuration::get_min_free_space() const {
+	return m_values_int.contains("minfree") ? m_values_int.at("minfree") : DEFAULT_MIN_FREE_SPACE;
+}
+
+unsigned int Frontend::Configuration::get_prefetch() const {
+	return m_values_int.contains("prefetch") ? m_values_int.at("prefetch") : DEFAULT_PREFETCH;
+}
+
+unsigned int Frontend::Configuration::get_prefetch_rate() const {
+	return m_values_int.contains("prefetchrate") ? m_values_int.at("prefetchrate") : DEFAULT_PREFETCH_RATE;
+}
+
+unsigned int Frontend::Configuration::get_stall_timeout() const {
+	return m_values_int.contains("stalltimeout") ? m_values_int.at("stalltimeout") : DEFAULT_STALL_TIMEOUT;
+}
+
+unsigned int Frontend::Configuration::get_max_stalls() const {
+	return m_values_int.contains("maxstalls") ? m_values_int.at("maxstalls") : DEFAULT_MAX_STALLS;
+}
+
+unsigned int Frontend::Configuration::get_slow_query_threshold() const {
+	return m_values_int.contains("slowquery") ? m_values_int.at("slowquery") : DEFAULT_SLOW_QUERY_THRESHOLD;
+}
+
+const std::string Frontend::Configuration::get_log_format() const {
+	return m_values_string.contains("logformat") ? m_values_string.at("logformat") : DEFAULT_LOG_FORMAT;
+}
+
+const Types::path_t Frontend::Configuration::get_control_socket() const {
+	return m_values_string.contains("controlsocket") ? Types::path_t(m_values_string.at("controlsocket")) : Types::path_t(m_values_string.at("database") + DEFAULT_CONTROL_SOCKET_EXTENSION);
+}
+
+std::list<Storage::root> Frontend::Configuration::get_storage_roots() const {
+	std::list<Storage::root> result;
+	if (m_values_group_list.contains("storage")) {
+		for (const group_t& group: m_values_group_list.at("storage")) {
+			Storage::root root;
+			root.m_path			= group.at("path");
+			if (group.at("role") == "work")
+				root.m_role		= Storage::root::WORK;
+			else if (group.at("role") == "output")
+				root.m_role		= Storage::root::OUTPUT;
+			else
+				root.m_role		= Storage::root::MIRROR;
+			root.m_device		= group.contains("device") ? group.at("device") : root.m_path.string();
+			root.m_concurrency	= group.contains("concurrency") ? std::stoul(group.at("concurrency")) : 0;
+			root.m_bandwidth	= group.contains("bandwidth") ? std::stoull(group.at("bandwidth")) * 1024 * 1024 : 0;
+			result.push_back(std::move(root));
+		}
+	}
+
+	// Main work and output folders are always roots (without limits unless they are also listed in storage)
+	for (auto main: { std::make_pair(get_work_folder(), Storage::root::WORK), std::make_pair(get_output_folder(), Storage::root::OUTPUT) }) {
+		if (main.first && std::find_if(result.begin(), result.end(), [&main](const Storage::root& root) { return root.m_path == *main.first; }) == result.end()) {
+			Storage::root root;
+			root.m_path		= *main.first;
+			root.m_role		= main.second;
+			root.m_device	= main.first->string();
+			result.push_front(std::move(root));
+		}
+	}
+	return result;
+}
+
 const std::string Frontend::Configuration::get_onfinish() const {
 	return m_values_string.contains("onfinish") ? m_values_string.at("onfinish") : DEFAULT_ONFINISH;
 }
@@ -2,6 +2,7 @@
 
 #include "configuration/base.hxx"
 #include "database/data.hxx"
+#include "storage/pool.hxx"
 #include <algorithm>
 
 namespace StormByte::VideoConvert::Frontend {
@@ -29,10 +30,24 @@ namespace StormByte::VideoConvert::Frontend {
 			const std::optional<unsigned int> get_log_level() const;
 			unsigned int get_sleep_time() const;
 			unsigned int get_pause_time() const;
+			unsigned int get_min_free_space() const; // In MiB
+			unsigned int get_prefetch() const; // Number of films
+			unsigned int get_prefetch_rate() const; // In MiB/s
+			unsigned int get_stall_timeout() const; // In seconds, 0 disables the watchdog
+			unsigned int get_max_stalls() const; // Stalls before film is marked as unsupported
+			unsigned int get_slow_query_threshold() const; // In milliseconds, 0 disables the slow query log
 			const std::string get_onfinish() const;
+			const std::string get_log_format() const;
+			/* Unix socket used by daemon to serve control requests (next to database by default) */
+			const Types::path_t get_control_socket() const;
+			/* Main work and output folders plus the additional ones from storage */
+			std::list<Storage::root> get_storage_roots() const;
 
 			/* Action getters */
 			inline const Types::optional_path_t get_interactive_parameter() const					{ return get_optional_path("interactive_parameter"); }
+			inline const Types::optional_path_t get_manifest_parameter() const						{ return get_optional_path("manifest_parameter"); }
+			inline const Types::optional_path_t get_sweep_parameter() const							{ return get_optional_path("sweep_parameter"); }
+			inline bool get_rescan() const															{ return m_values_int.contains("rescan_parameter"); }
 
 			/* Setters */
 			inline void set_database_file(const Types::path_t& dbfile)								{ set_string_value("database", dbfile); }
@@ -50,26 +65,37 @@ namespace StormByte::VideoConvert::Frontend {
 			inline void set_log_level(const unsigned int& loglevel)									{ set_int_value("loglevel", loglevel); }
 			inline void set_sleep_time(const unsigned int& sleep_time)								{ set_int_value("sleep", sleep_time); }
 			inline void set_pause_time(const unsigned int& pause_time)								{ set_int_value("pause", pause_time); }
+			inline void set_min_free_space(const unsigned int& min_free)							{ set_int_value("minfree", min_free); }
+			inline void set_prefetch(const unsigned int& prefetch)									{ set_int_value("prefetch", prefetch); }
+			inline void set_prefetch_rate(const unsigned int& prefetch_rate)						{ set_int_value("prefetchrate", prefetch_rate); }
+			inline void set_stall_timeout(const unsigned int& stall_timeout)						{ set_int_value("stalltimeout", stall_timeout); }
+			inline void set_max_stalls(const unsigned int& max_stalls)								{ set_int_value("maxstalls", max_stalls); }
+			inline void set_slow_query_threshold(const unsigned int& slow_query)					{ set_int_value("slowquery", slow_query); }
 			inline void set_onfinish(const std::string& onfinish)									{ set_string_value("onfinish", onfinish); }
 			inline void set_onfinish(std::string&& onfinish)										{ set_string_value("onfinish", std::move(onfinish)); }
+			inline void set_log_format(const std::string& log_format)								{ set_string_value("logformat", log_format); }
+			inline void set_control_socket(const Types::path_t& socket_file)						{ set_string_value("controlsocket", socket_file); }
 
 			/* Action setters */
 			inline void set_interactive_parameter(const Types::path_t& file_or_folder)				{ set_string_value("interactive_parameter", file_or_folder); }
 			inline void set_interactive_parameter(const Types::path_t&& file_or_folder)				{ set_string_value("interactive_parameter", std::move(file_or_folder)); }
+			inline void set_manifest_parameter(const Types::path_t& file)							{ set_string_value("manifest_parameter", file); }
+			inline void set_sweep_parameter(const Types::path_t& folder)							{ set_string_value("sweep_parameter", folder); }
+			inline void set_rescan()																{ set_int_value("rescan_parameter", 1); }
 
 			/* Functions */
 			bool check() const override;
 
 			/* Constants */
 			static const Types::path_t DEFAULT_CONFIG_FILE;
-			static const unsigned int DEFAULT_SLEEP_TIME, DEFAULT_PAUSE_TIME;
-			static const std::string DEFAULT_ONFINISH;
+			static const unsigned int DEFAULT_SLEEP_TIME, DEFAULT_PAUSE_TIME, DEFAULT_MIN_FREE_SPACE, DEFAULT_PREFETCH, DEFAULT_PREFETCH_RATE, DEFAULT_STALL_TIMEOUT, DEFAULT_MAX_STALLS, DEFAULT_SLOW_QUERY_THRESHOLD;
+			static const std::string DEFAULT_ONFINISH, DEFAULT_LOG_FORMAT, DEFAULT_CONTROL_SOCKET_EXTENSION;
 
 		private:
 			inline const Types::optional_path_t get_optional_path(const std::string& key) const		{ return m_values_string.contains(key) ? Types::optional_path_t(m_values_string.at(key)) : Types::optional_path_t(); }
 
 			static const std::list<Database::Data::film::stream::codec> SUPPORTED_CODECS;
 			static const std::list<std::string> SUPPORTED_MULTIMEDIA_EXTENSIONS;
-			static const std::list<std::string> MANDATORY_STRING_VALUES, MANDATORY_INT_VALUES, OPTIONAL_STRING_VALUES, OPTIONAL_INT_VALUES;
+			static const std::list<std::string> MANDATORY_STRING_VALUES, MANDATORY_INT_VALUES, OPTIONAL_STRING_VALUES, OPTIONAL_INT_VALUES, OPTIONAL_GROUP_LIST_VALUES;
 	};
 }
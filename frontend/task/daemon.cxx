@@ -2,6 +2,11 @@
 #include "definitions.h"
 #include "configuration/configuration.hxx"
 #include "task/execute/ffmpeg/convert.hxx"
+#include "ffprobe/ffprobe.hxx"
+#include "utils/display.hxx"
+#include "utils/system.hxx"
+#include "utils/filesystem.hxx"
+#include "control/client.hxx"
 
 using namespace StormByte::VideoConvert;
 
@@ -11,8 +16,19 @@ Task::STATUS Frontend::Task::Daemon::pre_run_actions() noexcept {
 	assert(m_config);
 	try {
 		const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
-		m_logger.reset(new Utils::Logger(*config->get_log_file(), static_cast<Utils::Logger::LEVEL>(*config->get_log_level())));
-		m_database.reset(new Database::SQLite3(*config->get_database_file(), m_logger));
+		// Only one daemon can be the database writer
+		if (Control::Client(config->get_control_socket()).connect())
+			throw std::runtime_error("Another daemon is already listening on " + config->get_control_socket().string());
+		m_logger.reset(new Utils::Logger(*config->get_log_file(), static_cast<Utils::Logger::LEVEL>(*config->get_log_level()), config->get_log_format() == "json" ? Utils::Logger::FORMAT_JSON : Utils::Logger::FORMAT_TEXT));
+		// Shared by every connection of daemon so status shows all of them
+		m_profiler.reset(new Database::Profiler(std::chrono::milliseconds(config->get_slow_query_threshold()), m_logger));
+		m_database.reset(new Database::SQLite3(*config->get_database_file(), m_logger, m_profiler));
+		m_storage.reset(new Storage::Pool(config->get_storage_roots()));
+		m_finalizer.reset(new Finalizer(*config->get_database_file(), *config->get_input_folder(), m_storage, m_logger, m_profiler));
+		if (config->get_prefetch() > 0)
+			m_prefetcher.reset(new Prefetcher(*config->get_input_folder(), m_storage, static_cast<uintmax_t>(config->get_prefetch_rate()) * 1024 * 1024, [this](const Types::path_t& folder, const uintmax_t& needed) { return has_enough_space(folder, needed); }, m_logger));
+		m_control.reset(new Control::Server(config->get_control_socket(), *config->get_database_file(), m_logger, m_profiler));
+		m_hostname = Utils::System::get_hostname();
 	}
 	catch (const std::exception& e) {
 		std::cerr << red(e.what()) << std::endl;
@@ -23,109 +39,346 @@ Task::STATUS Frontend::Task::Daemon::pre_run_actions() noexcept {
 }
 
 Task::STATUS Frontend::Task::Daemon::post_run_actions(const VideoConvert::Task::STATUS& status) noexcept {
-	m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Daemon ran during " + elapsed_time_string() + " and was stopped gracefully");
+	m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Daemon ran during ", elapsed_time_string(), " and was stopped gracefully");
 
 	return VideoConvert::Task::CLI::Base::post_run_actions(status);
 }
 
 Task::STATUS Frontend::Task::Daemon::do_work(std::optional<pid_t>& worker) noexcept {
 	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
-	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Starting daemon version " + std::string(PROGRAM_VERSION));
+	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Starting daemon version ", PROGRAM_VERSION);
 	m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Resetting previously in process films");
 	m_database->reset_processing_films();
+	try {
+		m_control->start();
+	}
+	catch (const std::exception& e) {
+		m_logger->message_line(Utils::Logger::LEVEL_FATAL, e.what());
+		return VideoConvert::Task::HALT_ERROR;
+	}
+	m_finalizer->start();
+	if (m_prefetcher) m_prefetcher->start();
 
+	// Films which did not fit in free resources during this pass so the next ones in queue are tried meanwhile
+	std::set<unsigned int> deferred;
 	do {
+		if (m_control->is_paused()) {
+			// Resume request wakes us up
+			m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Queue is paused, sleeping ", config->get_sleep_time(), " seconds");
+			sleep(config->get_sleep_time());
+			continue;
+		}
 		m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Checking for films to convert...");
-		auto film = m_database->get_film_for_process();
+		auto phase_start = std::chrono::steady_clock::now();
+		Utils::Display::timings timings;
+		auto film = m_database->get_film_for_process(deferred);
 		if (film) {
-			m_logger->message_line(Utils::Logger::LEVEL_INFO, "Film " + film->get_input_file().string() + " found");
-			auto convert_status = execute_ffmpeg(std::move(*film), worker);
+			Utils::Display::add_timing(timings, "claim", phase_start);
+			m_logger->message_line(Utils::Logger::LEVEL_INFO, "Film ", film->get_input_file(), " found");
+			const Types::path_t full_input_file = *config->get_input_folder() / film->get_input_file();
+			probe_film_data(*film, full_input_file);
+			Utils::Display::add_timing(timings, "probe", phase_start);
+			if (!fits_in_memory(*film)) {
+				m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Film ", film->get_input_file(), " can not be converted in this host, marking it as unsupported");
+				m_database->finish_film_process(*film, false);
+				continue;
+			}
+			auto roots = select_storage(*film, full_input_file);
+			if (!roots || !has_enough_memory(*film)) {
+				// Film is not failed, it is just returned to queue until there is room for it
+				m_logger->message_line(Utils::Logger::LEVEL_WARNING, "Not enough free resources to convert ", film->get_input_file(), ", deferring it and trying next film");
+				m_database->release_film_process(*film);
+				deferred.insert(film->get_film_id());
+				continue;
+			}
+			display_queue_forecast();
+			Types::path_t source_file = full_input_file;
+			if (m_prefetcher) {
+				auto staged = m_prefetcher->take(film->get_film_id());
+				if (staged) {
+					m_logger->message_line(Utils::Logger::LEVEL_INFO, "Using staged copy ", *staged);
+					source_file = *staged;
+				}
+				// Current film is already marked as processing so these are the next ones, its output is still to be written
+				m_prefetcher->prefetch(m_database->get_next_films(config->get_prefetch()), estimate_output_size(*film, full_input_file));
+			}
+			Utils::Display::add_timing(timings, "schedule", phase_start);
+			m_control->set_current(film->get_film_id(), film->get_input_file());
+			const Types::path_t input_file = film->get_input_file();
+			auto convert_status = execute_ffmpeg(std::move(*film), source_file, *roots, worker, timings);
+			m_control->clear_current();
+			// Resources changed so deferred films get their chance again, in queue order
+			deferred.clear();
+			m_logger->message_line(Utils::Logger::LEVEL_INFO, "Timings for ", input_file, " (ms): ", Utils::Display::timings_to_string(timings));
 			// Only sleep if process is to be continued (not killed by a signal)
 			if (m_status != VideoConvert::Task::HALT_ERROR && convert_status != VideoConvert::Task::HALT_ERROR) {
-				m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Pausing for " + std::to_string(config->get_pause_time()) + " seconds");
+				m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Pausing for ", config->get_pause_time(), " seconds");
 				sleep(config->get_pause_time());
 			}
 		}
 		else {
-			m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "No films found");
-			m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Sleeping " + std::to_string(config->get_sleep_time()) + " seconds before retrying");
+			if (deferred.empty())
+				m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "No films found");
+			else
+				m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "None of the ", deferred.size(), " queued film(s) fit in free resources");
+			m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Sleeping ", config->get_sleep_time(), " seconds before retrying");
 			sleep(config->get_sleep_time());
+			deferred.clear();
 		}
 	} while(m_status != VideoConvert::Task::HALTED);
 
 	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Stopping daemon...");
+	m_control->stop();
+	if (m_prefetcher) m_prefetcher->stop();
+	m_finalizer->stop();
 	
 	return VideoConvert::Task::HALT_OK;
 }
 
-StormByte::VideoConvert::Task::STATUS Frontend::Task::Daemon::execute_ffmpeg(FFmpeg&& ffmpeg, std::optional<pid_t>& worker) const {
+StormByte::VideoConvert::Task::STATUS Frontend::Task::Daemon::execute_ffmpeg(FFmpeg&& ffmpeg, const Types::path_t& source_file, const std::pair<Storage::root, Storage::root>& roots, std::optional<pid_t>& worker, Utils::Display::timings& timings) const {
 	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	auto phase_start = std::chrono::steady_clock::now();
 	const Types::path_t full_input_file = *config->get_input_folder() / ffmpeg.get_input_file();
-	const Types::path_t full_work_file = *config->get_work_folder() / ffmpeg.get_output_file(); // For FFmpeg out means what for Application is work
-	const Types::path_t full_output_file = *config->get_output_folder() / ffmpeg.get_output_file();
+	const Types::path_t full_output_file = roots.second.m_path / ffmpeg.get_output_file();
+	// When work and output share filesystem we encode directly to a hidden file in output so finalization is just an atomic rename
+	const bool publish_in_place = Utils::Filesystem::is_same_filesystem(roots.first.m_path, roots.second.m_path);
+	const Types::path_t full_work_file = publish_in_place ?
+		full_output_file.parent_path() / ("." + full_output_file.filename().string()) :
+		roots.first.m_path / ffmpeg.get_output_file(); // For FFmpeg out means what for Application is work
+	m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Using work root ", roots.first.m_path, " and output root ", roots.second.m_path);
 
 	// We need to be sure that the output folder exists so we try to create before running in that case
 	if (!std::filesystem::exists(full_work_file.parent_path())) {
-		m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Create work path: " + full_work_file.parent_path().string());
+		m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Create work path: ", full_work_file.parent_path());
 		std::filesystem::create_directories(full_work_file.parent_path());
 	}
-	VideoConvert::Task::Execute::FFmpeg::Convert task_ffmpeg = VideoConvert::Task::Execute::FFmpeg::Convert(std::move(ffmpeg), *config->get_input_folder(), *config->get_work_folder());
+	auto estimation = m_database->estimate_encode_time(ffmpeg, m_hostname);
+	if (estimation)
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Estimated conversion time for ", ffmpeg.get_input_file(), ": ", Utils::Display::duration_to_string(std::chrono::seconds(static_cast<long>(*estimation))));
+
+	VideoConvert::Task::Execute::FFmpeg::Convert task_ffmpeg = VideoConvert::Task::Execute::FFmpeg::Convert(ffmpeg, source_file, full_work_file);
 	task_ffmpeg.set_logger(m_logger);
-	VideoConvert::Task::STATUS convert_status = task_ffmpeg.run(worker);
-	bool io_failed = false;
-	
+	task_ffmpeg.set_stall_timeout(std::chrono::seconds(config->get_stall_timeout()));
+	// Control server thread cancels it, so it gets the pid through its own lock
+	task_ffmpeg.set_worker_callback([this](const std::optional<pid_t>& pid) { m_control->set_worker(pid); });
+	VideoConvert::Task::STATUS convert_status;
+	{
+		// Work device is busy while encoding so finalizations to/from it are throttled by its concurrency
+		Storage::Pool::Lease lease = m_storage->acquire({ full_work_file });
+		Utils::Display::add_timing(timings, "prepare", phase_start);
+		convert_status = task_ffmpeg.run(worker);
+		Utils::Display::add_timing(timings, "encode", phase_start);
+	}
+	log_resource_usage(ffmpeg, task_ffmpeg);
+	if (source_file != full_input_file) {
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Deleting staged copy ", source_file);
+		std::filesystem::remove(source_file);
+	}
+
 	if (convert_status == VideoConvert::Task::HALT_OK) {
-		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Conversion for " + ffmpeg.get_input_file().string() + " finished in " + task_ffmpeg.elapsed_time_string());
-		if (!std::filesystem::exists(full_output_file.parent_path())) {
-			m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Create output path: " + full_output_file.parent_path().string());
-			std::filesystem::create_directories(full_output_file.parent_path());
-		}
-		if (config->get_onfinish() == "move") {
-			try {
-				m_logger->message_line(Utils::Logger::LEVEL_INFO, "Move: " + full_work_file.string() + " -> " + full_output_file.string());
-				std::filesystem::rename(full_work_file, full_output_file);
-				io_failed = false;
-			}
-			catch (const std::exception& e) {
-				m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Move failed because " + std::string(e.what()) + " attempting copy");
-				io_failed = true;
-			}
-		}
-		if (io_failed || config->get_onfinish() == "copy") {
-			try {
-				m_logger->message_line(Utils::Logger::LEVEL_INFO, "Copy: " + full_work_file.string() + " -> " + full_output_file.string());
-				std::filesystem::copy_file(full_work_file, full_output_file);
-				m_logger->message_line(Utils::Logger::LEVEL_INFO, "Delete work: " + full_work_file.string());
-				std::filesystem::remove(full_work_file);
-				io_failed = false;
-			}
-			catch (const std::exception& e) {
-				m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Copy failed because " + std::string(e.what()));
-				io_failed = true;
-			}
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Conversion for ", ffmpeg.get_input_file(), " finished in ", task_ffmpeg.elapsed_time_string());
+		save_encode_history(ffmpeg, task_ffmpeg);
+
+		// Film remains as processing until finalizer moves/copies it to output in background
+		Database::Data::finalization finalization;
+		finalization.m_film_id		= ffmpeg.get_film_id();
+		finalization.m_input_file	= full_input_file;
+		finalization.m_work_file	= full_work_file;
+		finalization.m_output_file	= full_output_file;
+		if (publish_in_place)
+			finalization.m_action	= Database::Data::finalization::PUBLISH; // Copy would be pointless as work file is deleted afterwards
+		else
+			finalization.m_action	= config->get_onfinish() == "copy" ? Database::Data::finalization::COPY : Database::Data::finalization::MOVE;
+		finalization.m_group		= ffmpeg.get_group();
+		finalization.m_id			= m_database->insert_finalization(finalization);
+		if (finalization.m_id) {
+			m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Queueing finalization for ", full_work_file);
+			m_finalizer->enqueue(finalization);
 		}
-		if (!io_failed) {
-			m_logger->message_line(Utils::Logger::LEVEL_INFO, "Delete input: " + full_input_file.string());
-			std::filesystem::remove(full_input_file);
+		else {
+			m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Could not queue finalization for ", full_work_file, ", marking film as unsupported");
+			m_database->finish_film_process(ffmpeg, false);
 		}
 	}
+	else if (m_control->take_cancelled(ffmpeg.get_film_id())) {
+		m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Conversion for ", ffmpeg.get_input_file(), " was cancelled, removing it from queue");
+		std::filesystem::remove(full_work_file);
+		m_database->release_film_process(ffmpeg);
+		m_database->delete_queued_film(ffmpeg.get_film_id());
+	}
 	else {
-		m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Conversion for " + ffmpeg.get_input_file().string() + " failed or interrupted!");
+		if (task_ffmpeg.is_stalled())
+			m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Conversion for ", ffmpeg.get_input_file(), " stalled for ", config->get_stall_timeout(), " seconds and was stopped!");
+		else
+			m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Conversion for ", ffmpeg.get_input_file(), " failed or interrupted!");
 		if (!task_ffmpeg.get_stderr().empty())
-			m_logger->message_line(Utils::Logger::LEVEL_ERROR, "stderr contains:\n" + task_ffmpeg.get_stderr());
-		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Deleting work file: " + full_work_file.string());
+			m_logger->message_line(Utils::Logger::LEVEL_ERROR, "stderr contains:\n", task_ffmpeg.get_stderr());
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Deleting work file: ", full_work_file);
 		std::filesystem::remove(full_work_file);
-		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Marking film " + full_work_file.string() + " as unsupported in database");
+		if (task_ffmpeg.is_stalled()) {
+			// Usually a hung share or device which recovers, so film is only given up after several stalls
+			auto retry = m_database->retry_stalled_film(ffmpeg, config->get_max_stalls(), std::chrono::seconds(config->get_stall_timeout()));
+			if (retry)
+				m_logger->message_line(Utils::Logger::LEVEL_WARNING, "Film ", ffmpeg.get_input_file(), " will be retried in ", Utils::Display::duration_to_string(*retry));
+			else
+				m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Film ", ffmpeg.get_input_file(), " stalled too many times, marking it as unsupported");
+		}
+		else {
+			m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Marking film ", full_work_file, " as unsupported in database");
+			m_database->finish_film_process(ffmpeg, false);
+		}
 	}
+	Utils::Display::add_timing(timings, "record", phase_start);
+
+	return convert_status;
+}
 
-	m_database->finish_film_process(ffmpeg, !io_failed && convert_status == VideoConvert::Task::HALT_OK);
-	if (ffmpeg.get_group() && m_database->is_group_empty(*ffmpeg.get_group())) {
-		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Deleting group input folder: " + (*config->get_input_folder() / ffmpeg.get_group()->folder).string() + " recursivelly");
-		std::filesystem::remove_all(*config->get_input_folder() / ffmpeg.get_group()->folder);
-		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Deleting group work folder: " + (*config->get_work_folder() / ffmpeg.get_group()->folder).string() + " recursivelly");
-		std::filesystem::remove_all(*config->get_work_folder() / ffmpeg.get_group()->folder);
-		m_database->delete_group(*ffmpeg.get_group());
+void Frontend::Task::Daemon::probe_film_data(FFmpeg& ffmpeg, const Types::path_t& full_input_file) const {
+	// Films added in groups are not probed when inserted so we do it here to have their encode history
+	if (!ffmpeg.get_duration() || !ffmpeg.get_resolution()) {
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Probing duration and resolution for ", full_input_file);
+		FFprobe probe = FFprobe::resolution_from_file(full_input_file);
+		if (probe.get_duration())
+			ffmpeg.set_duration(*probe.get_duration());
+		if (probe.get_resolution())
+			ffmpeg.set_resolution(*probe.get_resolution());
+		if (probe.get_frame_rate())
+			ffmpeg.set_frame_rate(*probe.get_frame_rate());
 	}
+}
 
-	return convert_status;
+std::optional<std::pair<Storage::root, Storage::root>> Frontend::Task::Daemon::select_storage(const FFmpeg& ffmpeg, const Types::path_t& full_input_file) const {
+	const uintmax_t estimated = estimate_output_size(ffmpeg, full_input_file);
+	// Finalizations still pending will also write into output roots
+	const uintmax_t reserved = m_finalizer->get_reserved_output_space();
+	m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Estimated output size for ", ffmpeg.get_input_file(), ": ", estimated, " bytes, pending finalizations: ", reserved, " bytes");
+
+	std::optional<std::pair<Storage::root, Storage::root>> result;
+	auto output = m_storage->select(Storage::root::OUTPUT, [&](const Storage::root& root) {
+		return has_enough_space(root.m_path, estimated + reserved);
+	});
+	if (output) {
+		// A work root sharing filesystem with output will not be used as file is encoded directly into output
+		auto work = m_storage->select(Storage::root::WORK, [&](const Storage::root& root) {
+			return Utils::Filesystem::is_same_filesystem(root.m_path, output->m_path) || has_enough_space(root.m_path, estimated);
+		});
+		if (work)
+			result = std::make_pair(*work, *output);
+	}
+	return result;
+}
+
+uintmax_t Frontend::Task::Daemon::estimate_output_size(const FFmpeg& ffmpeg, const Types::path_t& full_input_file) const {
+	std::error_code error;
+	const uintmax_t input_size = std::filesystem::file_size(full_input_file, error);
+	// Let FFmpeg report the problem with input if size can not be read
+	return error ? 0 : ffmpeg.estimate_output_size(input_size);
+}
+
+bool Frontend::Task::Daemon::has_enough_space(const Types::path_t& folder, const uintmax_t& needed) const {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	const uintmax_t min_free = static_cast<uintmax_t>(config->get_min_free_space()) * 1024 * 1024;
+	auto free_space = Utils::Filesystem::get_free_space(folder);
+	if (!free_space) {
+		m_logger->message_line(Utils::Logger::LEVEL_WARNING, "Could not get free space for ", folder);
+		return true;
+	}
+
+	const bool result = *free_space >= min_free && *free_space - min_free >= needed;
+	if (!result)
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, folder, " has ", *free_space / (1024 * 1024), " MiB free but ", needed / (1024 * 1024) + config->get_min_free_space(), " MiB are needed");
+	return result;
+}
+
+std::optional<uintmax_t> Frontend::Task::Daemon::estimate_memory_usage(const FFmpeg& ffmpeg) const {
+	// Measured peaks from previous encodes are preferred over the generic guess
+	std::optional<uintmax_t> result = m_database->get_peak_memory(ffmpeg);
+	if (!result) result = ffmpeg.estimate_memory_usage();
+	return result;
+}
+
+bool Frontend::Task::Daemon::has_enough_memory(const FFmpeg& ffmpeg) const {
+	std::optional<uintmax_t> needed = estimate_memory_usage(ffmpeg);
+	auto available = Utils::System::get_available_memory();
+	if (!needed || !available) {
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Could not estimate memory usage for ", ffmpeg.get_input_file());
+		return true;
+	}
+	// A guess above what host has would defer film forever, so it is tried once and its real peak gets recorded
+	auto total = Utils::System::get_total_memory();
+	if (total && *needed > *total && !m_database->get_peak_memory(ffmpeg)) {
+		m_logger->message_line(Utils::Logger::LEVEL_WARNING, "Guessed memory usage for ", ffmpeg.get_input_file(), " (", *needed / (1024 * 1024), " MiB) exceeds host memory, trying it to measure real usage");
+		return true;
+	}
+
+	m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Estimated memory usage for ", ffmpeg.get_input_file(), ": ", *needed / (1024 * 1024), " MiB, available: ", *available / (1024 * 1024), " MiB");
+	const bool result = *available >= *needed;
+	if (!result)
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Conversion needs ", *needed / (1024 * 1024), " MiB of memory but only ", *available / (1024 * 1024), " MiB are available");
+	return result;
+}
+
+bool Frontend::Task::Daemon::fits_in_memory(const FFmpeg& ffmpeg) const {
+	// Generic guess is not enough to give up on a film, only measured peaks are
+	std::optional<uintmax_t> needed = m_database->get_peak_memory(ffmpeg);
+	auto total = Utils::System::get_total_memory();
+	if (!needed || !total) return true;
+
+	const bool result = *total >= *needed;
+	if (!result)
+		m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Conversions like ", ffmpeg.get_input_file(), " peaked at ", *needed / (1024 * 1024), " MiB of memory but this host is limited to ", *total / (1024 * 1024), " MiB (physical memory or cgroup memory.max)");
+	return result;
+}
+
+void Frontend::Task::Daemon::save_encode_history(const FFmpeg& ffmpeg, const VideoConvert::Task::Execute::Base& task) const {
+	const double elapsed_seconds = std::chrono::duration<double>(task.elapsed_time()).count();
+	auto codec = ffmpeg.get_video_codec();
+
+	if (!codec || !ffmpeg.get_duration() || !ffmpeg.get_resolution() || elapsed_seconds <= 0) {
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Not enough data to store encode history for ", ffmpeg.get_input_file());
+		return;
+	}
+
+	Database::Data::encode_history history;
+	history.m_codec			= *codec;
+	history.m_resolution	= *ffmpeg.get_resolution();
+	history.m_is_HDR		= ffmpeg.is_HDR();
+	history.m_is_animation	= ffmpeg.is_animation();
+	history.m_host			= m_hostname;
+	history.m_duration		= *ffmpeg.get_duration();
+	history.m_elapsed		= elapsed_seconds;
+	if (ffmpeg.get_frame_rate())
+		history.m_frames	= *ffmpeg.get_duration() * *ffmpeg.get_frame_rate();
+	history.m_peak_memory	= task.get_peak_memory();
+	history.m_file			= ffmpeg.get_input_file();
+	if (auto usage = task.get_resource_usage()) {
+		history.m_user_time		= usage->m_user_time;
+		history.m_system_time	= usage->m_system_time;
+		history.m_read_bytes	= usage->m_read_bytes;
+		history.m_write_bytes	= usage->m_write_bytes;
+	}
+
+	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Encode speed: ", history.m_duration / elapsed_seconds, "x realtime", (history.m_frames ? " (" + std::to_string(*history.m_frames / elapsed_seconds) + " fps)" : ""));
+	m_database->insert_encode_history(history);
+}
+
+void Frontend::Task::Daemon::log_resource_usage(const FFmpeg& ffmpeg, const VideoConvert::Task::Execute::Base& task) const {
+	auto usage = task.get_resource_usage();
+	if (!usage) return;
+
+	// Busy cores well below encoder threads means it was waiting for I/O
+	const double elapsed_seconds = std::chrono::duration<double>(task.elapsed_time()).count();
+	const double cores = elapsed_seconds > 0 ? (usage->m_user_time + usage->m_system_time) / elapsed_seconds : 0;
+	std::string io = "not available";
+	if (usage->m_read_bytes && usage->m_write_bytes)
+		io = std::to_string(*usage->m_read_bytes / (1024 * 1024)) + " MiB read, " + std::to_string(*usage->m_write_bytes / (1024 * 1024)) + " MiB written";
+	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Resources used by ", ffmpeg.get_input_file(), ": CPU ", usage->m_user_time, "s user, ", usage->m_system_time, "s system (", cores, " cores busy), peak RSS ", usage->m_max_rss / (1024 * 1024), " MiB, I/O ", io);
+}
+
+void Frontend::Task::Daemon::display_queue_forecast() const {
+	Database::Data::queue_forecast forecast = m_database->get_queue_forecast(m_hostname);
+	std::string message = "Queue forecast: " + std::to_string(forecast.m_estimated) + " film(s) estimated to finish in " + Utils::Display::duration_to_string(std::chrono::seconds(static_cast<long>(forecast.m_seconds)));
+	if (forecast.m_unknown > 0)
+		message += " plus " + std::to_string(forecast.m_unknown) + " film(s) without estimation";
+	m_logger->message_line(Utils::Logger::LEVEL_INFO, message);
 }
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "task/cli/base.hxx"
+#include "task/execute/base.hxx"
 #include "configuration/base.hxx"
 #include "utils/logger.hxx"
 #include "database/sqlite3.hxx"
 #include "ffmpeg/ffmpeg.hxx"
+#include "finalizer/finalizer.hxx"
+#include "prefetcher/prefetcher.hxx"
+#include "control/server.hxx"
+#include "utils/display.hxx"
 
 namespace StormByte::VideoConvert::Frontend::Task {
 	class Daemon: public VideoConvert::Task::CLI::Base {
@@ -20,9 +25,31 @@ namespace StormByte::VideoConvert::Frontend::Task {
 			VideoConvert::Task::STATUS pre_run_actions() noexcept override;
 			VideoConvert::Task::STATUS post_run_actions(const VideoConvert::Task::STATUS&) noexcept override;
 			VideoConvert::Task::STATUS do_work(std::optional<pid_t>&) noexcept override;
-			VideoConvert::Task::STATUS execute_ffmpeg(FFmpeg&& ffmpeg, std::optional<pid_t>&) const;
+			/* Appends prepare, encode and record phases to timings */
+			VideoConvert::Task::STATUS execute_ffmpeg(FFmpeg&& ffmpeg, const Types::path_t& source_file, const std::pair<Storage::root, Storage::root>& roots, std::optional<pid_t>&, Utils::Display::timings& timings) const;
+			void probe_film_data(FFmpeg& ffmpeg, const Types::path_t& full_input_file) const;
+			/* Work and output roots with enough free space for film, if any */
+			std::optional<std::pair<Storage::root, Storage::root>> select_storage(const FFmpeg& ffmpeg, const Types::path_t& full_input_file) const;
+			uintmax_t estimate_output_size(const FFmpeg& ffmpeg, const Types::path_t& full_input_file) const;
+			/* Keeping minfree, also used to admit staged files */
+			bool has_enough_space(const Types::path_t& folder, const uintmax_t& needed) const;
+			/* Measured peak of recent encodes with same profile or a generic guess */
+			std::optional<uintmax_t> estimate_memory_usage(const FFmpeg& ffmpeg) const;
+			bool has_enough_memory(const FFmpeg& ffmpeg) const;
+			/* False when recent encodes of same profile peaked above what this host can ever give */
+			bool fits_in_memory(const FFmpeg& ffmpeg) const;
+			/* Encode time and resources used are taken from task */
+			void save_encode_history(const FFmpeg& ffmpeg, const VideoConvert::Task::Execute::Base& task) const;
+			void log_resource_usage(const FFmpeg& ffmpeg, const VideoConvert::Task::Execute::Base& task) const;
+			void display_queue_forecast() const;
 
 			Types::logger_t m_logger;
+			Types::profiler_t m_profiler;
 			Types::database_t m_database;
+			Types::storage_pool_t m_storage;
+			Types::finalizer_t m_finalizer;
+			Types::prefetcher_t m_prefetcher; // Only when prefetch is enabled
+			Types::control_server_t m_control;
+			std::string m_hostname;
 	};
 }
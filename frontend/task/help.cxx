@@ -14,10 +14,15 @@ void Frontend::Task::Help::header() const {
 
 void Frontend::Task::Help::usage() const {
 	std::cout << green("This is the list of available options:") << std::endl;
-	std::cout << magenta("\t-t, --test\t\t") << light_green("Test if program can be run without any other action") << std::endl;
+	std::cout << magenta("\t-t, --test\t\t") << light_green("Test if program can be run and its content hashing matches reference values") << std::endl;
 	std::cout << magenta("\t-d, --daemon\t\t") << light_green("Run daemon reading database items to keep converting files") << std::endl;
 	std::cout << magenta("\t-c, --config <file>\t") << light_green("Specifies a config file instead of the default ") << light_blue(Configuration::DEFAULT_CONFIG_FILE) << std::endl;
 	std::cout << magenta("\t-a, --add <file>\t") << light_green("Interactivelly add a new film to database files") << std::endl;
+	std::cout << magenta("\t-r, --rescan\t\t") << light_green("Used with --add, also add files not changed since folder was last added") << std::endl;
+	std::cout << magenta("\t-am,--add-manifest <file>") << light_green("Add every film listed in a JSON lines or CSV manifest without asking ") << gray("(use - to read it from standard input)") << std::endl;
+	std::cout << magenta("\t-sw,--sweep <folder>\t") << light_green("Queue films in folder worth converting to HEVC, most storage saved per encode hour first") << std::endl;
+	std::cout << magenta("\t-ctl,--control <cmd>\t") << light_green("Send a command to the running daemon: ") << light_blue("status") << gray(", ") << light_blue("pause") << gray(", ") << light_blue("resume") << gray(", ") << light_blue("cancel <film id>") << gray(" or ") << light_blue("priority <film id> <priority>") << std::endl;
+	std::cout << magenta("\t-cs,--controlsocket <file>") << light_green("Specify the unix socket used to talk with the daemon") << std::endl;
 	std::cout << magenta("\t-db,--database <file>\t") << light_green("Specify SQLite database file to be used") << std::endl;
 	std::cout << magenta("\t-i, --input <folder>\t") << light_green("Specify input folder to read films from") << std::endl;
 	std::cout << magenta("\t-o, --output <folder>\t") << light_green("Specify output folder to store converted files once finished") << std::endl;
@@ -25,6 +30,7 @@ void Frontend::Task::Help::usage() const {
 	std::cout << magenta("\t-l, --logfile <file>\t") << light_green("Specify a file for storing logs") << std::endl;
 	std::cout << magenta("\t-ll,--loglevel <level>\t") << light_green("Specify which loglevel to display ") << gray("(Should be between 0 and " + std::to_string(Utils::Logger::Logger::LEVEL_MAX - 1) + ")") << std::endl; 
 	std::cout << magenta("\t-s, --sleep <seconds>\t") << light_green("Specify the time to sleep in main loop. ") << gray("(It should be positive integer ") << underlined(faint("unless you are my boyfriend and have that ability")) << gray(")") << std::endl;
+	std::cout << magenta("\t-mf,--minfree <MiB>\t") << light_green("Specify the free space to keep in work and output folders when starting a conversion") << std::endl;
 	std::cout << magenta("\t-of,--onfinish <action>\t") << light_green("Specify action to take once film is converted. ") << gray("Accepted values are ") << light_blue("copy") << gray(" and ") << light_blue("move") << std::endl;
 	std::cout << magenta("\t-v, --version\t\t") << light_green("Show version and compile information") << std::endl;
 	std::cout << magenta("\t-h, --help\t\t") << light_red("Show this message") << std::endl;
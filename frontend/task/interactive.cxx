@@ -2,9 +2,16 @@
 #include "configuration/configuration.hxx"
 #include "utils/input.hxx"
 #include "utils/display.hxx"
+#include "utils/system.hxx"
+#include "utils/walker.hxx"
+#include "utils/filesystem.hxx"
 #include "help.hxx"
+#include "control/protocol.hxx"
 
 #include <csignal>
+#include <thread>
+#include <atomic>
+#include <future>
 #include <boost/algorithm/string.hpp> // For string lowercase
 
 using namespace StormByte::VideoConvert;
@@ -25,6 +32,9 @@ Task::STATUS Frontend::Task::Interactive::pre_run_actions() noexcept {
 
 	try {
 		m_database.reset(new Database::SQLite3(*config->get_database_file()));
+		m_client.reset(new Control::Client(config->get_control_socket()));
+		if (!m_client->connect())
+			m_client.reset();
 	}
 	catch (const std::exception& e) {
 		std::cerr << red(e.what()) << std::endl;
@@ -41,18 +51,40 @@ Task::STATUS Frontend::Task::Interactive::pre_run_actions() noexcept {
 		std::cerr << red("Film " + config->get_interactive_parameter()->string() + " is already in database!") << std::endl;
 		return VideoConvert::Task::HALT_ERROR;
 	}
-	else if (std::filesystem::is_directory(full_path)) {
+	else if (!std::filesystem::is_directory(full_path)) {
+		// Same content under another name is refused before spending any time on it
+		fingerprint_files({ *config->get_interactive_parameter() });
+		if (m_contents.contains(*config->get_interactive_parameter())) {
+			auto duplicate = m_database->find_duplicate(m_contents.at(*config->get_interactive_parameter()));
+			if (duplicate) {
+				std::cerr << red("Film " + config->get_interactive_parameter()->string() + " has the same content than " + duplicate_string(*duplicate)) << std::endl;
+				return VideoConvert::Task::HALT_ERROR;
+			}
+		}
+		// Probing runs while user answers the first questions
+		m_film_data = std::async(std::launch::async, FFprobe::from_file, full_path);
+	}
+	else {
 		#ifdef ENABLE_HEVC
 		if (m_database->is_group_in_database(*config->get_interactive_parameter())) {
 			std::cerr << red("Film group (folder) " + config->get_interactive_parameter()->string() + " is already in database") << std::endl;
 			return VideoConvert::Task::HALT_ERROR;
 		}
 		else {
-			auto files = find_files_recursive();
-			if (files.first.empty()) {
+			// Walked only once, do_work reuses it
+			try {
+				m_group_files = find_files_recursive();
+			}
+			catch (const std::exception& e) {
+				std::cerr << red(e.what()) << std::endl;
+				return VideoConvert::Task::HALT_ERROR;
+			}
+			if (m_group_files.first.empty()) {
 				std::cerr << red("Folder contains 0 valid files");
-				if (!files.second.empty())
-					std::cerr << gray(" (but " + std::to_string(files.second.size()) + " unsupported files)");
+				if (!m_group_files.second.empty())
+					std::cerr << gray(" (but " + std::to_string(m_group_files.second.size()) + " unsupported files)");
+				if (!m_scan->m_unchanged.empty())
+					std::cerr << gray(" (" + std::to_string(m_scan->m_unchanged.size()) + " files were not changed since folder was last added)");
 				std::cerr << red("!") << std::endl;
 				return VideoConvert::Task::HALT_ERROR;
 			}
@@ -100,8 +132,12 @@ bool Frontend::Task::Interactive::ask_animation() {
 FFprobe Frontend::Task::Interactive::get_film_data() {
 	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
 	const Types::path_t full_path = *config->get_input_folder() / *config->get_interactive_parameter(); 
-	
-	return FFprobe::from_file(full_path);
+
+	if (!m_film_data.valid())
+		return FFprobe::from_file(full_path);
+	if (m_film_data.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		std::cout << gray("Waiting for film data...") << std::endl;
+	return m_film_data.get();
 }
 
 void Frontend::Task::Interactive::update_title_renamed(const FFprobe& film_data, const stream_map_t& stream_data, Types::optional_path_t& title) {
@@ -299,12 +335,18 @@ void Frontend::Task::Interactive::ask_stream([[maybe_unused]]const FFprobe& prob
 	strm_map.at(strm_id.first)[strm_id.second] = stream;
 }
 
-Database::Data::film Frontend::Task::Interactive::generate_film(const stream_map_t& stream_map, const Database::Data::film::priority& priority, const Types::optional_path_t& title, const bool& animation) {
+Database::Data::film Frontend::Task::Interactive::generate_film(const FFprobe& probe, const stream_map_t& stream_map, const Database::Data::film::priority& priority, const Types::optional_path_t& title, const bool& animation) {
 	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
 	Database::Data::film result;
 	result.m_priority = priority;
 	result.m_file = *config->get_interactive_parameter();
 	result.m_title = title;
+	result.m_duration = probe.get_duration();
+	if (probe.get_resolution())
+		result.m_resolution = *probe.get_resolution();
+	result.m_frame_rate = probe.get_frame_rate();
+	if (m_contents.contains(result.m_file))
+		result.m_content = m_contents.at(result.m_file);
 	std::list<Database::Data::film::stream> streams;
 
 	// For FFmpeg map order matters so we do in order
@@ -321,26 +363,76 @@ Database::Data::film Frontend::Task::Interactive::generate_film(const stream_map
 	return result;
 }
 
+void Frontend::Task::Interactive::display_estimated_time(const Database::Data::film& film) {
+	// Estimation assumes the film will be converted in this same host
+	auto estimation = m_database->estimate_encode_time(film, Utils::System::get_hostname());
+	if (estimation)
+		std::cout << "Estimated conversion time: " << light_blue(Utils::Display::duration_to_string(std::chrono::seconds(static_cast<long>(*estimation)))) << std::endl;
+	else
+		std::cout << gray("There is not enough encode history to estimate conversion time") << std::endl;
+}
+
 std::optional<unsigned int> Frontend::Task::Interactive::insert_film(const Database::Data::film& film) {
-	return m_database->insert_film(film);
+	if (!m_client)
+		return m_database->insert_film(film);
+
+	Json::Value request = Control::Protocol::request("enqueue");
+	request["films"].append(Control::Protocol::film_to_json(film));
+	auto response = send_to_daemon(request);
+	return response ? std::optional<unsigned int>((*response)["id"].asUInt()) : std::optional<unsigned int>();
+}
+
+std::optional<Json::Value> Frontend::Task::Interactive::send_to_daemon(const Json::Value& request) {
+	std::optional<Json::Value> result;
+	try {
+		Json::Value response = m_client->request(request);
+		if (response["ok"].asBool())
+			result = std::move(response);
+		else
+			std::cerr << red("Daemon refused request: " + response["error"].asString()) << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << red(e.what()) << std::endl;
+	}
+	return result;
 }
 
 #ifdef ENABLE_HEVC
 Frontend::Task::Interactive::group_file_info_t Frontend::Task::Interactive::find_files_recursive() {
 	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
-	const Types::path_t full_folder = *config->get_input_folder() / *config->get_interactive_parameter();
-
 	std::list<Types::path_t> valid, invalid;
 
-	for (std::filesystem::recursive_directory_iterator it(full_folder), end; it != end; ++it) {
-		if (!is_directory(it->path())) {
-			const std::string extension = it->path().extension();
-			Types::path_t relative = std::filesystem::relative(it->path(), *config->get_input_folder());
-			if (!config->is_extension_supported(extension))
-				invalid.push_back(relative);
-			else
-				valid.push_back(relative);
+	// Files not changed since folder was last added are not added again
+	m_scan = Utils::Walker(*config->get_input_folder()).scan(*config->get_interactive_parameter(), m_database->get_scan_index(*config->get_interactive_parameter()));
+	if (config->get_rescan()) {
+		// Index is still updated so only the files themselves are added again
+		m_scan->m_changed.merge(m_scan->m_unchanged);
+	}
+	for (auto it = m_scan->m_changed.begin(); it != m_scan->m_changed.end(); it++) {
+		if (!config->is_extension_supported(it->extension()))
+			invalid.push_back(*it);
+		else
+			valid.push_back(*it);
+	}
+
+	// Duplicates of known content or of another file in this folder are left out
+	fingerprint_files(valid);
+	std::map<std::pair<uintmax_t, uint64_t>, Types::path_t> seen;
+	for (auto it = valid.begin(); it != valid.end();) {
+		std::optional<Database::Data::duplicate> duplicate;
+		if (m_contents.contains(*it)) {
+			const auto& content = m_contents.at(*it);
+			duplicate = m_database->find_duplicate(content);
+			if (!duplicate && seen.contains({ content.m_size, content.m_fingerprint }))
+				duplicate = { seen.at({ content.m_size, content.m_fingerprint }), Database::Data::duplicate::QUEUED };
+			seen.insert({ { content.m_size, content.m_fingerprint }, *it });
+		}
+		if (duplicate) {
+			m_duplicates.push_back({ *it, *duplicate });
+			it = valid.erase(it);
 		}
+		else
+			it++;
 	}
 
 	return { valid, invalid };
@@ -361,6 +453,13 @@ bool Frontend::Task::Interactive::ask_group_confirmation(const group_file_info_t
 	}
 	else {
 		std::cout << green("Found " + std::to_string(group_info.first.size()) + " film(s)") << std::endl;
+		if (m_scan && !m_scan->m_unchanged.empty())
+			std::cout << gray(std::to_string(m_scan->m_unchanged.size()) + " file(s) not changed since folder was last added will be skipped") << std::endl;
+		if (!m_duplicates.empty()) {
+			std::cout << yellow("Warning: found " + std::to_string(m_duplicates.size()) + " duplicated file(s) that will be skipped.") << std::endl;
+			for (auto it = m_duplicates.begin(); it != m_duplicates.end(); it++)
+				std::cout << light_yellow("\t* " + it->first.string()) << gray(" (same content than " + duplicate_string(it->second) + ")") << std::endl;
+		}
 		if (!group_info.second.empty()) {
 			std::cout << yellow("Warning: found " + std::to_string(group_info.second.size()) + " invalid file(s) that will be ignored.") << std::endl;
 			for (Types::path_t file: group_info.second)
@@ -378,6 +477,9 @@ bool Frontend::Task::Interactive::ask_group_confirmation(const group_file_info_t
 
 Database::Data::film::group Frontend::Task::Interactive::insert_group() {
 	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	// Daemon will create the group when films are sent so its id is not known yet
+	if (m_client)
+		return { 0, *config->get_interactive_parameter() };
 	return *m_database->insert_group(*config->get_interactive_parameter());
 }
 
@@ -408,6 +510,8 @@ Frontend::Task::Interactive::film_group_t Frontend::Task::Interactive::generate_
 		film.m_group = group;
 		film.m_priority = priority;
 		film.m_streams = streams;
+		if (m_contents.contains(film_path))
+			film.m_content = m_contents.at(film_path);
 		result.push_back(std::move(film));
 	}
 
@@ -415,7 +519,16 @@ Frontend::Task::Interactive::film_group_t Frontend::Task::Interactive::generate_
 }
 
 bool Frontend::Task::Interactive::insert_film_group_t(const film_group_t& film_group_t) {
-	bool operation = m_database->insert_films(film_group_t);
+	bool operation;
+	if (m_client) {
+		Json::Value request = Control::Protocol::request("enqueue");
+		request["group"] = film_group_t.front().m_group->folder.string();
+		for (auto it = film_group_t.begin(); it != film_group_t.end(); it++)
+			request["films"].append(Control::Protocol::film_to_json(*it));
+		operation = send_to_daemon(request).has_value();
+	}
+	else
+		operation = m_database->insert_films(film_group_t);
 	
 	if (operation) {
 		std::cout << green("Inserted " + std::to_string(film_group_t.size()) + " film(s) in database") << std::endl;
@@ -426,8 +539,59 @@ bool Frontend::Task::Interactive::insert_film_group_t(const film_group_t& film_g
 
 	return operation;
 }
+
+bool Frontend::Task::Interactive::update_scan_index() {
+	if (!m_client) {
+		m_database->update_scan_index(*m_scan);
+		return true;
+	}
+
+	Json::Value request = Control::Protocol::request("index");
+	request["scan"] = Control::Protocol::scan_to_json(*m_scan);
+	return send_to_daemon(request).has_value();
+}
 #endif
 
+void Frontend::Task::Interactive::fingerprint_files(const std::list<Types::path_t>& files) {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	const std::vector<Types::path_t> pending(files.begin(), files.end());
+	std::vector<std::optional<Database::Data::film::content>> contents(pending.size());
+	std::atomic<size_t> next(0);
+
+	// Mostly waiting on storage so files are read in parallel
+	auto worker = [&]() {
+		size_t index;
+		while ((index = next++) < pending.size()) {
+			try {
+				const auto fingerprint = Utils::Filesystem::fingerprint(*config->get_input_folder() / pending[index]);
+				contents[index] = { fingerprint.first, fingerprint.second };
+			}
+			catch (const std::exception&) {} // Unreadable files are just not checked
+		}
+	};
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < std::min<size_t>(pending.size(), std::max(4u, std::thread::hardware_concurrency())); i++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread: threads)
+		thread.join();
+
+	for (size_t i = 0; i < pending.size(); i++)
+		if (contents[i])
+			m_contents[pending[i]] = *contents[i];
+}
+
+std::string Frontend::Task::Interactive::duplicate_string(const Database::Data::duplicate& duplicate) {
+	switch (duplicate.m_status) {
+		case Database::Data::duplicate::PROCESSING:
+			return duplicate.m_file.string() + " which is being converted";
+		case Database::Data::duplicate::CONVERTED:
+			return duplicate.m_file.string() + " which was already converted";
+		default:
+			return duplicate.m_file.string() + " which is already queued";
+	}
+}
+
 StormByte::VideoConvert::Task::STATUS Frontend::Task::Interactive::do_work(std::optional<pid_t>&) noexcept {
 	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
 	Types::optional_path_t title;
@@ -439,7 +603,7 @@ StormByte::VideoConvert::Task::STATUS Frontend::Task::Interactive::do_work(std::
 
 	#ifdef ENABLE_HEVC
 	if (std::filesystem::is_directory(*config->get_input_folder() / *config->get_interactive_parameter())) {
-		group_file_info_t files = find_files_recursive();
+		const group_file_info_t& files = m_group_files;
 		if (files.first.empty()) {
 			std::cerr << red("Directory is empty!") << std::endl;
 			return VideoConvert::Task::HALT_ERROR;
@@ -456,6 +620,8 @@ StormByte::VideoConvert::Task::STATUS Frontend::Task::Interactive::do_work(std::
 			)) {
 				return VideoConvert::Task::HALT_ERROR;
 			}
+			if (!update_scan_index())
+				return VideoConvert::Task::HALT_ERROR;
 		}
 	}
 	else {
@@ -477,7 +643,7 @@ StormByte::VideoConvert::Task::STATUS Frontend::Task::Interactive::do_work(std::
 		} while (continue_asking);
 
 		update_title_renamed(film_data, stream_map, title);
-		film = generate_film(stream_map, priority, title, animation);
+		film = generate_film(film_data, stream_map, priority, title, animation);
 
 		if (film.m_streams.empty()) {
 			std::cerr << light_red("There were no streams selected for film " + config->get_interactive_parameter()->string()) << ", " << green(bold("no changes were made to database")) << std::endl;
@@ -488,6 +654,7 @@ StormByte::VideoConvert::Task::STATUS Frontend::Task::Interactive::do_work(std::
 
 			if (film_id) {
 				std::cout << green("Film " + config->get_interactive_parameter()->string() + " was inserted with ID " + std::to_string(*film_id)) << std::endl;
+				display_estimated_time(film);
 			}
 			else {
 				std::cerr << red("Could NOT insert film!") << std::endl;
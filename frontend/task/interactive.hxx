@@ -3,8 +3,10 @@
 #include "task/cli/base.hxx"
 #include "ffprobe/ffprobe.hxx"
 #include "database/sqlite3.hxx"
+#include "control/client.hxx"
 
 #include <map>
+#include <future>
 
 namespace StormByte::VideoConvert::Frontend::Task {
 	class Interactive: public VideoConvert::Task::CLI::Base {
@@ -34,8 +36,13 @@ namespace StormByte::VideoConvert::Frontend::Task {
 			void									display_stream_map(const FFprobe&, const stream_map_t&);
 			std::optional<stream_id_t>				ask_stream_id(const FFprobe&);
 			void									ask_stream(const FFprobe&, const stream_id_t&, stream_map_t&);
-			Database::Data::film					generate_film(const stream_map_t&, const Database::Data::film::priority&, const Types::optional_path_t& title, const bool& animation);
+			Database::Data::film					generate_film(const FFprobe&, const stream_map_t&, const Database::Data::film::priority&, const Types::optional_path_t& title, const bool& animation);
+			void									display_estimated_time(const Database::Data::film&);
 			std::optional<unsigned int>				insert_film(const Database::Data::film&);
+			void									fingerprint_files(const std::list<Types::path_t>& files);
+			static std::string						duplicate_string(const Database::Data::duplicate&);
+			/* Writes go through daemon when it is running, returns its response only when successful */
+			std::optional<Json::Value>				send_to_daemon(const Json::Value& request);
 			#ifdef ENABLE_HEVC
 			group_file_info_t						find_files_recursive();
 			bool									ask_group_confirmation(const group_file_info_t&);
@@ -43,11 +50,19 @@ namespace StormByte::VideoConvert::Frontend::Task {
 			std::list<Database::Data::film::stream>	generate_default_streams_for_group(const bool& animation);
 			film_group_t							generate_film_group_t(const group_file_info_t&, const Database::Data::film::group& group, const Database::Data::film::priority&, const bool& animation);
 			bool									insert_film_group_t(const film_group_t&);
+			/* Remembers scanned folder so unchanged files are not added again next time */
+			bool									update_scan_index();
 			#endif
 
 			std::string m_buffer_str;
 			int m_buffer_int;
 			bool m_buffer_bool;
 			Types::database_t m_database;
+			std::unique_ptr<Control::Client> m_client; // Only when daemon is listening
+			std::future<FFprobe> m_film_data; // Started in pre_run_actions when adding a single film
+			group_file_info_t m_group_files; // Only when adding a folder
+			std::optional<Utils::Walker::scan_result> m_scan; // Only when adding a folder
+			std::map<Types::path_t, Database::Data::film::content> m_contents; // Fingerprinted files
+			std::list<std::pair<Types::path_t, Database::Data::duplicate>> m_duplicates; // Skipped files when adding a folder
 	};
 }
\ No newline at end of file
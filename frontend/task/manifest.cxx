@@ -0,0 +1,438 @@
+#include "manifest.hxx"
+#include "configuration/configuration.hxx"
+#include "control/protocol.hxx"
+#include "utils/input.hxx"
+#include "utils/filesystem.hxx"
+#include "help.hxx"
+
+#include <csignal>
+#include <fstream>
+#include <set>
+#include <boost/algorithm/string.hpp>
+
+using namespace StormByte::VideoConvert;
+
+const std::map<FFprobe::stream::TYPE, std::map<std::string, Database::Data::film::stream::codec>> Frontend::Task::Manifest::CODEC_NAMES = {
+	{ FFprobe::stream::VIDEO, {
+		{ "hevc",		Database::Data::film::stream::VIDEO_HEVC },
+		{ "copy",		Database::Data::film::stream::VIDEO_COPY }
+	}},
+	{ FFprobe::stream::AUDIO, {
+		{ "aac",		Database::Data::film::stream::AUDIO_AAC },
+		{ "fdkaac",		Database::Data::film::stream::AUDIO_FDKAAC },
+		{ "ac3",		Database::Data::film::stream::AUDIO_AC3 },
+		{ "eac3",		Database::Data::film::stream::AUDIO_EAC3 },
+		{ "opus",		Database::Data::film::stream::AUDIO_OPUS },
+		{ "copy",		Database::Data::film::stream::AUDIO_COPY }
+	}},
+	{ FFprobe::stream::SUBTITLE, {
+		{ "copy",		Database::Data::film::stream::SUBTITLE_COPY }
+	}}
+};
+const std::vector<std::string> Frontend::Task::Manifest::CSV_COLUMNS = { "file", "priority", "animation", "video", "audio", "subtitle", "hdr" };
+const size_t Frontend::Task::Manifest::BATCH_SIZE = 200;
+
+Frontend::Task::Manifest::Manifest():VideoConvert::Task::CLI::Base(), m_next_entry(0), m_running_workers(0), m_inserted(0), m_skipped(0), m_failed(0) {
+	// Reset signals so app can be exited from CLI
+	signal(SIGTERM,	SIG_DFL);
+	signal(SIGINT,	SIG_DFL);
+	signal(SIGUSR1,	SIG_DFL);
+}
+
+Task::STATUS Frontend::Task::Manifest::pre_run_actions() noexcept {
+	assert(m_config);
+
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+
+	try {
+		m_database.reset(new Database::SQLite3(*config->get_database_file()));
+		m_client.reset(new Control::Client(config->get_control_socket()));
+		if (!m_client->connect())
+			m_client.reset();
+
+		const Types::path_t manifest = *config->get_manifest_parameter();
+		if (manifest == "-")
+			read_manifest(std::cin);
+		else {
+			std::ifstream file(manifest);
+			if (!file)
+				throw std::runtime_error("Manifest " + manifest.string() + " can not be read");
+			read_manifest(file);
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << red(e.what()) << std::endl;
+		return VideoConvert::Task::HALT_ERROR;
+	}
+
+	if (m_entries.empty()) {
+		std::cerr << red("No films to add") << (m_skipped + m_failed > 0 ? gray(" (" + std::to_string(m_skipped) + " skipped, " + std::to_string(m_failed) + " failed)") : "") << std::endl;
+		return m_failed > 0 ? VideoConvert::Task::HALT_ERROR : VideoConvert::Task::HALT_OK;
+	}
+
+	return VideoConvert::Task::RUNNING;
+}
+
+StormByte::VideoConvert::Task::STATUS Frontend::Task::Manifest::do_work(std::optional<pid_t>&) noexcept {
+	// Probing is mostly waiting for ffprobe so it is worth having some workers even with few cores
+	const unsigned int workers = std::min<size_t>(m_entries.size(), std::max(4u, std::thread::hardware_concurrency()));
+	std::cout << "Probing " << light_blue(m_entries.size()) << " film(s) with " << workers << " worker(s)" << (m_client ? gray(" (sending them to running daemon)") : "") << std::endl;
+
+	m_running_workers = workers;
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < workers; i++)
+		threads.emplace_back(&Manifest::probe_worker, this);
+	std::thread writer_thread(&Manifest::writer, this);
+
+	for (auto& thread: threads)
+		thread.join();
+	writer_thread.join();
+
+	std::cout << green("Inserted " + std::to_string(m_inserted) + " film(s)");
+	if (m_skipped > 0)
+		std::cout << yellow(", skipped " + std::to_string(m_skipped));
+	if (m_failed > 0)
+		std::cout << red(", failed " + std::to_string(m_failed));
+	std::cout << std::endl;
+
+	return m_failed > 0 ? VideoConvert::Task::HALT_ERROR : VideoConvert::Task::HALT_OK;
+}
+
+void Frontend::Task::Manifest::read_manifest(std::istream& input) {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	std::set<Types::path_t> seen;
+	std::string line;
+	unsigned int number = 0;
+	bool first_csv_line = true;
+
+	while (std::getline(input, line)) {
+		number++;
+		boost::algorithm::trim(line);
+		if (line.empty() || line[0] == '#') continue;
+
+		try {
+			entry item;
+			if (line[0] == '{')
+				item = parse_json_line(line);
+			else {
+				// Optional header line
+				if (first_csv_line && split_csv(line)[0] == CSV_COLUMNS[0]) {
+					first_csv_line = false;
+					continue;
+				}
+				item = parse_csv_line(line);
+			}
+			first_csv_line = false;
+			item.m_line = number;
+
+			if (!std::filesystem::is_regular_file(*config->get_input_folder() / item.m_file))
+				throw std::runtime_error("File " + item.m_file.string() + " does not exist in input folder");
+			if (seen.contains(item.m_file) || m_database->is_film_in_database(item.m_file)) {
+				std::cout << yellow("Line " + std::to_string(number) + ": film " + item.m_file.string() + " is already queued, skipping it") << std::endl;
+				m_skipped++;
+				continue;
+			}
+			seen.insert(item.m_file);
+			m_entries.push_back(std::move(item));
+		}
+		catch (const std::exception& e) {
+			report_error(number, e.what());
+			m_failed++;
+		}
+	}
+}
+
+Frontend::Task::Manifest::entry Frontend::Task::Manifest::parse_json_line(const std::string& line) const {
+	auto json = Control::Protocol::parse(line);
+	if (!json)
+		throw std::runtime_error("Malformed JSON");
+	if (!(*json)["file"].isString())
+		throw std::runtime_error("Missing file");
+
+	entry item = default_entry();
+	item.m_file = (*json)["file"].asString();
+	if ((*json).isMember("priority"))
+		item.m_priority = parse_priority((*json)["priority"].asString());
+	if ((*json).isMember("animation"))
+		item.m_animation = (*json)["animation"].isBool() ? (*json)["animation"].asBool() : parse_bool((*json)["animation"].asString());
+	for (auto it = CODEC_NAMES.begin(); it != CODEC_NAMES.end(); it++) {
+		const std::string type_name = it->first == FFprobe::stream::VIDEO ? "video" : it->first == FFprobe::stream::AUDIO ? "audio" : "subtitle";
+		if ((*json).isMember(type_name))
+			item.m_codecs[it->first] = parse_codec(it->first, (*json)[type_name].asString());
+	}
+	if ((*json).isMember("hdr"))
+		item.m_hdr = parse_hdr((*json)["hdr"].asString());
+	return item;
+}
+
+Frontend::Task::Manifest::entry Frontend::Task::Manifest::parse_csv_line(const std::string& line) const {
+	const std::vector<std::string> fields = split_csv(line);
+	if (fields.size() > CSV_COLUMNS.size())
+		throw std::runtime_error("Too many columns, expected " + boost::algorithm::join(CSV_COLUMNS, ","));
+	if (fields[0].empty())
+		throw std::runtime_error("Missing file");
+
+	// Empty columns keep their defaults
+	entry item = default_entry();
+	item.m_file = fields[0];
+	if (fields.size() > 1 && !fields[1].empty()) item.m_priority = parse_priority(fields[1]);
+	if (fields.size() > 2 && !fields[2].empty()) item.m_animation = parse_bool(fields[2]);
+	if (fields.size() > 3 && !fields[3].empty()) item.m_codecs[FFprobe::stream::VIDEO] = parse_codec(FFprobe::stream::VIDEO, fields[3]);
+	if (fields.size() > 4 && !fields[4].empty()) item.m_codecs[FFprobe::stream::AUDIO] = parse_codec(FFprobe::stream::AUDIO, fields[4]);
+	if (fields.size() > 5 && !fields[5].empty()) item.m_codecs[FFprobe::stream::SUBTITLE] = parse_codec(FFprobe::stream::SUBTITLE, fields[5]);
+	if (fields.size() > 6 && !fields[6].empty()) item.m_hdr = parse_hdr(fields[6]);
+	return item;
+}
+
+std::vector<std::string> Frontend::Task::Manifest::split_csv(const std::string& line) {
+	// Fields can be double quoted so they can contain commas, "" is a literal quote inside them
+	std::vector<std::string> result(1);
+	bool quoted = false;
+	for (size_t i = 0; i < line.size(); i++) {
+		const char c = line[i];
+		if (quoted) {
+			if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+				result.back() += line[++i];
+			else if (c == '"')
+				quoted = false;
+			else
+				result.back() += c;
+		}
+		else if (c == '"')
+			quoted = true;
+		else if (c == ',')
+			result.push_back("");
+		else
+			result.back() += c;
+	}
+	if (quoted)
+		throw std::runtime_error("Unterminated quoted field");
+	for (auto& field: result)
+		boost::algorithm::trim(field);
+	return result;
+}
+
+Database::Data::film::priority Frontend::Task::Manifest::parse_priority(const std::string& value) {
+	static const std::map<std::string, Database::Data::film::priority> names = {
+		{ "low",		Database::Data::film::LOW },
+		{ "normal",		Database::Data::film::NORMAL },
+		{ "high",		Database::Data::film::HIGH },
+		{ "important",	Database::Data::film::IMPORTANT }
+	};
+	int number;
+	const std::string lower = boost::algorithm::to_lower_copy(value);
+	if (names.contains(lower))
+		return names.at(lower);
+	else if (Utils::Input::to_int_in_range(value, number, Database::Data::film::LOW, Database::Data::film::IMPORTANT))
+		return static_cast<Database::Data::film::priority>(number);
+	else
+		throw std::runtime_error("Invalid priority " + value + ", accepted values are low(0), normal(1), high(2) and important(3)");
+}
+
+bool Frontend::Task::Manifest::parse_bool(const std::string& value) {
+	const std::string lower = boost::algorithm::to_lower_copy(value);
+	if (lower == "1" || lower == "true" || lower == "yes" || lower == "y")
+		return true;
+	else if (lower == "0" || lower == "false" || lower == "no" || lower == "n")
+		return false;
+	else
+		throw std::runtime_error("Invalid boolean " + value);
+}
+
+Frontend::Task::Manifest::HDR_MODE Frontend::Task::Manifest::parse_hdr(const std::string& value) {
+	const std::string lower = boost::algorithm::to_lower_copy(value);
+	if (lower == "auto")
+		return HDR_AUTO;
+	else if (lower == "always")
+		return HDR_ALWAYS;
+	else if (lower == "never")
+		return HDR_NEVER;
+	else
+		throw std::runtime_error("Invalid HDR mode " + value + ", accepted values are auto, always and never");
+}
+
+std::optional<Database::Data::film::stream::codec> Frontend::Task::Manifest::parse_codec(const FFprobe::stream::TYPE& type, const std::string& value) const {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	const std::string lower = boost::algorithm::to_lower_copy(value);
+	if (lower == "none")
+		return {};
+
+	const auto& names = CODEC_NAMES.at(type);
+	if (!names.contains(lower) || !config->is_codec_supported(names.at(lower))) {
+		std::list<std::string> accepted = { "none" };
+		for (auto it = names.begin(); it != names.end(); it++)
+			if (config->is_codec_supported(it->second))
+				accepted.push_back(it->first);
+		throw std::runtime_error("Codec " + value + " is not supported for this stream type, accepted values are " + boost::algorithm::join(accepted, ", "));
+	}
+	return names.at(lower);
+}
+
+Frontend::Task::Manifest::entry Frontend::Task::Manifest::default_entry() const {
+	// Same defaults than when adding a folder
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	entry item;
+	item.m_codecs[FFprobe::stream::VIDEO]		= config->is_codec_supported(Database::Data::film::stream::VIDEO_HEVC) ? Database::Data::film::stream::VIDEO_HEVC : Database::Data::film::stream::VIDEO_COPY;
+	item.m_codecs[FFprobe::stream::AUDIO]		= Database::Data::film::stream::AUDIO_COPY;
+	item.m_codecs[FFprobe::stream::SUBTITLE]	= Database::Data::film::stream::SUBTITLE_COPY;
+	return item;
+}
+
+void Frontend::Task::Manifest::probe_worker() {
+	size_t index;
+	while ((index = m_next_entry++) < m_entries.size()) {
+		const entry& item = m_entries[index];
+		std::optional<Database::Data::film> film;
+		std::string error;
+		try {
+			film = generate_film(item);
+		}
+		catch (const std::exception& e) {
+			error = e.what();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (film)
+				m_probed.push(std::move(*film));
+			else {
+				report_error(item.m_line, error);
+				m_failed++;
+			}
+		}
+		m_condition.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_running_workers--;
+	}
+	m_condition.notify_all();
+}
+
+void Frontend::Task::Manifest::writer() {
+	std::list<Database::Data::film> batch;
+	std::map<std::pair<uintmax_t, uint64_t>, Types::path_t> seen; // Content already accepted from this manifest
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_condition.wait(lock, [this] { return !m_probed.empty() || m_running_workers == 0; });
+		while (!m_probed.empty() && batch.size() < BATCH_SIZE) {
+			Database::Data::film film = std::move(m_probed.front());
+			m_probed.pop();
+			if (is_duplicate(film, seen))
+				m_skipped++;
+			else
+				batch.push_back(std::move(film));
+		}
+
+		const bool finished = m_probed.empty() && m_running_workers == 0;
+		if (batch.size() >= BATCH_SIZE || (finished && !batch.empty())) {
+			lock.unlock();
+			auto skipped = write_batch(batch);
+			lock.lock();
+			if (skipped) {
+				for (auto it = skipped->begin(); it != skipped->end(); it++)
+					std::cout << yellow("Film " + it->string() + " was queued meanwhile, skipping it") << std::endl;
+				m_skipped += skipped->size();
+				m_inserted += batch.size() - skipped->size();
+				std::cout << "Inserted " << light_blue(m_inserted) << " of " << m_entries.size() << " film(s)" << std::endl;
+			}
+			else {
+				std::cerr << red("Could not insert a batch of " + std::to_string(batch.size()) + " film(s) starting with " + batch.front().m_file.string()) << std::endl;
+				m_failed += batch.size();
+			}
+			batch.clear();
+		}
+		if (finished && batch.empty()) break;
+	}
+}
+
+std::optional<Database::Data::film> Frontend::Task::Manifest::generate_film(const entry& item) const {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	const FFprobe probe = FFprobe::from_file(*config->get_input_folder() / item.m_file);
+	if (probe.get_stream(FFprobe::stream::VIDEO).empty())
+		throw std::runtime_error("No video stream found in " + item.m_file.string());
+
+	Database::Data::film film;
+	film.m_file			= item.m_file;
+	film.m_priority		= item.m_priority;
+	film.m_duration		= probe.get_duration();
+	if (probe.get_resolution())
+		film.m_resolution = *probe.get_resolution();
+	film.m_frame_rate	= probe.get_frame_rate();
+	try {
+		const auto fingerprint = Utils::Filesystem::fingerprint(*config->get_input_folder() / item.m_file);
+		film.m_content = { fingerprint.first, fingerprint.second };
+	}
+	catch (const std::exception&) {} // Then it is just not checked for duplicates
+
+	// For FFmpeg map order matters so we do in order
+	for (FFprobe::stream::TYPE type: { FFprobe::stream::VIDEO, FFprobe::stream::AUDIO, FFprobe::stream::SUBTITLE }) {
+		const auto codec = item.m_codecs.at(type);
+		if (!codec || probe.get_stream(type).empty()) continue;
+
+		Database::Data::film::stream stream;
+		// Video is not selected as all so cover attachments are not encoded
+		stream.m_id = type == FFprobe::stream::VIDEO ? 0 : -1;
+		stream.m_codec = *codec;
+		if (stream.m_codec == Database::Data::film::stream::VIDEO_HEVC) {
+			stream.m_is_animation = item.m_animation;
+			#ifdef ENABLE_HEVC
+			if (item.m_hdr != HDR_NEVER && (probe.is_HDR_detected() || (item.m_hdr == HDR_ALWAYS && probe.is_HDR_factible())))
+				stream.m_hdr = probe.get_HDR().data();
+			#endif
+		}
+		film.m_streams.push_back(std::move(stream));
+	}
+
+	return film;
+}
+
+bool Frontend::Task::Manifest::is_duplicate(const Database::Data::film& film, std::map<std::pair<uintmax_t, uint64_t>, Types::path_t>& seen) {
+	if (!film.m_content) return false;
+
+	const std::pair<uintmax_t, uint64_t> key { film.m_content->m_size, film.m_content->m_fingerprint };
+	std::optional<std::string> other;
+	if (seen.contains(key))
+		other = seen.at(key).string() + " from this manifest";
+	else {
+		auto duplicate = m_database->find_duplicate(*film.m_content);
+		if (duplicate)
+			other = duplicate->m_file.string() + (duplicate->m_status == Database::Data::duplicate::CONVERTED ? " which was already converted" : " which is already queued");
+	}
+
+	if (other)
+		std::cout << yellow("Film " + film.m_file.string() + " has the same content than " + *other + ", skipping it") << std::endl;
+	else
+		seen.insert({ key, film.m_file });
+	return other.has_value();
+}
+
+std::optional<std::list<Types::path_t>> Frontend::Task::Manifest::write_batch(const std::list<Database::Data::film>& films) {
+	if (!m_client)
+		return m_database->insert_new_films(films);
+
+	std::optional<std::list<Types::path_t>> result;
+	try {
+		Json::Value request = Control::Protocol::request("enqueue");
+		request["skip_existing"] = true;
+		for (auto it = films.begin(); it != films.end(); it++)
+			request["films"].append(Control::Protocol::film_to_json(*it));
+		Json::Value response = m_client->request(request);
+		if (response["ok"].asBool()) {
+			result = std::list<Types::path_t>();
+			for (Json::Value::ArrayIndex i = 0; i < response["skipped"].size(); i++)
+				result->push_back(response["skipped"][i].asString());
+		}
+		else
+			std::cerr << red("Daemon refused request: " + response["error"].asString()) << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << red(e.what()) << std::endl;
+	}
+	return result;
+}
+
+void Frontend::Task::Manifest::report_error(const unsigned int& line, const std::string& message) const {
+	std::cerr << red("Line " + std::to_string(line) + ": " + message) << std::endl;
+}
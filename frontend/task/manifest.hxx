@@ -0,0 +1,75 @@
+#pragma once
+
+#include "task/cli/base.hxx"
+#include "ffprobe/ffprobe.hxx"
+#include "database/sqlite3.hxx"
+#include "control/client.hxx"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <queue>
+
+namespace StormByte::VideoConvert::Frontend::Task {
+	/* Adds films described in a manifest (JSON or CSV lines) without asking anything */
+	class Manifest: public VideoConvert::Task::CLI::Base {
+		public:
+			Manifest();
+			Manifest(const Manifest&) = delete;
+			Manifest(Manifest&&) noexcept = delete;
+			Manifest& operator=(const Manifest&) = delete;
+			Manifest& operator=(Manifest&&) noexcept = delete;
+			~Manifest() noexcept = default;
+
+		private:
+			enum HDR_MODE: unsigned short { HDR_AUTO = 0, HDR_ALWAYS, HDR_NEVER };
+
+			struct entry {
+				unsigned int m_line;
+				Types::path_t m_file; // Relative to input folder
+				Database::Data::film::priority m_priority = Database::Data::film::NORMAL;
+				bool m_animation = false;
+				std::map<FFprobe::stream::TYPE, std::optional<Database::Data::film::stream::codec>> m_codecs; // No value drops every stream of that type
+				HDR_MODE m_hdr = HDR_AUTO;
+			};
+
+			VideoConvert::Task::STATUS pre_run_actions() noexcept override;
+			VideoConvert::Task::STATUS do_work(std::optional<pid_t>&) noexcept override;
+
+			/* Parsing, all of them throw std::runtime_error on invalid values */
+			void read_manifest(std::istream& input);
+			entry parse_json_line(const std::string& line) const;
+			entry parse_csv_line(const std::string& line) const;
+			static std::vector<std::string> split_csv(const std::string& line);
+			static Database::Data::film::priority parse_priority(const std::string& value);
+			static bool parse_bool(const std::string& value);
+			static HDR_MODE parse_hdr(const std::string& value);
+			std::optional<Database::Data::film::stream::codec> parse_codec(const FFprobe::stream::TYPE& type, const std::string& value) const;
+			entry default_entry() const;
+
+			/* Pipeline: probe workers feed a single database writer */
+			void probe_worker();
+			void writer();
+			std::optional<Database::Data::film> generate_film(const entry& item) const;
+			bool is_duplicate(const Database::Data::film& film, std::map<std::pair<uintmax_t, uint64_t>, Types::path_t>& seen); // Only from writer
+			/* Films already in database are skipped, returns their files (no value if batch failed) */
+			std::optional<std::list<Types::path_t>> write_batch(const std::list<Database::Data::film>& films);
+			void report_error(const unsigned int& line, const std::string& message) const;
+
+			std::vector<entry> m_entries;
+			Types::database_t m_database;
+			std::unique_ptr<Control::Client> m_client; // Only when daemon is listening
+			std::atomic<size_t> m_next_entry;
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			std::queue<Database::Data::film> m_probed;
+			unsigned int m_running_workers;
+			unsigned int m_inserted, m_skipped, m_failed;
+
+			static const std::map<FFprobe::stream::TYPE, std::map<std::string, Database::Data::film::stream::codec>> CODEC_NAMES;
+			static const std::vector<std::string> CSV_COLUMNS;
+			static const size_t BATCH_SIZE;
+	};
+}
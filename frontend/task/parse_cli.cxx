@@ -2,6 +2,9 @@
 #include "interactive.hxx"
 #include "daemon.hxx"
 #include "test.hxx"
+#include "remote.hxx"
+#include "manifest.hxx"
+#include "sweep.hxx"
 #include "utils/input.hxx"
 #include "configuration/configuration.hxx"
 
@@ -98,6 +101,16 @@ StormByte::VideoConvert::Task::STATUS Frontend::Task::ParseCLI::pre_run_actions(
 					else
 						throw std::runtime_error("Pause time specified without argument, correct usage:");
 				}
+				else if (argument == "-mf" || argument == "--minfree") {
+					if (++counter < m_argc) {
+						int min_free;
+						if (!Utils::Input::to_int_positive(m_argv[counter++], min_free))
+							throw std::runtime_error("Minimum free space is not recognized as integer or it has a negative value");
+						config->set_min_free_space(min_free);
+					}
+					else
+						throw std::runtime_error("Minimum free space specified without argument, correct usage:");
+				}
 				else if (argument == "-of" || argument == "--onfinish") {
 					if (++counter < m_argc) {
 						std::string onfinish = m_argv[counter++];
@@ -119,6 +132,50 @@ StormByte::VideoConvert::Task::STATUS Frontend::Task::ParseCLI::pre_run_actions(
 					else
 						throw std::runtime_error("Add film specified without argument, correct usage:");
 				}
+				else if (argument == "-r" || argument == "--rescan") {
+					config->set_rescan();
+					counter++;
+				}
+				else if (argument == "-am" || argument == "--add-manifest") {
+					if (++counter < m_argc) {
+						config->set_manifest_parameter(m_argv[counter++]);
+						m_task.reset(new Task::Manifest());
+						status = VideoConvert::Task::RUNNING;
+					}
+					else
+						throw std::runtime_error("Add manifest specified without argument, correct usage:");
+				}
+				else if (argument == "-sw" || argument == "--sweep") {
+					if (++counter < m_argc) {
+						config->set_sweep_parameter(boost::erase_all_copy(std::string(m_argv[counter++]), "\\"));
+						m_task.reset(new Task::Sweep());
+						status = VideoConvert::Task::RUNNING;
+					}
+					else
+						throw std::runtime_error("Sweep specified without folder, correct usage:");
+				}
+				else if (argument == "-ctl" || argument == "--control") {
+					if (++counter < m_argc) {
+						const std::string command = m_argv[counter++];
+						auto argument_count = Task::Remote::get_argument_count(command);
+						if (!argument_count)
+							throw std::runtime_error("Control command " + command + " is not recognized; accepted values are status, pause, resume, cancel <film id> and priority <film id> <priority>. Correct usage:");
+						if (counter + *argument_count > m_argc)
+							throw std::runtime_error("Control command " + command + " needs " + std::to_string(*argument_count) + " argument(s), correct usage:");
+						std::vector<std::string> arguments(m_argv + counter, m_argv + counter + *argument_count);
+						counter += *argument_count;
+						m_task.reset(new Task::Remote(command, arguments));
+						status = VideoConvert::Task::RUNNING;
+					}
+					else
+						throw std::runtime_error("Control specified without command, correct usage:");
+				}
+				else if (argument == "-cs" || argument == "--controlsocket") {
+					if (++counter < m_argc)
+						config->set_control_socket(m_argv[counter++]);
+					else
+						throw std::runtime_error("Control socket specified without argument, correct usage:");
+				}
 				else if (argument == "-v" || argument == "--version") {
 					m_help->version();
 					status = VideoConvert::Task::HALT_OK;
@@ -134,7 +191,7 @@ StormByte::VideoConvert::Task::STATUS Frontend::Task::ParseCLI::pre_run_actions(
 
 			}
 			if(status == VideoConvert::Task::STOPPED) // If no action specified the default is HALT_ERROR
-				throw std::runtime_error("No action specified, select --add(-a), --daemon(-d) or --test(-t) to execute the program");
+				throw std::runtime_error("No action specified, select --add(-a), --add-manifest(-am), --sweep(-sw), --daemon(-d), --control(-ctl) or --test(-t) to execute the program");
 		}
 		catch(const std::runtime_error& exception) {
 			m_help->header();
@@ -0,0 +1,107 @@
+#include "remote.hxx"
+#include "configuration/configuration.hxx"
+#include "control/client.hxx"
+#include "control/protocol.hxx"
+#include "utils/input.hxx"
+
+#include <algorithm>
+#include <iomanip>
+
+using namespace StormByte::VideoConvert;
+
+const std::map<std::string, unsigned short> Frontend::Task::Remote::COMMAND_ARGUMENTS = {
+	{ "status",		0 },
+	{ "pause",		0 },
+	{ "resume",		0 },
+	{ "cancel",		1 }, // Film id
+	{ "priority",	2 }  // Film id and new priority
+};
+const size_t Frontend::Task::Remote::DATABASE_STATEMENTS_SHOWN = 10;
+
+Frontend::Task::Remote::Remote(const std::string& command, const std::vector<std::string>& arguments):VideoConvert::Task::CLI::Base(), m_command(command), m_arguments(arguments) {}
+
+std::optional<unsigned short> Frontend::Task::Remote::get_argument_count(const std::string& command) {
+	return COMMAND_ARGUMENTS.contains(command) ? COMMAND_ARGUMENTS.at(command) : std::optional<unsigned short>();
+}
+
+StormByte::VideoConvert::Task::STATUS Frontend::Task::Remote::do_work(std::optional<pid_t>&) noexcept {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	Control::Client client(config->get_control_socket());
+
+	if (!client.connect()) {
+		std::cerr << red("Daemon is not running or not listening on " + config->get_control_socket().string()) << std::endl;
+		return VideoConvert::Task::HALT_ERROR;
+	}
+
+	try {
+		Json::Value response = client.request(generate_request());
+		if (!response["ok"].asBool()) {
+			std::cerr << red("Daemon refused request: " + response["error"].asString()) << std::endl;
+			return VideoConvert::Task::HALT_ERROR;
+		}
+		if (m_command == "status")
+			display_status(response);
+		else
+			std::cout << green("Request " + m_command + " done") << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << red(e.what()) << std::endl;
+		return VideoConvert::Task::HALT_ERROR;
+	}
+
+	return VideoConvert::Task::HALT_OK;
+}
+
+Json::Value Frontend::Task::Remote::generate_request() const {
+	int film_id = 0, priority = 0;
+	if (m_command == "cancel" || m_command == "priority") {
+		if (!Utils::Input::to_int_positive(m_arguments[0], film_id))
+			throw std::runtime_error("Film id " + m_arguments[0] + " is not a positive integer");
+	}
+
+	Json::Value request;
+	if (m_command == "cancel") {
+		request = Control::Protocol::request("cancel");
+		request["id"] = film_id;
+	}
+	else if (m_command == "priority") {
+		if (!Utils::Input::to_int_in_range(m_arguments[1], priority, Database::Data::film::LOW, Database::Data::film::IMPORTANT))
+			throw std::runtime_error("Priority " + m_arguments[1] + " should be between " + std::to_string(Database::Data::film::LOW) + " and " + std::to_string(Database::Data::film::IMPORTANT));
+		request = Control::Protocol::request("reprioritize");
+		request["id"] = film_id;
+		request["priority"] = priority;
+	}
+	else
+		request = Control::Protocol::request(m_command);
+	return request;
+}
+
+void Frontend::Task::Remote::display_status(const Json::Value& response) const {
+	std::cout << "Queue is " << (response["paused"].asBool() ? yellow("paused") : green("running")) << " with " << light_blue(response["queued"].asUInt()) << " film(s) waiting" << std::endl;
+	if (response["current"].isObject())
+		std::cout << "Converting: " << magenta(response["current"]["id"].asUInt()) << " " << light_green(response["current"]["file"].asString()) << std::endl;
+	if (response["next"].size() > 0) {
+		std::cout << "Next films:" << std::endl;
+		for (Json::Value::ArrayIndex i = 0; i < response["next"].size(); i++)
+			std::cout << "\t" << magenta(response["next"][i]["id"].asUInt()) << " " << response["next"][i]["file"].asString() << std::endl;
+	}
+	display_database_statements(response["database"]);
+}
+
+void Frontend::Task::Remote::display_database_statements(const Json::Value& statements) const {
+	if (statements.size() == 0) return;
+
+	// Most time consuming first, as those are the ones holding database locks
+	std::vector<Json::Value> sorted(statements.begin(), statements.end());
+	std::sort(sorted.begin(), sorted.end(), [](const Json::Value& a, const Json::Value& b) { return a["total_ms"].asDouble() > b["total_ms"].asDouble(); });
+	if (sorted.size() > DATABASE_STATEMENTS_SHOWN) sorted.resize(DATABASE_STATEMENTS_SHOWN);
+
+	std::cout << "Database statements by total time:" << std::endl;
+	std::cout << "\t" << std::left << std::setw(32) << "Statement" << std::right << std::setw(10) << "Calls" << std::setw(14) << "Total (ms)" << std::setw(12) << "Max (ms)" << std::setw(12) << "Returned" << std::setw(12) << "Scanned" << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+	for (const auto& statement: sorted) {
+		std::string name = statement["name"].asString();
+		if (name.size() > 30) name = name.substr(0, 27) + "...";
+		std::cout << "\t" << std::left << std::setw(32) << name << std::right << std::setw(10) << statement["calls"].asUInt() << std::setw(14) << statement["total_ms"].asDouble() << std::setw(12) << statement["max_ms"].asDouble() << std::setw(12) << statement["rows_returned"].asUInt64() << std::setw(12) << statement["rows_scanned"].asUInt64() << std::endl;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "task/cli/base.hxx"
+
+#include <vector>
+#include <map>
+#include <jsoncpp/json/json.h>
+
+namespace StormByte::VideoConvert::Frontend::Task {
+	/* Sends a control command to the running daemon */
+	class Remote: public VideoConvert::Task::CLI::Base {
+		public:
+			Remote(const std::string& command, const std::vector<std::string>& arguments);
+			Remote(const Remote&) = default;
+			Remote(Remote&&) noexcept = default;
+			Remote& operator=(const Remote&) = default;
+			Remote& operator=(Remote&&) noexcept = default;
+			~Remote() noexcept = default;
+
+			/* Number of arguments each command needs, no value for unknown commands */
+			static std::optional<unsigned short> get_argument_count(const std::string& command);
+
+		private:
+			VideoConvert::Task::STATUS do_work(std::optional<pid_t>&) noexcept override;
+			/* Builds request from command line, throws std::runtime_error on invalid arguments */
+			Json::Value generate_request() const;
+			void display_status(const Json::Value& response) const;
+			void display_database_statements(const Json::Value& statements) const;
+
+			std::string m_command;
+			std::vector<std::string> m_arguments;
+
+			static const std::map<std::string, unsigned short> COMMAND_ARGUMENTS;
+			static const size_t DATABASE_STATEMENTS_SHOWN;
+	};
+}
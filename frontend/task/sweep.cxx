@@ -0,0 +1,374 @@
+#include "sweep.hxx"
+#include "configuration/configuration.hxx"
+#include "control/protocol.hxx"
+#include "utils/filesystem.hxx"
+#include "utils/display.hxx"
+#include "utils/system.hxx"
+
+#include <csignal>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <set>
+
+using namespace StormByte::VideoConvert;
+
+// Expected HEVC output size compared to source at similar quality, codecs not listed (HEVC itself, AV1, VP9...) are not worth converting
+const std::map<std::string, double> Frontend::Task::Sweep::HEVC_SIZE_RATIO = {
+	{ "mpeg1video",	0.25 },
+	{ "mpeg2video",	0.30 },
+	{ "msmpeg4v3",	0.45 },
+	{ "mpeg4",		0.45 },
+	{ "theora",		0.45 },
+	{ "wmv3",		0.50 },
+	{ "vc1",		0.50 },
+	{ "h264",		0.55 },
+	{ "vp8",		0.60 }
+};
+// Bitrate (bits per second) above which HEVC does not visibly improve so estimations are capped there
+const std::map<FFprobe::stream::RESOLUTION, uintmax_t> Frontend::Task::Sweep::HEVC_MAX_BITRATE = {
+	{ FFprobe::stream::RES_480P,	1500000 },
+	{ FFprobe::stream::RES_720P,	3000000 },
+	{ FFprobe::stream::RES_1080P,	6000000 },
+	{ FFprobe::stream::RES_4K,		20000000 },
+	{ FFprobe::stream::RES_8K,		50000000 }
+};
+// Film seconds encoded per second, only used while there is no encode history for the resolution
+const std::map<FFprobe::stream::RESOLUTION, double> Frontend::Task::Sweep::DEFAULT_ENCODE_SPEED = {
+	{ FFprobe::stream::RES_480P,	4.0 },
+	{ FFprobe::stream::RES_720P,	2.0 },
+	{ FFprobe::stream::RES_1080P,	1.0 },
+	{ FFprobe::stream::RES_4K,		0.25 },
+	{ FFprobe::stream::RES_8K,		0.06 }
+};
+const std::list<std::string> Frontend::Task::Sweep::HDR_TRANSFERS = { "smpte2084", "arib-std-b67" };
+const size_t Frontend::Task::Sweep::PROBE_BATCH_SIZE = 16;
+const size_t Frontend::Task::Sweep::INSERT_BATCH_SIZE = 200;
+const unsigned int Frontend::Task::Sweep::RANKING_DISPLAY = 20;
+
+Frontend::Task::Sweep::Sweep():VideoConvert::Task::CLI::Base() {
+	// Reset signals so app can be exited from CLI
+	signal(SIGTERM,	SIG_DFL);
+	signal(SIGINT,	SIG_DFL);
+	signal(SIGUSR1,	SIG_DFL);
+}
+
+Task::STATUS Frontend::Task::Sweep::pre_run_actions() noexcept {
+	assert(m_config);
+
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+
+	try {
+		m_database.reset(new Database::SQLite3(*config->get_database_file()));
+		m_client.reset(new Control::Client(config->get_control_socket()));
+		if (!m_client->connect())
+			m_client.reset();
+	}
+	catch (const std::exception& e) {
+		std::cerr << red(e.what()) << std::endl;
+		return VideoConvert::Task::HALT_ERROR;
+	}
+	m_hostname = Utils::System::get_hostname();
+
+	if (!std::filesystem::is_directory(*config->get_input_folder() / *config->get_sweep_parameter())) {
+		std::cerr << red("Folder " + config->get_sweep_parameter()->string() + " does not exist in input folder") << std::endl;
+		return VideoConvert::Task::HALT_ERROR;
+	}
+
+	return VideoConvert::Task::RUNNING;
+}
+
+StormByte::VideoConvert::Task::STATUS Frontend::Task::Sweep::do_work(std::optional<pid_t>&) noexcept {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+
+	try {
+		const Types::path_t folder = *config->get_sweep_parameter();
+		// Own index as files not worth converting must still be offered by --add
+		const Utils::Walker::index_t index = m_database->get_scan_index(folder, Database::Data::SWEEP_INDEX);
+		const Utils::Walker::scan_result scan = Utils::Walker(*config->get_input_folder()).scan(folder, index);
+
+		std::list<Types::path_t> files;
+		for (const auto& list: { std::cref(scan.m_changed), std::cref(scan.m_unchanged) })
+			for (auto it = list.get().begin(); it != list.get().end(); it++)
+				if (config->is_extension_supported(it->extension()) && !m_database->is_film_in_database(*it))
+					files.push_back(*it);
+		std::cout << "Found " << light_blue(files.size()) << " film(s) not yet queued" << std::endl;
+
+		std::vector<candidate> candidates;
+		for (const auto& probe: probe_files(files, scan, index)) {
+			auto item = estimate(probe);
+			if (item) candidates.push_back(std::move(*item));
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const candidate& a, const candidate& b) { return a.score() > b.score(); });
+		display_ranking(candidates);
+
+		// Queue order is insertion order for the same priority so best ones get converted first
+		unsigned int inserted = 0, duplicated = 0, skipped = 0;
+		std::set<std::pair<uintmax_t, uint64_t>> seen;
+		std::list<Database::Data::film> batch;
+		for (const auto& item: candidates) {
+			Database::Data::film film = generate_film(item);
+			bool duplicate = false;
+			if (film.m_content) {
+				const std::pair<uintmax_t, uint64_t> key { film.m_content->m_size, film.m_content->m_fingerprint };
+				duplicate = seen.contains(key) || m_database->find_duplicate(*film.m_content).has_value();
+				seen.insert(key);
+			}
+			if (duplicate)
+				duplicated++;
+			else
+				batch.push_back(std::move(film));
+
+			if (batch.size() >= INSERT_BATCH_SIZE || (&item == &candidates.back() && !batch.empty())) {
+				auto existing = write_batch(batch);
+				if (!existing) {
+					std::cerr << red("Could not queue films, " + std::to_string(inserted) + " were queued before the error") << std::endl;
+					return VideoConvert::Task::HALT_ERROR;
+				}
+				for (auto it = existing->begin(); it != existing->end(); it++)
+					std::cout << yellow("Film " + it->string() + " was queued meanwhile, skipping it") << std::endl;
+				skipped += existing->size();
+				inserted += batch.size() - existing->size();
+				batch.clear();
+			}
+		}
+
+		if (!update_scan_index(scan))
+			return VideoConvert::Task::HALT_ERROR;
+		std::cout << green("Queued " + std::to_string(inserted) + " film(s)");
+		if (duplicated > 0)
+			std::cout << yellow(", skipped " + std::to_string(duplicated) + " duplicated");
+		if (skipped > 0)
+			std::cout << yellow(", skipped " + std::to_string(skipped) + " queued meanwhile");
+		std::cout << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << red(e.what()) << std::endl;
+		return VideoConvert::Task::HALT_ERROR;
+	}
+
+	return VideoConvert::Task::HALT_OK;
+}
+
+std::list<Database::Data::probe_cache> Frontend::Task::Sweep::probe_files(const std::list<Types::path_t>& files, const Utils::Walker::scan_result& scan, const Utils::Walker::index_t& index) {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	std::list<Database::Data::probe_cache> result, probed;
+	std::vector<Database::Data::probe_cache> pending;
+
+	// Files keeping size and mtime reuse previous probe
+	for (auto it = files.begin(); it != files.end(); it++) {
+		auto signature = get_signature(*it, scan, index);
+		if (!signature) continue;
+		auto cached = m_database->get_probe_cache(*it, signature->m_size, signature->m_mtime);
+		if (cached)
+			result.push_back(std::move(*cached));
+		else {
+			Database::Data::probe_cache probe;
+			probe.m_file	= *it;
+			probe.m_size	= signature->m_size;
+			probe.m_mtime	= signature->m_mtime;
+			pending.push_back(std::move(probe));
+		}
+	}
+	if (!result.empty())
+		std::cout << gray(std::to_string(result.size()) + " film(s) were already probed") << std::endl;
+
+	for (size_t start = 0; start < pending.size(); start += PROBE_BATCH_SIZE) {
+		const size_t end = std::min(pending.size(), start + PROBE_BATCH_SIZE);
+		std::cout << "\rProbing " << light_blue(end) << " of " << pending.size() << std::flush;
+		std::vector<Types::path_t> batch;
+		for (size_t i = start; i < end; i++)
+			batch.push_back(*config->get_input_folder() / pending[i].m_file);
+
+		const auto probes = FFprobe::resolution_from_files(batch);
+		for (size_t i = start; i < end; i++) {
+			const FFprobe& data = probes[i - start];
+			Database::Data::probe_cache& probe = pending[i];
+			probe.m_video_codec	= data.get_video_codec();
+			probe.m_height		= data.get_height();
+			probe.m_bitrate		= data.get_bitrate();
+			probe.m_duration	= data.get_duration();
+			probe.m_frame_rate	= data.get_frame_rate();
+			probe.m_is_HDR		= data.get_color_transfer() && std::find(HDR_TRANSFERS.begin(), HDR_TRANSFERS.end(), *data.get_color_transfer()) != HDR_TRANSFERS.end();
+			probed.push_back(probe);
+		}
+	}
+	if (!pending.empty())
+		std::cout << std::endl;
+
+	if (!probed.empty())
+		set_probe_cache(probed);
+	result.splice(result.end(), probed);
+	return result;
+}
+
+std::optional<Frontend::Task::Sweep::candidate> Frontend::Task::Sweep::estimate(const Database::Data::probe_cache& probe) {
+	if (!probe.m_video_codec || !HEVC_SIZE_RATIO.contains(*probe.m_video_codec) || !probe.m_height || !probe.m_duration || *probe.m_duration <= 0)
+		return {};
+	auto resolution = FFprobe::resolution_from_height(*probe.m_height);
+	if (!resolution)
+		return {};
+
+	// Audio and subtitles are copied but they are usually a small part of the container bitrate
+	const double source_bitrate = probe.m_bitrate ? *probe.m_bitrate : probe.m_size * 8 / *probe.m_duration;
+	const double target_bitrate = std::min(source_bitrate * HEVC_SIZE_RATIO.at(*probe.m_video_codec), static_cast<double>(HEVC_MAX_BITRATE.at(*resolution)));
+	const double target_size = target_bitrate * *probe.m_duration / 8;
+	if (target_size >= probe.m_size)
+		return {};
+
+	// Encode history gives real speed of this host, defaults are a rough guess until then
+	Database::Data::film film;
+	film.m_duration = probe.m_duration;
+	film.m_resolution = *resolution;
+	Database::Data::film::stream video;
+	video.m_codec = Database::Data::film::stream::VIDEO_HEVC;
+	film.m_streams.push_back(video);
+	const double encode_time = m_database->estimate_encode_time(film, m_hostname).value_or(*probe.m_duration / DEFAULT_ENCODE_SPEED.at(*resolution));
+
+	return candidate { probe, *resolution, static_cast<uintmax_t>(probe.m_size - target_size), std::max(encode_time, 1.0) };
+}
+
+Database::Data::film Frontend::Task::Sweep::generate_film(const candidate& item) const {
+	const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
+	Database::Data::film film;
+	film.m_file			= item.m_probe.m_file;
+	film.m_priority		= Database::Data::film::LOW; // So films added by hand are converted first
+	film.m_duration		= item.m_probe.m_duration;
+	film.m_resolution	= item.m_resolution;
+	film.m_frame_rate	= item.m_probe.m_frame_rate;
+	try {
+		const auto fingerprint = Utils::Filesystem::fingerprint(*config->get_input_folder() / film.m_file);
+		film.m_content = { fingerprint.first, fingerprint.second };
+	}
+	catch (const std::exception&) {} // Then it is just not checked for duplicates
+
+	// Same streams than when adding a folder
+	Database::Data::film::stream video, audio, subtitle;
+	video.m_id = 0;
+	video.m_codec = Database::Data::film::stream::VIDEO_HEVC;
+	#ifdef ENABLE_HEVC
+	// Full probe is only needed to keep HDR metadata
+	if (item.m_probe.m_is_HDR) {
+		const FFprobe probe = FFprobe::from_file(*config->get_input_folder() / film.m_file);
+		if (probe.is_HDR_detected() || probe.is_HDR_factible())
+			video.m_hdr = probe.get_HDR().data();
+	}
+	#endif
+	audio.m_id = -1;
+	audio.m_codec = Database::Data::film::stream::AUDIO_COPY;
+	subtitle.m_id = -1;
+	subtitle.m_codec = Database::Data::film::stream::SUBTITLE_COPY;
+	film.m_streams = { video, audio, subtitle };
+
+	return film;
+}
+
+std::optional<std::list<Types::path_t>> Frontend::Task::Sweep::write_batch(const std::list<Database::Data::film>& films) {
+	if (!m_client)
+		return m_database->insert_new_films(films);
+
+	std::optional<std::list<Types::path_t>> result;
+	try {
+		Json::Value request = Control::Protocol::request("enqueue");
+		request["skip_existing"] = true;
+		for (auto it = films.begin(); it != films.end(); it++)
+			request["films"].append(Control::Protocol::film_to_json(*it));
+		Json::Value response = m_client->request(request);
+		if (response["ok"].asBool()) {
+			result = std::list<Types::path_t>();
+			for (Json::Value::ArrayIndex i = 0; i < response["skipped"].size(); i++)
+				result->push_back(response["skipped"][i].asString());
+		}
+		else
+			std::cerr << red("Daemon refused request: " + response["error"].asString()) << std::endl;
+	}
+	catch (const std::exception& e) {
+		std::cerr << red(e.what()) << std::endl;
+	}
+	return result;
+}
+
+bool Frontend::Task::Sweep::update_scan_index(const Utils::Walker::scan_result& scan) {
+	if (!m_client) {
+		m_database->update_scan_index(scan, Database::Data::SWEEP_INDEX);
+		return true;
+	}
+
+	Json::Value request = Control::Protocol::request("index");
+	request["index"] = Database::Data::SWEEP_INDEX;
+	request["scan"] = Control::Protocol::scan_to_json(scan);
+	return send_to_daemon(request);
+}
+
+void Frontend::Task::Sweep::set_probe_cache(const std::list<Database::Data::probe_cache>& probes) {
+	if (!m_client) {
+		m_database->set_probe_cache(probes);
+		return;
+	}
+
+	Json::Value request = Control::Protocol::request("probes");
+	for (auto it = probes.begin(); it != probes.end(); it++)
+		request["probes"].append(Control::Protocol::probe_to_json(*it));
+	// Cache is only an optimization so sweep goes on without it
+	if (!send_to_daemon(request))
+		std::cerr << yellow("Probe results could not be cached, they will be probed again next time") << std::endl;
+}
+
+bool Frontend::Task::Sweep::send_to_daemon(const Json::Value& request) {
+	try {
+		Json::Value response = m_client->request(request);
+		if (!response["ok"].asBool())
+			std::cerr << red("Daemon refused request: " + response["error"].asString()) << std::endl;
+		return response["ok"].asBool();
+	}
+	catch (const std::exception& e) {
+		std::cerr << red(e.what()) << std::endl;
+		return false;
+	}
+}
+
+void Frontend::Task::Sweep::display_ranking(const std::vector<candidate>& candidates) const {
+	if (candidates.empty()) {
+		std::cout << gray("No film is worth converting") << std::endl;
+		return;
+	}
+
+	double savings = 0, encode_time = 0;
+	for (const auto& item: candidates) {
+		savings += item.m_savings;
+		encode_time += item.m_encode_time;
+	}
+
+	std::cout << green("Best films to convert") << gray(" (estimated savings, encode time and savings per encode hour)") << ":" << std::endl;
+	for (size_t i = 0; i < std::min<size_t>(candidates.size(), RANKING_DISPLAY); i++) {
+		const candidate& item = candidates[i];
+		std::cout	<< "\t" << light_blue(size_to_string(item.m_savings))
+					<< "\t" << Utils::Display::duration_to_string(std::chrono::seconds(static_cast<long>(item.m_encode_time)))
+					<< "\t" << size_to_string(item.score() * 3600) << "/h"
+					<< "\t" << gray(*item.m_probe.m_video_codec + " " + FFprobe::stream::RESOLUTION_STRING.at(item.m_resolution))
+					<< " " << item.m_probe.m_file.string() << std::endl;
+	}
+	if (candidates.size() > RANKING_DISPLAY)
+		std::cout << gray("\t... and " + std::to_string(candidates.size() - RANKING_DISPLAY) + " more") << std::endl;
+	std::cout	<< "Total: " << light_blue(candidates.size()) << " film(s) saving about " << light_blue(size_to_string(savings))
+				<< " in " << light_blue(Utils::Display::duration_to_string(std::chrono::seconds(static_cast<long>(encode_time)))) << std::endl;
+}
+
+std::optional<Utils::Walker::file_signature> Frontend::Task::Sweep::get_signature(const Types::path_t& file, const Utils::Walker::scan_result& scan, const Utils::Walker::index_t& index) {
+	// Folders read in this scan have fresh signatures, the rest are unchanged from index
+	const Types::path_t folder = file.parent_path();
+	const std::string name = file.filename();
+	auto updated = scan.m_updated.find(folder);
+	if (updated != scan.m_updated.end())
+		return updated->second.m_files.contains(name) ? updated->second.m_files.at(name) : std::optional<Utils::Walker::file_signature>();
+	auto indexed = index.find(folder);
+	if (indexed != index.end() && indexed->second.m_files.contains(name))
+		return indexed->second.m_files.at(name);
+	return {};
+}
+
+std::string Frontend::Task::Sweep::size_to_string(const double& bytes) {
+	std::ostringstream result;
+	result << std::fixed << std::setprecision(1) << bytes / (1 << 30) << " GiB";
+	return result.str();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "task/cli/base.hxx"
+#include "ffprobe/ffprobe.hxx"
+#include "database/sqlite3.hxx"
+#include "control/client.hxx"
+
+#include <vector>
+
+namespace StormByte::VideoConvert::Frontend::Task {
+	/* Finds films in a folder worth converting to HEVC and queues them by storage recovered per CPU hour */
+	class Sweep: public VideoConvert::Task::CLI::Base {
+		public:
+			Sweep();
+			Sweep(const Sweep&) = delete;
+			Sweep(Sweep&&) noexcept = delete;
+			Sweep& operator=(const Sweep&) = delete;
+			Sweep& operator=(Sweep&&) noexcept = delete;
+			~Sweep() noexcept = default;
+
+		private:
+			struct candidate {
+				Database::Data::probe_cache m_probe;
+				FFprobe::stream::RESOLUTION m_resolution;
+				uintmax_t m_savings; // Estimated bytes
+				double m_encode_time; // Estimated seconds
+				inline double score() const { return m_savings / m_encode_time; }
+			};
+
+			VideoConvert::Task::STATUS pre_run_actions() noexcept override;
+			VideoConvert::Task::STATUS do_work(std::optional<pid_t>&) noexcept override;
+
+			std::list<Database::Data::probe_cache> probe_files(const std::list<Types::path_t>& files, const Utils::Walker::scan_result& scan, const Utils::Walker::index_t& index);
+			std::optional<candidate> estimate(const Database::Data::probe_cache& probe);
+			Database::Data::film generate_film(const candidate& item) const;
+			/* Writes go through daemon when it is running so it stays the only database writer */
+			/* Films queued meanwhile are skipped, returns their files (no value if batch failed) */
+			std::optional<std::list<Types::path_t>> write_batch(const std::list<Database::Data::film>& films);
+			bool update_scan_index(const Utils::Walker::scan_result& scan);
+			void set_probe_cache(const std::list<Database::Data::probe_cache>& probes);
+			bool send_to_daemon(const Json::Value& request);
+			void display_ranking(const std::vector<candidate>& candidates) const;
+			static std::optional<Utils::Walker::file_signature> get_signature(const Types::path_t& file, const Utils::Walker::scan_result& scan, const Utils::Walker::index_t& index);
+			static std::string size_to_string(const double& bytes);
+
+			Types::database_t m_database;
+			std::unique_ptr<Control::Client> m_client; // Only when daemon is listening
+			std::string m_hostname;
+
+			static const std::map<std::string, double> HEVC_SIZE_RATIO;
+			static const std::map<FFprobe::stream::RESOLUTION, uintmax_t> HEVC_MAX_BITRATE;
+			static const std::map<FFprobe::stream::RESOLUTION, double> DEFAULT_ENCODE_SPEED;
+			static const std::list<std::string> HDR_TRANSFERS;
+			static const size_t PROBE_BATCH_SIZE, INSERT_BATCH_SIZE;
+			static const unsigned int RANKING_DISPLAY;
+	};
+}
@@ -1,17 +1,32 @@
 #include "test.hxx"
 #include "configuration/configuration.hxx"
+#include "utils/hash.hxx"
 
 #include <assert.h>
+#include <iomanip>
+#include <sstream>
 
 using namespace StormByte::VideoConvert;
 
+// Expected values come from the xxHash reference implementation, inputs cover every tail length path and the 32 byte stripes
+const std::list<Frontend::Task::Test::hash_vector> Frontend::Task::Test::HASH_VECTORS = {
+	{ "",								0,						0xef46db3751d8e999 },
+	{ "a",								0,						0xd24ec4f1a98c6e5b },
+	{ "abc",							0,						0x44bc2cf5ad770999 },
+	{ "abc",							1,						0xbea9ca8199328908 },
+	{ "message digest",					0,						0x066ed728fceeb3be },
+	{ "abcdefghijklmnopqrstuvwxyz",		0,						0xcfe1f278fa89835c },
+	{ byte_pattern(1024),				0,						0x6f3914f18fe4df57 },
+	{ byte_pattern(1024),				0x9e3779b185ebca87,		0xdac5100d94914d1d }
+};
+
 Task::STATUS Frontend::Task::Test::pre_run_actions() noexcept {
 	VideoConvert::Task::STATUS status = VideoConvert::Task::RUNNING;
 	
 	assert(m_config);
 	try {
 		const Frontend::Configuration* const config = dynamic_cast<Frontend::Configuration*>(m_config.get());
-		m_logger.reset(new Utils::Logger(*config->get_log_file(), static_cast<Utils::Logger::LEVEL>(*config->get_log_level())));
+		m_logger.reset(new Utils::Logger(*config->get_log_file(), static_cast<Utils::Logger::LEVEL>(*config->get_log_level()), config->get_log_format() == "json" ? Utils::Logger::FORMAT_JSON : Utils::Logger::FORMAT_TEXT));
 		m_database.reset(new Database::SQLite3(*config->get_database_file(), m_logger));
 	}
 	catch (const std::exception& e) {
@@ -23,6 +38,30 @@ Task::STATUS Frontend::Task::Test::pre_run_actions() noexcept {
 }
 
 StormByte::VideoConvert::Task::STATUS Frontend::Task::Test::do_work(std::optional<pid_t>&) noexcept {
+	if (!check_hash())
+		return VideoConvert::Task::HALT_ERROR;
+
 	std::cout << green("Test is successful") << std::endl;
 	return VideoConvert::Task::HALT_OK;
 }
+
+bool Frontend::Task::Test::check_hash() const {
+	bool result = true;
+	for (auto it = HASH_VECTORS.begin(); it != HASH_VECTORS.end(); it++) {
+		const uint64_t hash = Utils::Hash::xxh64(it->m_input.data(), it->m_input.size(), it->m_seed);
+		if (hash != it->m_expected) {
+			std::stringstream message;
+			message << "XXH64 of " << it->m_input.size() << " bytes with seed " << std::hex << std::setfill('0') << it->m_seed << " is " << std::setw(16) << hash << " instead of " << std::setw(16) << it->m_expected;
+			std::cerr << red(message.str()) << std::endl;
+			result = false;
+		}
+	}
+	return result;
+}
+
+std::string Frontend::Task::Test::byte_pattern(const size_t& size) {
+	std::string result;
+	for (size_t i = 0; i < size; i++)
+		result.push_back(static_cast<char>(i % 256));
+	return result;
+}
@@ -4,6 +4,9 @@
 #include "utils/logger.hxx"
 #include "database/sqlite3.hxx"
 
+#include <list>
+#include <string>
+
 namespace StormByte::VideoConvert::Frontend::Task {	
 	class Test: public VideoConvert::Task::CLI::Base {
 		public:
@@ -17,8 +20,20 @@ namespace StormByte::VideoConvert::Frontend::Task {
 		private:
 			VideoConvert::Task::STATUS pre_run_actions() noexcept override;
 			VideoConvert::Task::STATUS do_work(std::optional<pid_t>&) noexcept override;
+			/* Content fingerprints are stored in database so hashing must keep matching xxHash reference values */
+			bool check_hash() const;
+			/* Bytes 0 to 255 repeated up to size */
+			static std::string byte_pattern(const size_t& size);
+
+			struct hash_vector {
+				std::string m_input;
+				uint64_t m_seed;
+				uint64_t m_expected;
+			};
 
 			Types::logger_t m_logger;
 			Types::database_t m_database;
+
+			static const std::list<hash_vector> HASH_VECTORS;
 	};
 }
\ No newline at end of file
@@ -4,12 +4,13 @@
 
 using namespace StormByte::VideoConvert;
 
-Configuration::Base::Base(const std::list<std::string>& mandatory_string, const std::list<std::string>& mandatory_int, const std::list<std::string>& optional_string, const std::list<std::string>& optional_int):m_mandatory_string_values(mandatory_string), m_mandatory_int_values(mandatory_int), m_optional_string_values(optional_string), m_optional_int_values(optional_int) {}
+Configuration::Base::Base(const std::list<std::string>& mandatory_string, const std::list<std::string>& mandatory_int, const std::list<std::string>& optional_string, const std::list<std::string>& optional_int, const std::list<std::string>& optional_group_list):m_mandatory_string_values(mandatory_string), m_mandatory_int_values(mandatory_int), m_optional_string_values(optional_string), m_optional_int_values(optional_int), m_optional_group_list_values(optional_group_list) {}
 
 void Configuration::Base::parse(const Types::path_t& file) noexcept {
 	m_errors.clear();
 	m_values_int.clear();
 	m_values_string.clear();
+	m_values_group_list.clear();
 
 	libconfig::Config cfg;
 	std::string config_file = file;
@@ -55,6 +56,33 @@ void Configuration::Base::parse(const Types::path_t& file) noexcept {
 					m_errors.emplace(item, "Value is not an integer");
 			}
 		}
+
+		for (std::string item: m_optional_group_list_values) {
+			if (cfg.exists(item)) {
+				const libconfig::Setting& list = cfg.lookup(item);
+				std::list<group_t> value;
+				bool valid = list.isList();
+				for (int i = 0; valid && i < list.getLength(); i++) {
+					const libconfig::Setting& group = list[i];
+					valid = group.isGroup();
+					group_t group_value;
+					for (int j = 0; valid && j < group.getLength(); j++) {
+						const libconfig::Setting& setting = group[j];
+						if (setting.getType() == libconfig::Setting::TypeString)
+							group_value[setting.getName()] = static_cast<std::string>(setting);
+						else if (setting.getType() == libconfig::Setting::TypeInt)
+							group_value[setting.getName()] = std::to_string(static_cast<int>(setting));
+						else
+							valid = false;
+					}
+					value.push_back(std::move(group_value));
+				}
+				if (valid)
+					set_group_list_value(item, value);
+				else
+					m_errors.emplace(item, "Value is not a list of groups with string or integer values");
+			}
+		}
 	}
 }
 
@@ -66,6 +94,10 @@ void Configuration::Base::merge(const Base& config) {
 	for (auto it = config.m_values_int.begin(); it != config.m_values_int.end(); it++) {
 		set_int_value(it->first, it->second);
 	}
+
+	for (auto it = config.m_values_group_list.begin(); it != config.m_values_group_list.end(); it++) {
+		set_group_list_value(it->first, it->second);
+	}
 }
 
 void Configuration::Base::merge(Base&& config) noexcept {
@@ -78,6 +110,11 @@ void Configuration::Base::merge(Base&& config) noexcept {
 		m_errors.erase(it->first);
 		m_values_int.emplace(std::move(*it));
 	}
+
+	for (auto it = std::make_move_iterator(config.m_values_group_list.begin()); it != std::make_move_iterator(config.m_values_group_list.end()); it++) {
+		m_errors.erase(it->first);
+		m_values_group_list.emplace(std::move(*it));
+	}
 }
 
 bool Configuration::Base::have_all_mandatory_values() const {
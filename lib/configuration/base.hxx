@@ -8,7 +8,9 @@
 namespace StormByte::VideoConvert::Configuration {
 	class Base {
 		public:
-			Base(const std::list<std::string>& mandatory_string, const std::list<std::string>& mandatory_int, const std::list<std::string>& optional_string, const std::list<std::string>& optional_int);
+			/* Group list values are lists of groups like ( { key = "value"; }, { key = 1; } ), their values are all stored as strings */
+			using group_t = std::map<std::string, std::string>;
+			Base(const std::list<std::string>& mandatory_string, const std::list<std::string>& mandatory_int, const std::list<std::string>& optional_string, const std::list<std::string>& optional_int, const std::list<std::string>& optional_group_list = {});
 			Base(const Base&) = default;
 			Base(Base&&) noexcept = default;
 			Base& operator=(const Base&) = default;
@@ -28,9 +30,11 @@ namespace StormByte::VideoConvert::Configuration {
 			inline void set_int_value(const std::string& key, const int& value)				{ m_values_int.emplace(key, value); m_errors.erase(key); }
 			inline void set_string_value(const std::string& key, const std::string& value)	{ m_values_string.emplace(key, value); m_errors.erase(key); }
 			inline void set_string_value(const std::string& key, std::string&& value)		{ m_values_string.emplace(key, std::move(value)); m_errors.erase(key); }
+			inline void set_group_list_value(const std::string& key, const std::list<group_t>& value)	{ m_values_group_list.emplace(key, value); m_errors.erase(key); }
 
 			std::map<std::string, std::string> m_values_string;
 			std::map<std::string, int> m_values_int;
+			std::map<std::string, std::list<group_t>> m_values_group_list;
 			mutable std::map<std::string, std::string> m_errors;
 
 		private:
@@ -38,5 +42,6 @@ namespace StormByte::VideoConvert::Configuration {
 			const std::list<std::string> m_mandatory_int_values;
 			const std::list<std::string> m_optional_string_values;
 			const std::list<std::string> m_optional_int_values;
+			const std::list<std::string> m_optional_group_list_values;
 	};
 }
@@ -0,0 +1,34 @@
+#include "client.hxx"
+#include "protocol.hxx"
+
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/write.hpp>
+
+using namespace StormByte::VideoConvert;
+namespace asio = boost::asio;
+
+Control::Client::Client(const Types::path_t& socket_file):m_socket_file(socket_file), m_socket(m_ios) {}
+
+bool Control::Client::connect() noexcept {
+	std::error_code error;
+	if (!std::filesystem::is_socket(m_socket_file, error))
+		return false;
+	boost::system::error_code ec;
+	m_socket.connect(asio::local::stream_protocol::endpoint(m_socket_file.string()), ec);
+	return !ec;
+}
+
+Json::Value Control::Client::request(const Json::Value& request) {
+	try {
+		asio::write(m_socket, asio::buffer(Protocol::serialize(request)));
+		const size_t n = asio::read_until(m_socket, asio::dynamic_buffer(m_buffer), '\n');
+		auto response = Protocol::parse(m_buffer.substr(0, n));
+		m_buffer.erase(0, n);
+		if (!response)
+			throw std::runtime_error("Malformed response from daemon");
+		return *response;
+	}
+	catch (const boost::system::system_error& e) {
+		throw std::runtime_error("Control socket " + m_socket_file.string() + ": " + e.what());
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "types.hxx"
+
+#include <jsoncpp/json/json.h>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+
+namespace StormByte::VideoConvert::Control {
+	/* Sends requests to a running daemon through its control socket */
+	class Client {
+		public:
+			Client(const Types::path_t& socket_file);
+			Client(const Client&) = delete;
+			Client(Client&&) = delete;
+			Client& operator=(const Client&) = delete;
+			Client& operator=(Client&&) = delete;
+			~Client() = default;
+
+			/* False when there is no daemon listening */
+			bool connect() noexcept;
+			/* Blocks until response is received, throws std::runtime_error on communication errors */
+			Json::Value request(const Json::Value& request);
+
+		private:
+			Types::path_t m_socket_file;
+			boost::asio::io_context m_ios;
+			boost::asio::local::stream_protocol::socket m_socket;
+			std::string m_buffer;
+	};
+}
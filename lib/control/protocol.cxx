@@ -0,0 +1,227 @@
+#include "protocol.hxx"
+
+#include <memory>
+
+using namespace StormByte::VideoConvert;
+
+std::string Control::Protocol::serialize(const Json::Value& message) {
+	Json::StreamWriterBuilder builder;
+	builder["indentation"] = ""; // Newlines inside strings are escaped so this is a single line
+	return Json::writeString(builder, message) + "\n";
+}
+
+std::optional<Json::Value> Control::Protocol::parse(const std::string& line) {
+	Json::Reader reader;
+	Json::Value root;
+	std::optional<Json::Value> result;
+	try {
+		if (reader.parse(line, root, false) && root.isObject())
+			result = std::move(root);
+	}
+	catch (const std::exception&) {
+		// Malformed message, caller will report it
+	}
+	return result;
+}
+
+Json::Value Control::Protocol::request(const std::string& command) {
+	Json::Value result(Json::objectValue);
+	result["command"] = command;
+	return result;
+}
+
+Json::Value Control::Protocol::response() {
+	Json::Value result(Json::objectValue);
+	result["ok"] = true;
+	return result;
+}
+
+Json::Value Control::Protocol::error(const std::string& message) {
+	Json::Value result(Json::objectValue);
+	result["ok"] = false;
+	result["error"] = message;
+	return result;
+}
+
+Json::Value Control::Protocol::film_to_json(const Database::Data::film& film) {
+	Json::Value result(Json::objectValue);
+	result["file"]		= film.m_file.string();
+	result["priority"]	= film.m_priority;
+	if (film.m_title)		result["title"]			= film.m_title->string();
+	if (film.m_group) {
+		result["group"]["id"]		= film.m_group->id;
+		result["group"]["folder"]	= film.m_group->folder.string();
+	}
+	if (film.m_duration)	result["duration"]		= *film.m_duration;
+	if (film.m_resolution)	result["resolution"]	= *film.m_resolution;
+	if (film.m_frame_rate)	result["frame_rate"]	= *film.m_frame_rate;
+	if (film.m_content) {
+		result["size"]			= Json::UInt64(film.m_content->m_size);
+		result["fingerprint"]	= Json::UInt64(film.m_content->m_fingerprint);
+	}
+	result["streams"] = Json::Value(Json::arrayValue);
+	for (auto it = film.m_streams.begin(); it != film.m_streams.end(); it++)
+		result["streams"].append(stream_to_json(*it));
+	return result;
+}
+
+Database::Data::film Control::Protocol::film_from_json(const Json::Value& json) {
+	if (!json.isObject() || !json["file"].isString() || !json["streams"].isArray())
+		throw std::runtime_error("Film needs file and streams");
+
+	Database::Data::film film;
+	film.m_file = json["file"].asString();
+	if (json["priority"].isUInt()) {
+		if (json["priority"].asUInt() >= Database::Data::film::MAX)
+			throw std::runtime_error("Invalid priority " + json["priority"].asString());
+		film.m_priority = static_cast<Database::Data::film::priority>(json["priority"].asUInt());
+	}
+	if (json["title"].isString())		film.m_title		= json["title"].asString();
+	if (json["group"].isObject())		film.m_group		= { json["group"]["id"].asUInt(), json["group"]["folder"].asString() };
+	if (json["duration"].isNumeric())	film.m_duration		= json["duration"].asDouble();
+	if (json["resolution"].isUInt())	film.m_resolution	= static_cast<unsigned short>(json["resolution"].asUInt());
+	if (json["frame_rate"].isNumeric())	film.m_frame_rate	= json["frame_rate"].asDouble();
+	if (json["size"].isUInt64() && json["fingerprint"].isUInt64())
+		film.m_content = { json["size"].asUInt64(), json["fingerprint"].asUInt64() };
+	for (Json::Value::ArrayIndex i = 0; i < json["streams"].size(); i++)
+		film.m_streams.push_back(stream_from_json(json["streams"][i]));
+	return film;
+}
+
+Json::Value Control::Protocol::scan_to_json(const Utils::Walker::scan_result& scan) {
+	Json::Value result(Json::objectValue);
+	result["removed"] = Json::Value(Json::arrayValue);
+	for (auto it = scan.m_removed.begin(); it != scan.m_removed.end(); it++)
+		result["removed"].append(it->string());
+	result["updated"] = Json::Value(Json::arrayValue);
+	for (auto it = scan.m_updated.begin(); it != scan.m_updated.end(); it++) {
+		Json::Value folder(Json::objectValue);
+		folder["folder"]	= it->first.string();
+		folder["mtime"]		= Json::Int64(it->second.m_mtime);
+		folder["inode"]		= Json::UInt64(it->second.m_inode);
+		folder["files"]		= Json::Value(Json::objectValue);
+		for (auto file = it->second.m_files.begin(); file != it->second.m_files.end(); file++) {
+			folder["files"][file->first]["size"]	= Json::UInt64(file->second.m_size);
+			folder["files"][file->first]["mtime"]	= Json::Int64(file->second.m_mtime);
+		}
+		result["updated"].append(std::move(folder));
+	}
+	return result;
+}
+
+Utils::Walker::scan_result Control::Protocol::scan_from_json(const Json::Value& json) {
+	if (!json.isObject() || !json["removed"].isArray() || !json["updated"].isArray())
+		throw std::runtime_error("Scan index needs removed and updated folders");
+
+	Utils::Walker::scan_result scan;
+	for (Json::Value::ArrayIndex i = 0; i < json["removed"].size(); i++) {
+		if (!json["removed"][i].isString())
+			throw std::runtime_error("Removed folder is not a path");
+		scan.m_removed.push_back(json["removed"][i].asString());
+	}
+	for (Json::Value::ArrayIndex i = 0; i < json["updated"].size(); i++) {
+		const Json::Value& folder = json["updated"][i];
+		if (!folder["folder"].isString() || !folder["mtime"].isInt64() || !folder["inode"].isUInt64() || !folder["files"].isObject())
+			throw std::runtime_error("Updated folder needs folder, mtime, inode and files");
+		Utils::Walker::folder_index& index = scan.m_updated[folder["folder"].asString()];
+		index.m_mtime = folder["mtime"].asInt64();
+		index.m_inode = folder["inode"].asUInt64();
+		for (const auto& name: folder["files"].getMemberNames()) {
+			const Json::Value& file = folder["files"][name];
+			if (!file["size"].isUInt64() || !file["mtime"].isInt64())
+				throw std::runtime_error("Indexed file " + name + " needs size and mtime");
+			index.m_files[name] = { file["size"].asUInt64(), file["mtime"].asInt64() };
+		}
+	}
+	return scan;
+}
+
+Json::Value Control::Protocol::probe_to_json(const Database::Data::probe_cache& probe) {
+	Json::Value result(Json::objectValue);
+	result["file"]	= probe.m_file.string();
+	result["size"]	= Json::UInt64(probe.m_size);
+	result["mtime"]	= Json::Int64(probe.m_mtime);
+	result["hdr"]	= probe.m_is_HDR;
+	if (probe.m_video_codec)	result["video_codec"]	= *probe.m_video_codec;
+	if (probe.m_height)			result["height"]		= *probe.m_height;
+	if (probe.m_bitrate)		result["bitrate"]		= Json::UInt64(*probe.m_bitrate);
+	if (probe.m_duration)		result["duration"]		= *probe.m_duration;
+	if (probe.m_frame_rate)		result["frame_rate"]	= *probe.m_frame_rate;
+	return result;
+}
+
+Database::Data::probe_cache Control::Protocol::probe_from_json(const Json::Value& json) {
+	if (!json.isObject() || !json["file"].isString() || !json["size"].isUInt64() || !json["mtime"].isInt64())
+		throw std::runtime_error("Probe needs file, size and mtime");
+
+	Database::Data::probe_cache probe;
+	probe.m_file	= json["file"].asString();
+	probe.m_size	= json["size"].asUInt64();
+	probe.m_mtime	= json["mtime"].asInt64();
+	probe.m_is_HDR	= json["hdr"].asBool();
+	if (json["video_codec"].isString())	probe.m_video_codec	= json["video_codec"].asString();
+	if (json["height"].isUInt())		probe.m_height		= static_cast<unsigned short>(json["height"].asUInt());
+	if (json["bitrate"].isUInt64())		probe.m_bitrate		= json["bitrate"].asUInt64();
+	if (json["duration"].isNumeric())	probe.m_duration	= json["duration"].asDouble();
+	if (json["frame_rate"].isNumeric())	probe.m_frame_rate	= json["frame_rate"].asDouble();
+	return probe;
+}
+
+Json::Value Control::Protocol::stream_to_json(const Database::Data::film::stream& stream) {
+	Json::Value result(Json::objectValue);
+	result["id"]		= stream.m_id;
+	result["codec"]		= stream.m_codec;
+	result["animation"]	= stream.m_is_animation;
+	if (stream.m_max_rate)	result["max_rate"]	= *stream.m_max_rate;
+	if (stream.m_bitrate)	result["bitrate"]	= *stream.m_bitrate;
+	if (stream.m_hdr) {
+		Json::Value& hdr = result["hdr"];
+		hdr["red_x"]			= stream.m_hdr->red_x;
+		hdr["red_y"]			= stream.m_hdr->red_y;
+		hdr["green_x"]			= stream.m_hdr->green_x;
+		hdr["green_y"]			= stream.m_hdr->green_y;
+		hdr["blue_x"]			= stream.m_hdr->blue_x;
+		hdr["blue_y"]			= stream.m_hdr->blue_y;
+		hdr["white_point_x"]	= stream.m_hdr->white_point_x;
+		hdr["white_point_y"]	= stream.m_hdr->white_point_y;
+		hdr["luminance_min"]	= stream.m_hdr->luminance_min;
+		hdr["luminance_max"]	= stream.m_hdr->luminance_max;
+		if (stream.m_hdr->light_level) {
+			hdr["light_level"].append(stream.m_hdr->light_level->first);
+			hdr["light_level"].append(stream.m_hdr->light_level->second);
+		}
+	}
+	return result;
+}
+
+Database::Data::film::stream Control::Protocol::stream_from_json(const Json::Value& json) {
+	if (!json.isObject() || !json["id"].isInt() || !json["codec"].isUInt())
+		throw std::runtime_error("Stream needs id and codec");
+
+	Database::Data::film::stream stream;
+	stream.m_id				= static_cast<short>(json["id"].asInt());
+	stream.m_codec			= static_cast<Database::Data::film::stream::codec>(json["codec"].asUInt());
+	if (!Database::Data::film::stream::codec_string.contains(stream.m_codec) || stream.m_codec == Database::Data::film::stream::INVALID_CODEC)
+		throw std::runtime_error("Invalid codec " + json["codec"].asString());
+	stream.m_is_animation	= json["animation"].asBool();
+	if (json["max_rate"].isString())	stream.m_max_rate	= json["max_rate"].asString();
+	if (json["bitrate"].isString())		stream.m_bitrate	= json["bitrate"].asString();
+	if (json["hdr"].isObject()) {
+		const Json::Value& hdr = json["hdr"];
+		Database::Data::film::stream::hdr data;
+		data.red_x			= hdr["red_x"].asUInt();
+		data.red_y			= hdr["red_y"].asUInt();
+		data.green_x		= hdr["green_x"].asUInt();
+		data.green_y		= hdr["green_y"].asUInt();
+		data.blue_x			= hdr["blue_x"].asUInt();
+		data.blue_y			= hdr["blue_y"].asUInt();
+		data.white_point_x	= hdr["white_point_x"].asUInt();
+		data.white_point_y	= hdr["white_point_y"].asUInt();
+		data.luminance_min	= hdr["luminance_min"].asUInt();
+		data.luminance_max	= hdr["luminance_max"].asUInt();
+		if (hdr["light_level"].isArray() && hdr["light_level"].size() == 2)
+			data.light_level = std::make_pair(hdr["light_level"][0].asUInt(), hdr["light_level"][1].asUInt());
+		stream.m_hdr = data;
+	}
+	return stream;
+}
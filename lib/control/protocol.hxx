@@ -0,0 +1,36 @@
+#pragma once
+
+#include "database/data.hxx"
+#include "utils/walker.hxx"
+
+#include <string>
+#include <jsoncpp/json/json.h>
+
+namespace StormByte::VideoConvert::Control {
+	/* Control messages are JSON objects sent one per line, every request has a "command" and every response an "ok" member */
+	class Protocol {
+		public:
+			/* Single line representation including line terminator */
+			static std::string serialize(const Json::Value& message);
+			static std::optional<Json::Value> parse(const std::string& line);
+
+			static Json::Value request(const std::string& command);
+			static Json::Value response();
+			static Json::Value error(const std::string& message);
+
+			static Json::Value film_to_json(const Database::Data::film& film);
+			/* Throws std::runtime_error when mandatory data is missing */
+			static Database::Data::film film_from_json(const Json::Value& json);
+			/* Only folders to update or remove in scan index are sent, file lists are not needed to store it */
+			static Json::Value scan_to_json(const Utils::Walker::scan_result& scan);
+			/* Throws std::runtime_error when mandatory data is missing */
+			static Utils::Walker::scan_result scan_from_json(const Json::Value& json);
+			static Json::Value probe_to_json(const Database::Data::probe_cache& probe);
+			/* Throws std::runtime_error when mandatory data is missing */
+			static Database::Data::probe_cache probe_from_json(const Json::Value& json);
+
+		private:
+			static Json::Value stream_to_json(const Database::Data::film::stream& stream);
+			static Database::Data::film::stream stream_from_json(const Json::Value& json);
+	};
+}
@@ -0,0 +1,300 @@
+#include "server.hxx"
+#include "protocol.hxx"
+
+#include <csignal>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+using namespace StormByte::VideoConvert;
+namespace asio = boost::asio;
+
+const size_t Control::Server::MAX_REQUEST_SIZE = 64 << 20; // Enough for large groups
+// Persistent accept errors (like running out of file descriptors) would otherwise spin the server thread
+const std::chrono::milliseconds Control::Server::ACCEPT_RETRY_MIN_DELAY = std::chrono::milliseconds(100);
+const std::chrono::milliseconds Control::Server::ACCEPT_RETRY_MAX_DELAY = std::chrono::milliseconds(10000);
+
+Control::Server::Server(const Types::path_t& socket_file, const Types::path_t& dbfile, Types::logger_t logger, Types::profiler_t profiler):m_socket_file(socket_file), m_logger(logger), m_profiler(profiler), m_database(new Database::SQLite3(dbfile, logger, profiler)), m_paused(false) {}
+
+Control::Server::~Server() {
+	stop();
+}
+
+void Control::Server::start() {
+	// Caller has already checked no daemon is listening so this is a leftover from a crash
+	std::error_code error;
+	std::filesystem::remove(m_socket_file, error);
+	try {
+		m_acceptor.reset(new asio::local::stream_protocol::acceptor(m_ios, asio::local::stream_protocol::endpoint(m_socket_file.string())));
+	}
+	catch (const std::exception& e) {
+		throw std::runtime_error("Cannot listen on control socket " + m_socket_file.string() + ": " + e.what());
+	}
+	// Same access than the one needed to write database directly
+	chmod(m_socket_file.c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Listening for control requests on ", m_socket_file);
+
+	asio::co_spawn(m_ios, listen(), asio::detached);
+
+	// Signals have to be delivered to main thread so they can interrupt its sleep
+	sigset_t all_signals, previous_signals;
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_BLOCK, &all_signals, &previous_signals);
+	m_thread = std::thread([this] { m_ios.run(); });
+	pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+}
+
+void Control::Server::stop() {
+	if (m_thread.joinable()) {
+		m_ios.stop();
+		m_thread.join();
+		std::error_code error;
+		std::filesystem::remove(m_socket_file, error);
+	}
+}
+
+void Control::Server::set_current(const unsigned int& film_id, const Types::path_t& file) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_current = std::make_pair(film_id, file);
+}
+
+void Control::Server::clear_current() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_current.reset();
+	m_cancelled.reset(); // Too late if it was not taken
+}
+
+void Control::Server::set_worker(const std::optional<pid_t>& pid) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_worker = pid;
+	// Cancel request came before encoder was started
+	if (m_worker && m_cancelled && m_current && m_current->first == *m_cancelled)
+		kill(*m_worker, SIGINT);
+}
+
+bool Control::Server::take_cancelled(const unsigned int& film_id) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const bool result = m_cancelled == film_id;
+	if (result) m_cancelled.reset();
+	return result;
+}
+
+asio::awaitable<void> Control::Server::listen() {
+	boost::system::error_code ec;
+	asio::steady_timer retry_timer(m_ios);
+	std::chrono::milliseconds retry_delay = ACCEPT_RETRY_MIN_DELAY;
+	while (m_acceptor->is_open()) {
+		asio::local::stream_protocol::socket socket = co_await m_acceptor->async_accept(asio::redirect_error(asio::use_awaitable, ec));
+		if (ec == asio::error::operation_aborted)
+			break;
+		else if (ec) {
+			m_logger->message_line(Utils::Logger::LEVEL_WARNING, "Control socket accept failed: ", ec.message(), ", retrying in ", retry_delay.count(), " ms");
+			retry_timer.expires_after(retry_delay);
+			co_await retry_timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+			retry_delay = std::min(retry_delay * 2, ACCEPT_RETRY_MAX_DELAY);
+			continue;
+		}
+		retry_delay = ACCEPT_RETRY_MIN_DELAY;
+		asio::co_spawn(m_ios, serve(std::move(socket)), asio::detached);
+	}
+}
+
+asio::awaitable<void> Control::Server::serve(asio::local::stream_protocol::socket socket) {
+	std::string buffer;
+	boost::system::error_code ec;
+	while (true) {
+		const size_t n = co_await asio::async_read_until(socket, asio::dynamic_buffer(buffer, MAX_REQUEST_SIZE), '\n', asio::redirect_error(asio::use_awaitable, ec));
+		if (ec) break; // Client closed connection or request was too big
+
+		auto request = Protocol::parse(buffer.substr(0, n));
+		buffer.erase(0, n);
+		Json::Value response;
+		try {
+			response = request ? handle(*request) : Protocol::error("Malformed request");
+		}
+		catch (const std::exception& e) {
+			response = Protocol::error(e.what());
+		}
+
+		co_await asio::async_write(socket, asio::buffer(Protocol::serialize(response)), asio::redirect_error(asio::use_awaitable, ec));
+		if (ec) break;
+	}
+}
+
+Json::Value Control::Server::handle(const Json::Value& request) {
+	const std::string command = request["command"].asString();
+	m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Control request: ", command);
+
+	if (command == "enqueue")
+		return handle_enqueue(request);
+	else if (command == "status")
+		return handle_status();
+	else if (command == "reprioritize")
+		return handle_reprioritize(request);
+	else if (command == "cancel")
+		return handle_cancel(request);
+	else if (command == "index")
+		return handle_index(request);
+	else if (command == "probes")
+		return handle_probes(request);
+	else if (command == "pause" || command == "resume") {
+		m_paused = command == "pause";
+		m_logger->message_line(Utils::Logger::LEVEL_NOTICE, m_paused ? "Queue paused" : "Queue resumed", " by control request");
+		if (!m_paused) wake_daemon();
+		return Protocol::response();
+	}
+	else
+		return Protocol::error("Unknown command " + command);
+}
+
+Json::Value Control::Server::handle_enqueue(const Json::Value& request) {
+	std::list<Database::Data::film> films;
+	for (Json::Value::ArrayIndex i = 0; i < request["films"].size(); i++)
+		films.push_back(Protocol::film_from_json(request["films"][i]));
+	if (films.empty())
+		return Protocol::error("No films to enqueue");
+
+	Json::Value response = Protocol::response();
+	if (request["skip_existing"].asBool() && !request["group"].isString()) {
+		// Batches added without asking: one film added meanwhile must not fail the others
+		auto skipped = m_database->insert_new_films(films);
+		if (!skipped)
+			return Protocol::error("Could not insert films");
+		response["skipped"] = Json::Value(Json::arrayValue);
+		for (auto it = skipped->begin(); it != skipped->end(); it++)
+			response["skipped"].append(it->string());
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Enqueued ", films.size() - skipped->size(), " film(s) by control request, ", skipped->size(), " already in database");
+		wake_daemon();
+		return response;
+	}
+	for (auto it = films.begin(); it != films.end(); it++)
+		if (m_database->is_film_in_database(*it))
+			return Protocol::error("Film " + it->m_file.string() + " is already in database");
+
+	if (request["group"].isString()) {
+		// Group is created here as its id is only known by database
+		auto group = m_database->insert_group(request["group"].asString());
+		if (!group)
+			return Protocol::error("Film group (folder) " + request["group"].asString() + " is already in database");
+		for (auto it = films.begin(); it != films.end(); it++)
+			it->m_group = group;
+		if (!m_database->insert_films(films)) {
+			m_database->delete_group(*group);
+			return Protocol::error("Could not insert films for group " + group->folder.string());
+		}
+		response["group"] = group->id;
+	}
+	else if (films.size() == 1) {
+		auto film_id = m_database->insert_film(films.front());
+		if (!film_id)
+			return Protocol::error("Could not insert film " + films.front().m_file.string());
+		response["id"] = *film_id;
+	}
+	else if (!m_database->insert_films(films))
+		return Protocol::error("Could not insert films");
+
+	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Enqueued ", films.size(), " film(s) by control request");
+	wake_daemon();
+	return response;
+}
+
+Json::Value Control::Server::handle_status() {
+	Json::Value response = Protocol::response();
+	response["paused"] = m_paused.load();
+	response["queued"] = m_database->get_queue_size();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_current) {
+			response["current"]["id"]	= m_current->first;
+			response["current"]["file"]	= m_current->second.string();
+		}
+	}
+	response["next"] = Json::Value(Json::arrayValue);
+	const auto next = m_database->get_next_films(10);
+	for (auto it = next.begin(); it != next.end(); it++) {
+		Json::Value film(Json::objectValue);
+		film["id"]		= *it->m_id;
+		film["file"]	= it->m_file.string();
+		response["next"].append(film);
+	}
+	if (m_profiler) {
+		response["database"] = Json::Value(Json::arrayValue);
+		const auto statements = m_profiler->get_statements();
+		for (auto it = statements.begin(); it != statements.end(); it++) {
+			Json::Value statement(Json::objectValue);
+			statement["name"]			= it->first;
+			statement["calls"]			= it->second.m_calls;
+			statement["total_ms"]		= std::chrono::duration<double, std::milli>(it->second.m_total_time).count();
+			statement["max_ms"]			= std::chrono::duration<double, std::milli>(it->second.m_max_time).count();
+			statement["rows_returned"]	= Json::UInt64(it->second.m_rows_returned);
+			statement["rows_scanned"]	= Json::UInt64(it->second.m_rows_scanned);
+			response["database"].append(statement);
+		}
+	}
+	return response;
+}
+
+Json::Value Control::Server::handle_reprioritize(const Json::Value& request) {
+	if (!request["id"].isUInt() || !request["priority"].isUInt() || request["priority"].asUInt() >= Database::Data::film::MAX)
+		return Protocol::error("Reprioritize needs film id and a priority between 0 and " + std::to_string(Database::Data::film::IMPORTANT));
+
+	const unsigned int film_id = request["id"].asUInt();
+	if (!m_database->set_film_priority(film_id, static_cast<Database::Data::film::priority>(request["priority"].asUInt())))
+		return Protocol::error("Film " + std::to_string(film_id) + " is not queued");
+	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Film ", film_id, " priority changed to ", request["priority"].asUInt(), " by control request");
+	return Protocol::response();
+}
+
+Json::Value Control::Server::handle_index(const Json::Value& request) {
+	Database::Data::scan_index index_name = Database::Data::ADD_INDEX;
+	if (request.isMember("index")) {
+		if (!request["index"].isUInt() || request["index"].asUInt() > Database::Data::SWEEP_INDEX)
+			return Protocol::error("Invalid scan index " + request["index"].asString());
+		index_name = static_cast<Database::Data::scan_index>(request["index"].asUInt());
+	}
+	const Utils::Walker::scan_result scan = Protocol::scan_from_json(request["scan"]);
+	m_database->update_scan_index(scan, index_name);
+	m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Scan index updated for ", scan.m_updated.size(), " folder(s) by control request");
+	return Protocol::response();
+}
+
+Json::Value Control::Server::handle_probes(const Json::Value& request) {
+	std::list<Database::Data::probe_cache> probes;
+	for (Json::Value::ArrayIndex i = 0; i < request["probes"].size(); i++)
+		probes.push_back(Protocol::probe_from_json(request["probes"][i]));
+	m_database->set_probe_cache(probes);
+	return Protocol::response();
+}
+
+Json::Value Control::Server::handle_cancel(const Json::Value& request) {
+	if (!request["id"].isUInt())
+		return Protocol::error("Cancel needs film id");
+
+	const unsigned int film_id = request["id"].asUInt();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_current && m_current->first == film_id) {
+			// Daemon removes the film from queue once encoder exits
+			m_cancelled = film_id;
+			if (m_worker) kill(*m_worker, SIGINT);
+			m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Cancelling conversion of film ", film_id, " by control request");
+			return Protocol::response();
+		}
+	}
+	if (!m_database->delete_queued_film(film_id))
+		return Protocol::error("Film " + std::to_string(film_id) + " is not queued");
+	m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Film ", film_id, " removed from queue by control request");
+	return Protocol::response();
+}
+
+void Control::Server::wake_daemon() const {
+	// Main thread is the only one not blocking signals, SIGUSR1 just interrupts its sleep
+	kill(getpid(), SIGUSR1);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "database/sqlite3.hxx"
+#include "utils/logger.hxx"
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <utility> // Boost 1.74 awaitable.hpp uses std::exchange without including it
+#include <jsoncpp/json/json.h>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+
+namespace StormByte::VideoConvert::Control {
+	/* Serves control requests from a unix socket so CLI does not need to write to database while daemon runs */
+	class Server {
+		public:
+			/* Status includes statement totals from profiler */
+			Server(const Types::path_t& socket_file, const Types::path_t& dbfile, Types::logger_t logger, Types::profiler_t profiler);
+			Server(const Server&) = delete;
+			Server(Server&&) = delete;
+			Server& operator=(const Server&) = delete;
+			Server& operator=(Server&&) = delete;
+			~Server();
+
+			/* Throws std::runtime_error if socket can not be created */
+			void start();
+			void stop();
+			inline bool is_paused() const { return m_paused; }
+			/* Film being converted by daemon */
+			void set_current(const unsigned int& film_id, const Types::path_t& file);
+			void clear_current();
+			/* Encoder process of current film so it can be cancelled, cleared before it is reaped so its pid is never reused meanwhile */
+			void set_worker(const std::optional<pid_t>& pid);
+			/* Whether conversion of film was interrupted due to a cancel request, resetting that request */
+			bool take_cancelled(const unsigned int& film_id);
+
+		private:
+			boost::asio::awaitable<void> listen();
+			boost::asio::awaitable<void> serve(boost::asio::local::stream_protocol::socket socket);
+			Json::Value handle(const Json::Value& request);
+			Json::Value handle_enqueue(const Json::Value& request);
+			Json::Value handle_status();
+			Json::Value handle_reprioritize(const Json::Value& request);
+			Json::Value handle_cancel(const Json::Value& request);
+			/* Folder scan index updates from --add and --sweep while daemon runs */
+			Json::Value handle_index(const Json::Value& request);
+			/* Probe results of sweeps run while daemon runs */
+			Json::Value handle_probes(const Json::Value& request);
+			/* Interrupts daemon sleep so changes are seen right away */
+			void wake_daemon() const;
+
+			Types::path_t m_socket_file;
+			Types::logger_t m_logger;
+			Types::profiler_t m_profiler;
+			Types::database_t m_database; // Own connection as it is used from server thread
+			boost::asio::io_context m_ios;
+			std::unique_ptr<boost::asio::local::stream_protocol::acceptor> m_acceptor;
+			std::thread m_thread;
+			std::atomic<bool> m_paused;
+			std::mutex m_mutex; // For all of below
+			std::optional<std::pair<unsigned int, Types::path_t>> m_current;
+			std::optional<unsigned int> m_cancelled;
+			std::optional<pid_t> m_worker;
+
+			static const size_t MAX_REQUEST_SIZE;
+			static const std::chrono::milliseconds ACCEPT_RETRY_MIN_DELAY, ACCEPT_RETRY_MAX_DELAY;
+	};
+}
@@ -11,9 +11,28 @@ CREATE TABLE films(
 	processing BOOL DEFAULT FALSE,
 	unsupported BOOL DEFAULT FALSE,
 	group_id INTEGER DEFAULT NULL,
+	duration REAL DEFAULT NULL,
+	resolution TINYINT DEFAULT NULL,
+	frame_rate REAL DEFAULT NULL,
+	size INTEGER DEFAULT NULL,
+	fingerprint INTEGER DEFAULT NULL,
+	stalls INTEGER DEFAULT 0,
+	retry_after DATETIME DEFAULT NULL,
 	FOREIGN KEY(group_id) REFERENCES groups(id) ON DELETE CASCADE
 );
 
+CREATE INDEX films_content ON films(size, fingerprint);
+
+CREATE TABLE converted_content(
+	id INTEGER PRIMARY KEY AUTOINCREMENT,
+	size INTEGER NOT NULL,
+	fingerprint INTEGER NOT NULL,
+	file VARCHAR NOT NULL,
+	converted DATETIME DEFAULT CURRENT_TIMESTAMP
+);
+
+CREATE INDEX converted_content_fingerprint ON converted_content(size, fingerprint);
+
 CREATE TABLE streams(
 	id INTEGER,
 	film_id INTEGER,
@@ -44,3 +63,77 @@ CREATE TABLE stream_hdr(
 	PRIMARY KEY (film_id, stream_id, codec),
 	FOREIGN KEY (film_id, stream_id, codec) REFERENCES streams(id, film_id, codec) ON DELETE CASCADE
 );
+
+CREATE TABLE encode_history(
+	id INTEGER PRIMARY KEY AUTOINCREMENT,
+	codec INTEGER NOT NULL,
+	resolution TINYINT NOT NULL,
+	is_hdr BOOL DEFAULT FALSE,
+	is_animation BOOL DEFAULT FALSE,
+	host VARCHAR NOT NULL,
+	duration REAL NOT NULL,
+	elapsed REAL NOT NULL,
+	frames REAL DEFAULT NULL,
+	peak_memory INTEGER DEFAULT NULL,
+	file VARCHAR DEFAULT NULL,
+	user_time REAL DEFAULT NULL,
+	system_time REAL DEFAULT NULL,
+	read_bytes INTEGER DEFAULT NULL,
+	write_bytes INTEGER DEFAULT NULL
+);
+
+CREATE INDEX encode_history_profile ON encode_history(codec, resolution, is_hdr, is_animation, host);
+
+CREATE TABLE finalizations(
+	id INTEGER PRIMARY KEY AUTOINCREMENT,
+	film_id INTEGER NOT NULL,
+	input_file VARCHAR NOT NULL,
+	work_file VARCHAR NOT NULL,
+	output_file VARCHAR NOT NULL,
+	action TINYINT NOT NULL,
+	group_id INTEGER DEFAULT NULL,
+	status TINYINT DEFAULT 0,
+	finished DATETIME DEFAULT NULL
+);
+
+CREATE INDEX finalizations_status ON finalizations(status);
+
+CREATE TABLE scan_folders(
+	folder VARCHAR PRIMARY KEY,
+	mtime INTEGER NOT NULL,
+	inode INTEGER NOT NULL
+);
+
+CREATE TABLE scan_files(
+	folder VARCHAR NOT NULL,
+	name VARCHAR NOT NULL,
+	size INTEGER NOT NULL,
+	mtime INTEGER NOT NULL,
+	PRIMARY KEY(folder, name)
+);
+
+CREATE TABLE sweep_folders(
+	folder VARCHAR PRIMARY KEY,
+	mtime INTEGER NOT NULL,
+	inode INTEGER NOT NULL
+);
+
+CREATE TABLE sweep_files(
+	folder VARCHAR NOT NULL,
+	name VARCHAR NOT NULL,
+	size INTEGER NOT NULL,
+	mtime INTEGER NOT NULL,
+	PRIMARY KEY(folder, name)
+);
+
+CREATE TABLE probe_cache(
+	file VARCHAR PRIMARY KEY,
+	size INTEGER NOT NULL,
+	mtime INTEGER NOT NULL,
+	video_codec VARCHAR DEFAULT NULL,
+	height INTEGER DEFAULT NULL,
+	bitrate INTEGER DEFAULT NULL,
+	duration REAL DEFAULT NULL,
+	frame_rate REAL DEFAULT NULL,
+	is_hdr BOOL DEFAULT FALSE
+);
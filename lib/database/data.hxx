@@ -79,5 +79,85 @@ namespace StormByte::VideoConvert::Database::Data {
 		bool m_unsupported = false;
 		std::optional<group> m_group;
 		std::list<stream> m_streams;
+		/* Probed data used for encode time estimations (no value means not probed) */
+		std::optional<double> m_duration; // In seconds
+		std::optional<unsigned short> m_resolution; // As in FFprobe::stream::RESOLUTION
+		std::optional<double> m_frame_rate;
+		/* Content identification for duplicate detection (no value means not fingerprinted) */
+		struct content {
+			uintmax_t m_size;
+			uint64_t m_fingerprint; // As in Utils::Filesystem::fingerprint
+		};
+		std::optional<content> m_content;
+	};
+
+	struct duplicate {
+		enum status: unsigned short {
+			QUEUED = 0,
+			PROCESSING,
+			CONVERTED
+		};
+
+		Types::path_t m_file; // The one already known
+		status m_status;
+	};
+
+	struct encode_history {
+		film::stream::codec m_codec;
+		unsigned short m_resolution; // As in FFprobe::stream::RESOLUTION
+		bool m_is_HDR = false;
+		bool m_is_animation = false;
+		std::string m_host;
+		double m_duration; // Film duration in seconds
+		double m_elapsed; // Encode time in seconds
+		std::optional<double> m_frames;
+		std::optional<uintmax_t> m_peak_memory; // Peak RSS of encoder in bytes
+		Types::path_t m_file; // Input film, relative to input folder
+		std::optional<double> m_user_time, m_system_time; // Encoder CPU seconds
+		std::optional<uintmax_t> m_read_bytes, m_write_bytes; // Encoder I/O which reached storage
+	};
+
+	struct finalization {
+		enum action: unsigned short {
+			MOVE = 0,
+			COPY,
+			PUBLISH // Work file is already in output filesystem so it is atomically renamed
+		};
+
+		enum status: unsigned short {
+			PENDING = 0,
+			DONE,
+			FAILED
+		};
+
+		std::optional<unsigned int> m_id; //No value means not in database
+		unsigned int m_film_id;
+		Types::path_t m_input_file, m_work_file, m_output_file; // Full paths
+		action m_action = MOVE;
+		std::optional<film::group> m_group;
+	};
+
+	/* Folder scan indexes are kept apart as sweep reads files it does not queue */
+	enum scan_index: unsigned short {
+		ADD_INDEX = 0,
+		SWEEP_INDEX
+	};
+
+	/* Cached FFprobe summary of a file, only valid while file keeps its size and mtime */
+	struct probe_cache {
+		Types::path_t m_file;
+		uintmax_t m_size;
+		int64_t m_mtime; // In nanoseconds
+		std::optional<std::string> m_video_codec;
+		std::optional<unsigned short> m_height;
+		std::optional<uintmax_t> m_bitrate; // Whole container in bits per second
+		std::optional<double> m_duration, m_frame_rate;
+		bool m_is_HDR = false;
+	};
+
+	struct queue_forecast {
+		unsigned int m_estimated = 0; // Films which could be estimated
+		unsigned int m_unknown = 0; // Films lacking data or history to be estimated
+		double m_seconds = 0;
 	};
 }
@@ -0,0 +1,30 @@
+#include "profiler.hxx"
+#include "utils/logger.hxx"
+
+#include <algorithm>
+
+using namespace StormByte::VideoConvert;
+
+const std::string Database::Profiler::EXCLUSIVE_TRANSACTION = "exclusiveTransaction";
+
+Database::Profiler::Profiler(const std::chrono::milliseconds& slow_threshold, Types::logger_t logger):m_slow_threshold(slow_threshold), m_logger(logger) {}
+
+void Database::Profiler::record(const std::string& name, const std::chrono::nanoseconds& time, const uintmax_t& rows_returned, const uintmax_t& rows_scanned) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		statement& item = m_statements[name];
+		item.m_calls++;
+		item.m_total_time += time;
+		item.m_max_time = std::max(item.m_max_time, time);
+		item.m_rows_returned += rows_returned;
+		item.m_rows_scanned += rows_scanned;
+	}
+
+	if (m_logger && m_slow_threshold.count() > 0 && time >= m_slow_threshold)
+		m_logger->message_line(Utils::Logger::LEVEL_WARNING, "Slow database statement ", name, " took ", std::chrono::duration<double, std::milli>(time).count(), " ms (", rows_returned, " rows returned, ", rows_scanned, " rows scanned)");
+}
+
+std::map<std::string, Database::Profiler::statement> Database::Profiler::get_statements() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_statements;
+}
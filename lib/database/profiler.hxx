@@ -0,0 +1,41 @@
+#pragma once
+
+#include "types.hxx"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace StormByte::VideoConvert::Database {
+	/* Statement statistics of every connection sharing it (daemon, finalizer and control server), fed by SQLite3 tracing */
+	class Profiler {
+		public:
+			struct statement {
+				unsigned int m_calls = 0;
+				std::chrono::nanoseconds m_total_time = std::chrono::nanoseconds(0), m_max_time = std::chrono::nanoseconds(0);
+				uintmax_t m_rows_returned = 0;
+				uintmax_t m_rows_scanned = 0; // Steps of full table scans, a lot more than returned means an index is missing
+			};
+
+			/* Statements slower than threshold are logged, zero disables it */
+			Profiler(const std::chrono::milliseconds& slow_threshold, Types::logger_t logger);
+			Profiler(const Profiler&) = delete;
+			Profiler(Profiler&&) = delete;
+			Profiler& operator=(const Profiler&) = delete;
+			Profiler& operator=(Profiler&&) = delete;
+			~Profiler() = default;
+
+			void record(const std::string& name, const std::chrono::nanoseconds& time, const uintmax_t& rows_returned, const uintmax_t& rows_scanned);
+			std::map<std::string, statement> get_statements() const;
+
+			/* Time database is locked from BEGIN EXCLUSIVE until COMMIT or ROLLBACK */
+			static const std::string EXCLUSIVE_TRANSACTION;
+
+		private:
+			mutable std::mutex m_mutex;
+			std::map<std::string, statement> m_statements;
+			std::chrono::milliseconds m_slow_threshold;
+			Types::logger_t m_logger;
+	};
+}
@@ -2,34 +2,140 @@
 #include "database_create.hxx" // Autogenerated by CMake
 
 #include <stdexcept>
+#include <algorithm>
 
 using namespace StormByte::VideoConvert;
 
+const int Database::SQLite3::BUSY_TIMEOUT = 60000; // In ms, as several connections (daemon, finalizer and CLI) can be opened at the same time
+const unsigned int Database::SQLite3::ENCODE_HISTORY_SAMPLES = 20; // Only the latest encodes are taken so estimations follow hardware/software changes
+
 const std::map<std::string, std::string> Database::SQLite3::DATABASE_PREPARED_SENTENCES = {
-	{"getFilmIDForProcess", 		"SELECT id FROM films WHERE processing = FALSE AND unsupported = FALSE ORDER BY prio DESC LIMIT 1"},
+	// Films which stalled are left out until their retry time
+	{"getFilmIDForProcess", 		"SELECT id FROM films WHERE processing = FALSE AND unsupported = FALSE AND (retry_after IS NULL OR retry_after <= datetime('now')) ORDER BY prio DESC, id LIMIT ?"},
+	{"getNextFilms",				"SELECT id, file FROM films WHERE processing = FALSE AND unsupported = FALSE AND (retry_after IS NULL OR retry_after <= datetime('now')) ORDER BY prio DESC, id LIMIT ?"},
+	{"getQueueSize",				"SELECT COUNT(*) FROM films WHERE processing = FALSE AND unsupported = FALSE"},
+	{"isFilmQueued?",				"SELECT COUNT(*)>0 FROM films WHERE id = ? AND processing = FALSE"},
+	{"setFilmPriority",				"UPDATE films SET prio = ? WHERE id = ? AND processing = FALSE"},
 	{"setProcessingStatusForFilm",	"UPDATE films SET processing = ? WHERE id = ?"},
 	{"setUnsupportedStatusForFilm",	"UPDATE films SET unsupported = ? WHERE id = ?"},
+	{"getFilmStalls",				"SELECT stalls FROM films WHERE id = ?"},
+	{"setFilmStalls",				"UPDATE films SET processing = FALSE, stalls = ?, retry_after = datetime('now', '+' || ? || ' seconds') WHERE id = ?"},
 	{"deleteFilmStreamHDR",			"DELETE FROM stream_hdr WHERE film_id = ?"},
-	{"getFilmData",					"SELECT file, prio, title, processing, unsupported, group_id FROM films WHERE id = ?"},
+	{"getFilmData",					"SELECT file, prio, title, processing, unsupported, group_id, duration, resolution, frame_rate FROM films WHERE id = ?"},
 	{"getFilmStreams",				"SELECT id, codec, is_animation, max_rate, bitrate FROM streams WHERE film_id = ?"},
 	{"hasStreamHDR?",				"SELECT COUNT(*)>0 FROM stream_hdr WHERE film_id = ? AND stream_id = ? AND codec = ?"},
 	{"getFilmStreamHDR",			"SELECT red_x, red_y, green_x, green_y, blue_x, blue_y, white_point_x, white_point_y, luminance_min, luminance_max, light_level_content, light_level_average FROM stream_hdr WHERE film_id = ? AND stream_id = ? AND codec = ?"},
 	{"getGroupData",				"SELECT folder FROM groups WHERE id = ?"},
-	{"insertFilm",					"INSERT INTO films(file, prio, title, group_id) VALUES (?, ?, ?, ?) RETURNING id"},
+	{"insertFilm",					"INSERT INTO films(file, prio, title, group_id, duration, resolution, frame_rate, size, fingerprint) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) RETURNING id"},
 	{"insertStream",				"INSERT INTO streams(id, film_id, codec, is_animation, max_rate, bitrate) VALUES (?, ?, ?, ?, ?, ?)"},
 	{"insertHDR",					"INSERT INTO stream_hdr(film_id, stream_id, codec, red_x, red_y, green_x, green_y, blue_x, blue_y, white_point_x, white_point_y, luminance_min, luminance_max, light_level_content, light_level_average) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"},
 	{"insertGroup",					"INSERT INTO groups(folder) VALUES (?) RETURNING id"},
-	{"resetProcessingFilms",		"UPDATE films SET processing = FALSE, unsupported = FALSE"},
+	{"resetProcessingFilms",		"UPDATE films SET processing = FALSE, unsupported = FALSE WHERE id NOT IN (SELECT film_id FROM finalizations WHERE status = " + std::to_string(Database::Data::finalization::PENDING) + ")"},
 	{"deleteFilm",					"DELETE FROM films WHERE id = ?"},
 	{"deleteFilmStream",			"DELETE FROM streams WHERE film_id = ?"},
 	{"deleteFilmStreamHDR",			"DELETE FROM stream_hdr WHERE film_id = ?"},
 	{"isFilmAlreadyInDatabase?",	"SELECT COUNT(*)>0 FROM films WHERE file = ?"},
+	{"getQueuedDuplicate",			"SELECT file, processing FROM films WHERE size = ? AND fingerprint = ? LIMIT 1"},
+	{"getConvertedDuplicate",		"SELECT file FROM converted_content WHERE size = ? AND fingerprint = ? LIMIT 1"},
+	{"insertConvertedContent",		"INSERT INTO converted_content(size, fingerprint, file) SELECT size, fingerprint, file FROM films WHERE id = ? AND fingerprint IS NOT NULL"},
 	{"doGroupExist?",				"SELECT COUNT(*)>0 FROM groups WHERE folder = ?"},
 	{"isGroupEmpty?",				"SELECT COUNT(*)=0 FROM films WHERE group_id = ?"},
-	{"deleteGroup",					"DELETE FROM groups WHERE id = ?"}
+	{"deleteGroup",					"DELETE FROM groups WHERE id = ?"},
+	{"insertEncodeHistory",			"INSERT INTO encode_history(codec, resolution, is_hdr, is_animation, host, duration, elapsed, frames, peak_memory, file, user_time, system_time, read_bytes, write_bytes) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"},
+	{"getPeakMemory",				"SELECT MAX(peak_memory) FROM (SELECT peak_memory FROM encode_history WHERE codec = ? AND resolution = ? AND is_hdr = ? AND peak_memory IS NOT NULL ORDER BY id DESC LIMIT ?)"},
+	{"getEncodeSpeedForHost",		"SELECT SUM(duration)/SUM(elapsed) FROM (SELECT duration, elapsed FROM encode_history WHERE codec = ? AND resolution = ? AND is_hdr = ? AND is_animation = ? AND host = ? ORDER BY id DESC LIMIT ?)"},
+	{"getEncodeSpeed",				"SELECT SUM(duration)/SUM(elapsed) FROM (SELECT duration, elapsed FROM encode_history WHERE codec = ? AND resolution = ? AND is_hdr = ? AND is_animation = ? ORDER BY id DESC LIMIT ?)"},
+	{"getEncodeSpeedForResolution",	"SELECT SUM(duration)/SUM(elapsed) FROM (SELECT duration, elapsed FROM encode_history WHERE codec = ? AND resolution = ? ORDER BY id DESC LIMIT ?)"},
+	// One row per video kind, films having several video streams are only counted once
+	{"getQueueForecast",			"SELECT codec, resolution, is_hdr, is_animation, COUNT(*), COUNT(duration), SUM(duration) FROM (SELECT films.duration AS duration, films.resolution AS resolution, streams.codec AS codec, streams.is_animation AS is_animation, EXISTS(SELECT 1 FROM stream_hdr WHERE stream_hdr.film_id = films.id AND stream_hdr.stream_id = streams.id AND stream_hdr.codec = streams.codec) AS is_hdr FROM films LEFT JOIN streams ON streams.film_id = films.id AND streams.codec IN (" + std::to_string(Database::Data::film::stream::VIDEO_HEVC) + ", " + std::to_string(Database::Data::film::stream::VIDEO_COPY) + ") WHERE films.processing = FALSE AND films.unsupported = FALSE AND (films.retry_after IS NULL OR films.retry_after <= datetime('now')) GROUP BY films.id) GROUP BY codec, resolution, is_hdr, is_animation"},
+	{"insertFinalization",			"INSERT INTO finalizations(film_id, input_file, work_file, output_file, action, group_id) VALUES (?, ?, ?, ?, ?, ?) RETURNING id"},
+	{"getPendingFinalizations",		"SELECT id, film_id, input_file, work_file, output_file, action, group_id FROM finalizations WHERE status = " + std::to_string(Database::Data::finalization::PENDING) + " ORDER BY id"},
+	{"setFinalizationStatus",		"UPDATE finalizations SET status = ?, finished = CURRENT_TIMESTAMP WHERE id = ?"},
+	// Folder itself or anything under it: paths below folder sort between "folder/" and "folder0" ('0' follows '/')
+	{"getScanFolders",				"SELECT folder, mtime, inode FROM scan_folders WHERE folder = ?1 OR (folder >= ?2 AND folder < ?3)"},
+	{"getScanFiles",				"SELECT folder, name, size, mtime FROM scan_files WHERE folder = ?1 OR (folder >= ?2 AND folder < ?3)"},
+	{"setScanFolder",				"INSERT OR REPLACE INTO scan_folders(folder, mtime, inode) VALUES (?, ?, ?)"},
+	{"deleteScanFolder",			"DELETE FROM scan_folders WHERE folder = ?"},
+	{"insertScanFile",				"INSERT INTO scan_files(folder, name, size, mtime) VALUES (?, ?, ?, ?)"},
+	{"deleteScanFiles",				"DELETE FROM scan_files WHERE folder = ?"},
+	{"getSweepFolders",				"SELECT folder, mtime, inode FROM sweep_folders WHERE folder = ?1 OR (folder >= ?2 AND folder < ?3)"},
+	{"getSweepFiles",				"SELECT folder, name, size, mtime FROM sweep_files WHERE folder = ?1 OR (folder >= ?2 AND folder < ?3)"},
+	{"setSweepFolder",				"INSERT OR REPLACE INTO sweep_folders(folder, mtime, inode) VALUES (?, ?, ?)"},
+	{"deleteSweepFolder",			"DELETE FROM sweep_folders WHERE folder = ?"},
+	{"insertSweepFile",				"INSERT INTO sweep_files(folder, name, size, mtime) VALUES (?, ?, ?, ?)"},
+	{"deleteSweepFiles",			"DELETE FROM sweep_files WHERE folder = ?"},
+	{"getProbeCache",				"SELECT video_codec, height, bitrate, duration, frame_rate, is_hdr FROM probe_cache WHERE file = ? AND size = ? AND mtime = ?"},
+	{"setProbeCache",				"INSERT OR REPLACE INTO probe_cache(file, size, mtime, video_codec, height, bitrate, duration, frame_rate, is_hdr) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)"}
+};
+
+// New databases are created already up to date from create.sql, so every change made there must be added here too
+const std::vector<Database::SQLite3::migration> Database::SQLite3::DATABASE_MIGRATIONS = {
+	// 1: Encode history to estimate encode times
+	{
+		{ {"films", "duration REAL DEFAULT NULL"}, {"films", "resolution TINYINT DEFAULT NULL"}, {"films", "frame_rate REAL DEFAULT NULL"} },
+		{
+			"CREATE TABLE IF NOT EXISTS encode_history(id INTEGER PRIMARY KEY AUTOINCREMENT, codec INTEGER NOT NULL, resolution TINYINT NOT NULL, is_hdr BOOL DEFAULT FALSE, is_animation BOOL DEFAULT FALSE, host VARCHAR NOT NULL, duration REAL NOT NULL, elapsed REAL NOT NULL, frames REAL DEFAULT NULL)",
+			"CREATE INDEX IF NOT EXISTS encode_history_profile ON encode_history(codec, resolution, is_hdr, is_animation, host)"
+		}
+	},
+	// 2: Background finalization
+	{
+		{},
+		{
+			"CREATE TABLE IF NOT EXISTS finalizations(id INTEGER PRIMARY KEY AUTOINCREMENT, film_id INTEGER NOT NULL, input_file VARCHAR NOT NULL, work_file VARCHAR NOT NULL, output_file VARCHAR NOT NULL, action TINYINT NOT NULL, group_id INTEGER DEFAULT NULL, status TINYINT DEFAULT 0, finished DATETIME DEFAULT NULL)",
+			"CREATE INDEX IF NOT EXISTS finalizations_status ON finalizations(status)"
+		}
+	},
+	// 3: Memory admission
+	{
+		{ {"encode_history", "peak_memory INTEGER DEFAULT NULL"} },
+		{}
+	},
+	// 4: Scan index
+	{
+		{},
+		{
+			"CREATE TABLE IF NOT EXISTS scan_folders(folder VARCHAR PRIMARY KEY, mtime INTEGER NOT NULL, inode INTEGER NOT NULL)",
+			"CREATE TABLE IF NOT EXISTS scan_files(folder VARCHAR NOT NULL, name VARCHAR NOT NULL, size INTEGER NOT NULL, mtime INTEGER NOT NULL, PRIMARY KEY(folder, name))"
+		}
+	},
+	// 5: Duplicated content detection
+	{
+		{ {"films", "size INTEGER DEFAULT NULL"}, {"films", "fingerprint INTEGER DEFAULT NULL"} },
+		{
+			"CREATE INDEX IF NOT EXISTS films_content ON films(size, fingerprint)",
+			"CREATE TABLE IF NOT EXISTS converted_content(id INTEGER PRIMARY KEY AUTOINCREMENT, size INTEGER NOT NULL, fingerprint INTEGER NOT NULL, file VARCHAR NOT NULL, converted DATETIME DEFAULT CURRENT_TIMESTAMP)",
+			"CREATE INDEX IF NOT EXISTS converted_content_fingerprint ON converted_content(size, fingerprint)"
+		}
+	},
+	// 6: Library sweep
+	{
+		{},
+		{
+			"CREATE TABLE IF NOT EXISTS probe_cache(file VARCHAR PRIMARY KEY, size INTEGER NOT NULL, mtime INTEGER NOT NULL, video_codec VARCHAR DEFAULT NULL, height INTEGER DEFAULT NULL, bitrate INTEGER DEFAULT NULL, duration REAL DEFAULT NULL, frame_rate REAL DEFAULT NULL, is_hdr BOOL DEFAULT FALSE)"
+		}
+	},
+	// 7: Encode resource usage
+	{
+		{ {"encode_history", "file VARCHAR DEFAULT NULL"}, {"encode_history", "user_time REAL DEFAULT NULL"}, {"encode_history", "system_time REAL DEFAULT NULL"}, {"encode_history", "read_bytes INTEGER DEFAULT NULL"}, {"encode_history", "write_bytes INTEGER DEFAULT NULL"} },
+		{}
+	},
+	// 8: Sweep scan index
+	{
+		{},
+		{
+			"CREATE TABLE IF NOT EXISTS sweep_folders(folder VARCHAR PRIMARY KEY, mtime INTEGER NOT NULL, inode INTEGER NOT NULL)",
+			"CREATE TABLE IF NOT EXISTS sweep_files(folder VARCHAR NOT NULL, name VARCHAR NOT NULL, size INTEGER NOT NULL, mtime INTEGER NOT NULL, PRIMARY KEY(folder, name))"
+		}
+	},
+	// 9: Stall retries
+	{
+		{ {"films", "stalls INTEGER DEFAULT 0"}, {"films", "retry_after DATETIME DEFAULT NULL"} },
+		{}
+	}
 };
 
-Database::SQLite3::SQLite3(const Types::path_t& dbfile, Types::logger_t logger):m_logger(logger) {
+Database::SQLite3::SQLite3(const Types::path_t& dbfile, Types::logger_t logger, Types::profiler_t profiler):m_logger(logger), m_profiler(profiler) {
 	int rc = sqlite3_open(dbfile.c_str(), &m_database);
 
 	if (rc != SQLITE_OK) {
@@ -37,8 +143,14 @@ Database::SQLite3::SQLite3(const Types::path_t& dbfile, Types::logger_t logger):
 		sqlite3_close(m_database); // Need to close database here as exception throwing will skip destructor
         throw std::runtime_error(message);
     }
-	if (!check_database()) init_database();
+	sqlite3_busy_timeout(m_database, BUSY_TIMEOUT);
+	if (check_database())
+		migrate_database();
+	else
+		init_database();
 	prepare_sentences();
+	if (m_profiler)
+		sqlite3_trace_v2(m_database, SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, trace, this);
 	
 }
 
@@ -50,10 +162,10 @@ Database::SQLite3::~SQLite3() {
 	sqlite3_close(m_database);
 }
 
-std::optional<FFmpeg> Database::SQLite3::get_film_for_process() {
+std::optional<FFmpeg> Database::SQLite3::get_film_for_process(const std::set<unsigned int>& skipped) {
 	begin_exclusive_transaction();
 	std::optional<FFmpeg> ffmpeg;
-	std::optional<unsigned int> film_id = get_film_id_for_process();
+	std::optional<unsigned int> film_id = get_film_id_for_process(skipped);
 
 	if (film_id) {
 		std::optional<Data::film> film_data = get_film_data(*film_id);
@@ -61,6 +173,12 @@ std::optional<FFmpeg> Database::SQLite3::get_film_for_process() {
 			FFmpeg film(*film_data->m_id, film_data->m_file, film_data->m_group);
 			if (film_data->m_title)
 				film.set_title(*film_data->m_title);
+			if (film_data->m_duration)
+				film.set_duration(*film_data->m_duration);
+			if (film_data->m_resolution)
+				film.set_resolution(*film_data->m_resolution);
+			if (film_data->m_frame_rate)
+				film.set_frame_rate(*film_data->m_frame_rate);
 			auto streams = get_film_streams(*film_data->m_id);
 			std::list<Data::film::stream::codec> unsupported_codecs;
 
@@ -140,7 +258,7 @@ std::optional<FFmpeg> Database::SQLite3::get_film_for_process() {
 
 			// We now check if we have unsupported codecs
 			if (unsupported_codecs.empty()) {
-				if (m_logger) m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Marking file " + film.get_input_file().string() + " as processing");
+				if (m_logger) m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Marking file ", film.get_input_file(), " as processing");
 				set_film_processing_status(film.get_film_id(), true);
 				ffmpeg.emplace(std::move(film));
 			}
@@ -150,7 +268,7 @@ std::optional<FFmpeg> Database::SQLite3::get_film_for_process() {
 					if (m_logger) m_logger->message_part_continue(Utils::Logger::LEVEL_ERROR, Database::Data::film::stream::codec_string.at(*it) + ", ");
 				}
 				if (m_logger) m_logger->message_part_end(Utils::Logger::LEVEL_ERROR, "and therefore could NOT be converted!");
-				if (m_logger) m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Marking file " + film.get_input_file().string() + " as unsupported");
+				if (m_logger) m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Marking file ", film.get_input_file(), " as unsupported");
 				set_film_unsupported_status(film.get_film_id(), true);
 			}
 		}
@@ -159,15 +277,52 @@ std::optional<FFmpeg> Database::SQLite3::get_film_for_process() {
 	return ffmpeg;
 }
 
-void Database::SQLite3::finish_film_process(const FFmpeg& ffmpeg, const bool& status) {
+void Database::SQLite3::finish_film_process(const unsigned int& film_id, const bool& status) {
 	begin_exclusive_transaction();
 
-	if (status)
-		delete_film(ffmpeg.get_film_id());
+	if (status) {
+		insert_converted_content(film_id);
+		delete_film(film_id);
+	}
+	else
+		set_film_unsupported_status(film_id, true);
+
+	commit_transaction();
+}
+
+void Database::SQLite3::release_film_process(const FFmpeg& ffmpeg) {
+	begin_exclusive_transaction();
+	set_film_processing_status(ffmpeg.get_film_id(), false);
+	commit_transaction();
+}
+
+std::optional<std::chrono::seconds> Database::SQLite3::retry_stalled_film(const FFmpeg& ffmpeg, const unsigned int& max_stalls, const std::chrono::seconds& delay) {
+	begin_exclusive_transaction();
+
+	unsigned int stalls = 1;
+	auto stmt = m_prepared["getFilmStalls"];
+	sqlite3_bind_int(stmt, 1, ffmpeg.get_film_id());
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		stalls += sqlite3_column_int(stmt, 0);
+	reset_stmt(stmt);
+
+	// Doubled on every stall, exponent is capped so it can not overflow
+	const std::chrono::seconds retry_delay = delay * (1 << std::min(stalls - 1, 10u));
+	stmt = m_prepared["setFilmStalls"];
+	sqlite3_bind_int(stmt, 1, stalls);
+	sqlite3_bind_int64(stmt, 2, retry_delay.count());
+	sqlite3_bind_int(stmt, 3, ffmpeg.get_film_id());
+	sqlite3_step(stmt);
+	reset_stmt(stmt);
+
+	std::optional<std::chrono::seconds> result;
+	if (stalls < max_stalls)
+		result = retry_delay;
 	else
 		set_film_unsupported_status(ffmpeg.get_film_id(), true);
 
 	commit_transaction();
+	return result;
 }
 
 bool Database::SQLite3::check_database() {
@@ -182,6 +337,69 @@ void Database::SQLite3::init_database() {
 	char* err_msg = NULL;
 	int rc = sqlite3_exec(m_database, DATABASE_CREATE_SQL.c_str(), nullptr, nullptr, &err_msg);
 	if (rc != SQLITE_OK) throw_error(err_msg);
+	set_database_version(DATABASE_MIGRATIONS.size());
+}
+
+void Database::SQLite3::migrate_database() {
+	// Version is read inside the transaction so only one of the connections opened at the same time migrates it
+	begin_exclusive_transaction();
+	int version = get_database_version();
+	if (version < static_cast<int>(DATABASE_MIGRATIONS.size()) && m_logger)
+		m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Upgrading database from version ", version, " to ", DATABASE_MIGRATIONS.size());
+	try {
+		for (; version < static_cast<int>(DATABASE_MIGRATIONS.size()); version++) {
+			const migration& step = DATABASE_MIGRATIONS[version];
+			// Databases created by development builds between versions may already have some columns
+			for (auto it = step.m_columns.begin(); it != step.m_columns.end(); it++) {
+				const std::string column = it->second.substr(0, it->second.find(' '));
+				if (!has_column(it->first, column)) {
+					char* err_msg = nullptr;
+					const std::string sql = "ALTER TABLE " + it->first + " ADD COLUMN " + it->second + ";";
+					if (sqlite3_exec(m_database, sql.c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK) throw_error(err_msg);
+				}
+			}
+			for (auto it = step.m_statements.begin(); it != step.m_statements.end(); it++) {
+				char* err_msg = nullptr;
+				if (sqlite3_exec(m_database, it->c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK) throw_error(err_msg);
+			}
+			set_database_version(version + 1);
+		}
+	}
+	catch (const std::exception&) {
+		rollback_transaction();
+		throw;
+	}
+	commit_transaction();
+}
+
+int Database::SQLite3::get_database_version() {
+	int version = 0;
+	sqlite3_stmt* stmt = nullptr;
+	sqlite3_prepare_v2(m_database, "PRAGMA user_version;", -1, &stmt, nullptr);
+	if (stmt && sqlite3_step(stmt) == SQLITE_ROW)
+		version = sqlite3_column_int(stmt, 0);
+	sqlite3_finalize(stmt);
+	return version;
+}
+
+void Database::SQLite3::set_database_version(const int& version) {
+	char* err_msg = nullptr;
+	const std::string sql = "PRAGMA user_version = " + std::to_string(version) + ";";
+	if (sqlite3_exec(m_database, sql.c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK) throw_error(err_msg);
+}
+
+bool Database::SQLite3::has_column(const std::string& table, const std::string& column) {
+	bool result = false;
+	sqlite3_stmt* stmt = nullptr;
+	sqlite3_prepare_v2(m_database, "SELECT COUNT(*)>0 FROM pragma_table_info(?) WHERE name = ?;", -1, &stmt, nullptr);
+	if (stmt) {
+		sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, column.c_str(), -1, SQLITE_STATIC);
+		if (sqlite3_step(stmt) == SQLITE_ROW)
+			result = sqlite3_column_int(stmt, 0);
+	}
+	sqlite3_finalize(stmt);
+	return result;
 }
 
 void Database::SQLite3::throw_error(char* err_msg) {
@@ -206,6 +424,8 @@ void Database::SQLite3::begin_exclusive_transaction() {
 	char* err_msg = nullptr;
 	sqlite3_exec(m_database, "BEGIN EXCLUSIVE TRANSACTION;", nullptr, nullptr, &err_msg);
 	sqlite3_free(err_msg);
+	// Waiting for the lock is accounted in BEGIN statement itself
+	if (m_profiler) m_exclusive_start = std::chrono::steady_clock::now();
 	if (m_logger) m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Database EXCLUSIVE transaction started");
 }
 
@@ -213,6 +433,7 @@ void Database::SQLite3::commit_transaction() {
 	char* err_msg = nullptr;
 	sqlite3_exec(m_database, "COMMIT;", nullptr, nullptr, &err_msg);
 	sqlite3_free(err_msg);
+	end_exclusive_transaction();
 	if (m_logger) m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Database transaction commited");
 }
 
@@ -220,25 +441,60 @@ void Database::SQLite3::rollback_transaction() {
 	char* err_msg = nullptr;
 	sqlite3_exec(m_database, "ROLLBACK;", nullptr, nullptr, &err_msg);
 	sqlite3_free(err_msg);
+	end_exclusive_transaction();
 	if (m_logger) m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Database transaction ABORTED");
 }
 
+void Database::SQLite3::end_exclusive_transaction() {
+	if (m_exclusive_start) {
+		m_profiler->record(Profiler::EXCLUSIVE_TRANSACTION, std::chrono::steady_clock::now() - *m_exclusive_start, 0, 0);
+		m_exclusive_start.reset();
+	}
+}
+
+int Database::SQLite3::trace(unsigned int type, void* context, void* statement, void* data) {
+	SQLite3* self = static_cast<SQLite3*>(context);
+	sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(statement);
+	if (type == SQLITE_TRACE_ROW) {
+		self->m_statement_rows[stmt]++;
+		return 0;
+	}
+
+	// Profile event comes when statement finishes or is reset
+	uintmax_t rows = 0;
+	auto rows_it = self->m_statement_rows.find(stmt);
+	if (rows_it != self->m_statement_rows.end()) {
+		rows = rows_it->second;
+		self->m_statement_rows.erase(rows_it);
+	}
+	auto name = self->m_statement_names.find(stmt);
+	const char* sql = sqlite3_sql(stmt);
+	const int scanned = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+	self->m_profiler->record(name != self->m_statement_names.end() ? name->second : std::string(sql ? sql : "?"), std::chrono::nanoseconds(*static_cast<sqlite3_int64*>(data)), rows, scanned);
+	return 0;
+}
+
 void Database::SQLite3::prepare_sentences() {
 	for (auto it = DATABASE_PREPARED_SENTENCES.begin(); it != DATABASE_PREPARED_SENTENCES.end(); it++) {
 		m_prepared[it->first] = nullptr;
 		sqlite3_prepare_v2( m_database, it->second.c_str(), it->second.length(), &m_prepared[it->first], nullptr);
 		if (!m_prepared[it->first])
 			throw std::runtime_error("Prepared sentence " + (it->first) + " can not be loaded!");
+		m_statement_names[m_prepared[it->first]] = it->first;
 	}
 }
 
-std::optional<unsigned int> Database::SQLite3::get_film_id_for_process() {
+std::optional<unsigned int> Database::SQLite3::get_film_id_for_process(const std::set<unsigned int>& skipped) {
+	// At most every skipped film comes before the first one not skipped
 	std::optional<unsigned int> result;
 	auto stmt = m_prepared["getFilmIDForProcess"];
-	if (sqlite3_step(stmt) == SQLITE_ROW) {
-		result = sqlite3_column_int(stmt, 0);
+	sqlite3_bind_int64(stmt, 1, skipped.size() + 1);
+	while (!result && sqlite3_step(stmt) == SQLITE_ROW) {
+		const unsigned int film_id = sqlite3_column_int(stmt, 0);
+		if (!skipped.contains(film_id))
+			result = film_id;
 	}
-	sqlite3_reset(stmt);
+	reset_stmt(stmt);
 	return result;
 }
 
@@ -273,6 +529,12 @@ std::optional<Database::Data::film> Database::SQLite3::get_film_data(const unsig
 		film.m_unsupported	= sqlite3_column_int(stmt, 4);
 		if (sqlite3_column_type(stmt, 4) != SQLITE_NULL)
 			film.m_group	= get_group_data(sqlite3_column_int(stmt, 5));
+		if (sqlite3_column_type(stmt, 6) != SQLITE_NULL)
+			film.m_duration		= sqlite3_column_double(stmt, 6);
+		if (sqlite3_column_type(stmt, 7) != SQLITE_NULL)
+			film.m_resolution	= sqlite3_column_int(stmt, 7);
+		if (sqlite3_column_type(stmt, 8) != SQLITE_NULL)
+			film.m_frame_rate	= sqlite3_column_double(stmt, 8);
 		result.emplace(std::move(film));
 	}
 	reset_stmt(stmt);
@@ -365,6 +627,26 @@ std::optional<unsigned int> Database::SQLite3::insert_film(const Data::film& fil
 			sqlite3_bind_int(stmt, 4, film.m_group->id);
 		else
 			sqlite3_bind_null(stmt, 4);
+		if (film.m_duration)
+			sqlite3_bind_double(stmt, 5, *film.m_duration);
+		else
+			sqlite3_bind_null(stmt, 5);
+		if (film.m_resolution)
+			sqlite3_bind_int(stmt, 6, *film.m_resolution);
+		else
+			sqlite3_bind_null(stmt, 6);
+		if (film.m_frame_rate)
+			sqlite3_bind_double(stmt, 7, *film.m_frame_rate);
+		else
+			sqlite3_bind_null(stmt, 7);
+		if (film.m_content) {
+			sqlite3_bind_int64(stmt, 8, film.m_content->m_size);
+			sqlite3_bind_int64(stmt, 9, static_cast<sqlite3_int64>(film.m_content->m_fingerprint));
+		}
+		else {
+			sqlite3_bind_null(stmt, 8);
+			sqlite3_bind_null(stmt, 9);
+		}
 		if (sqlite3_step(stmt) == SQLITE_ROW) {
 			film_id = sqlite3_column_int(stmt, 0);
 
@@ -393,6 +675,25 @@ bool Database::SQLite3::insert_films(const std::list<Data::film>& films) {
 	return continue_inserting;
 }
 
+std::optional<std::list<Types::path_t>> Database::SQLite3::insert_new_films(const std::list<Data::film>& films) {
+	std::optional<std::list<Types::path_t>> skipped = std::list<Types::path_t>();
+	begin_exclusive_transaction();
+
+	for (auto film = films.begin(); film != films.end() && skipped; film++) {
+		if (is_film_in_database(film->m_file))
+			skipped->push_back(film->m_file);
+		else if (!insert_film(*film))
+			skipped.reset();
+	}
+
+	if (skipped)
+		commit_transaction();
+	else
+		rollback_transaction();
+
+	return skipped;
+}
+
 void Database::SQLite3::insert_stream(const unsigned int& film_id, const Data::film::stream& stream) {
 	auto stmt = m_prepared["insertStream"];
 	sqlite3_bind_int(stmt, 1, stream.m_id);
@@ -460,6 +761,13 @@ void Database::SQLite3::reset_processing_films() {
 	reset_stmt(stmt);
 }
 
+void Database::SQLite3::insert_converted_content(const unsigned int& film_id) {
+	auto stmt = m_prepared["insertConvertedContent"];
+	sqlite3_bind_int(stmt, 1, film_id);
+	sqlite3_step(stmt);
+	reset_stmt(stmt);
+}
+
 void Database::SQLite3::delete_film(const unsigned int& film_id) {
 	auto stmt = m_prepared["deleteFilm"];
 	sqlite3_bind_int(stmt, 1, film_id);
@@ -522,3 +830,439 @@ bool Database::SQLite3::is_group_empty(const Data::film::group& group) {
 	reset_stmt(stmt);
 	return result;
 }
+
+void Database::SQLite3::insert_encode_history(const Data::encode_history& history) {
+	auto stmt = m_prepared["insertEncodeHistory"];
+	sqlite3_bind_int(stmt, 1, history.m_codec);
+	sqlite3_bind_int(stmt, 2, history.m_resolution);
+	sqlite3_bind_int(stmt, 3, history.m_is_HDR);
+	sqlite3_bind_int(stmt, 4, history.m_is_animation);
+	sqlite3_bind_text(stmt, 5, history.m_host.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_double(stmt, 6, history.m_duration);
+	sqlite3_bind_double(stmt, 7, history.m_elapsed);
+	if (history.m_frames)
+		sqlite3_bind_double(stmt, 8, *history.m_frames);
+	else
+		sqlite3_bind_null(stmt, 8);
+	if (history.m_peak_memory)
+		sqlite3_bind_int64(stmt, 9, *history.m_peak_memory);
+	else
+		sqlite3_bind_null(stmt, 9);
+	const std::string file = history.m_file.string();
+	sqlite3_bind_text(stmt, 10, file.c_str(), -1, SQLITE_STATIC);
+	if (history.m_user_time && history.m_system_time) {
+		sqlite3_bind_double(stmt, 11, *history.m_user_time);
+		sqlite3_bind_double(stmt, 12, *history.m_system_time);
+	}
+	else {
+		sqlite3_bind_null(stmt, 11);
+		sqlite3_bind_null(stmt, 12);
+	}
+	if (history.m_read_bytes && history.m_write_bytes) {
+		sqlite3_bind_int64(stmt, 13, *history.m_read_bytes);
+		sqlite3_bind_int64(stmt, 14, *history.m_write_bytes);
+	}
+	else {
+		sqlite3_bind_null(stmt, 13);
+		sqlite3_bind_null(stmt, 14);
+	}
+	sqlite3_step(stmt); // No result
+	reset_stmt(stmt);
+}
+
+std::optional<double> Database::SQLite3::get_encode_speed(const Data::film::stream::codec& codec, const unsigned short& resolution, const bool& is_HDR, const bool& is_animation, const std::string& host) {
+	// From the most specific profile to the most generic one: same host, any host and finally any HDR/animation
+	auto stmt = m_prepared["getEncodeSpeedForHost"];
+	sqlite3_bind_int(stmt, 1, codec);
+	sqlite3_bind_int(stmt, 2, resolution);
+	sqlite3_bind_int(stmt, 3, is_HDR);
+	sqlite3_bind_int(stmt, 4, is_animation);
+	sqlite3_bind_text(stmt, 5, host.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int(stmt, 6, ENCODE_HISTORY_SAMPLES);
+	std::optional<double> result = get_encode_speed(stmt);
+
+	if (!result) {
+		stmt = m_prepared["getEncodeSpeed"];
+		sqlite3_bind_int(stmt, 1, codec);
+		sqlite3_bind_int(stmt, 2, resolution);
+		sqlite3_bind_int(stmt, 3, is_HDR);
+		sqlite3_bind_int(stmt, 4, is_animation);
+		sqlite3_bind_int(stmt, 5, ENCODE_HISTORY_SAMPLES);
+		result = get_encode_speed(stmt);
+	}
+
+	if (!result) {
+		stmt = m_prepared["getEncodeSpeedForResolution"];
+		sqlite3_bind_int(stmt, 1, codec);
+		sqlite3_bind_int(stmt, 2, resolution);
+		sqlite3_bind_int(stmt, 3, ENCODE_HISTORY_SAMPLES);
+		result = get_encode_speed(stmt);
+	}
+
+	return result;
+}
+
+std::optional<double> Database::SQLite3::get_encode_speed(sqlite3_stmt* stmt) {
+	std::optional<double> result;
+	if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+		const double speed = sqlite3_column_double(stmt, 0);
+		if (speed > 0) result = speed;
+	}
+	reset_stmt(stmt);
+	return result;
+}
+
+std::optional<double> Database::SQLite3::estimate_encode_time(const Data::film::stream::codec& codec, const unsigned short& resolution, const bool& is_HDR, const bool& is_animation, const double& duration, const std::string& host) {
+	std::optional<double> result;
+	std::optional<double> speed = get_encode_speed(codec, resolution, is_HDR, is_animation, host);
+	if (speed)
+		result = duration / *speed;
+	return result;
+}
+
+std::optional<double> Database::SQLite3::estimate_encode_time(const Data::film& film, const std::string& host) {
+	std::optional<double> result;
+	auto video = std::find_if(film.m_streams.begin(), film.m_streams.end(), [](const Data::film::stream& stream) {
+		return stream.m_codec == Data::film::stream::VIDEO_HEVC || stream.m_codec == Data::film::stream::VIDEO_COPY;
+	});
+	if (video != film.m_streams.end() && film.m_duration && film.m_resolution)
+		result = estimate_encode_time(video->m_codec, *film.m_resolution, video->m_hdr.has_value(), video->m_is_animation, *film.m_duration, host);
+	return result;
+}
+
+std::optional<double> Database::SQLite3::estimate_encode_time(const FFmpeg& ffmpeg, const std::string& host) {
+	std::optional<double> result;
+	auto codec = ffmpeg.get_video_codec();
+	if (codec && ffmpeg.get_duration() && ffmpeg.get_resolution())
+		result = estimate_encode_time(*codec, *ffmpeg.get_resolution(), ffmpeg.is_HDR(), ffmpeg.is_animation(), *ffmpeg.get_duration(), host);
+	return result;
+}
+
+std::list<Database::Data::film> Database::SQLite3::get_next_films(const unsigned int& count) {
+	// Same order than get_film_for_process so they are the ones to be processed next
+	std::list<Data::film> result;
+	auto stmt = m_prepared["getNextFilms"];
+	sqlite3_bind_int(stmt, 1, count);
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		Data::film film;
+		film.m_id	= sqlite3_column_int(stmt, 0);
+		film.m_file	= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+		result.push_back(std::move(film));
+	}
+	reset_stmt(stmt);
+	return result;
+}
+
+unsigned int Database::SQLite3::get_queue_size() {
+	unsigned int result = 0;
+	auto stmt = m_prepared["getQueueSize"];
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		result = sqlite3_column_int(stmt, 0);
+	reset_stmt(stmt);
+	return result;
+}
+
+bool Database::SQLite3::set_film_priority(const unsigned int& film_id, const Data::film::priority& priority) {
+	auto stmt = m_prepared["setFilmPriority"];
+	sqlite3_bind_int(stmt, 1, priority);
+	sqlite3_bind_int(stmt, 2, film_id);
+	sqlite3_step(stmt); // No result
+	const bool result = sqlite3_changes(m_database) > 0;
+	reset_stmt(stmt);
+	return result;
+}
+
+bool Database::SQLite3::delete_queued_film(const unsigned int& film_id) {
+	// Checked inside the transaction so daemon can not claim it meanwhile
+	bool result = false;
+	begin_exclusive_transaction();
+	auto stmt = m_prepared["isFilmQueued?"];
+	sqlite3_bind_int(stmt, 1, film_id);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		result = static_cast<bool>(sqlite3_column_int(stmt, 0));
+	reset_stmt(stmt);
+	if (result)
+		delete_film(film_id);
+	commit_transaction();
+	return result;
+}
+
+std::optional<uintmax_t> Database::SQLite3::get_peak_memory(const FFmpeg& ffmpeg) {
+	// Host is not taken into account as memory depends on encoder settings and not on hardware speed
+	std::optional<uintmax_t> result;
+	auto codec = ffmpeg.get_video_codec();
+	if (codec && ffmpeg.get_resolution()) {
+		auto stmt = m_prepared["getPeakMemory"];
+		sqlite3_bind_int(stmt, 1, *codec);
+		sqlite3_bind_int(stmt, 2, *ffmpeg.get_resolution());
+		sqlite3_bind_int(stmt, 3, ffmpeg.is_HDR());
+		sqlite3_bind_int(stmt, 4, ENCODE_HISTORY_SAMPLES);
+		if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+			result = sqlite3_column_int64(stmt, 0);
+		reset_stmt(stmt);
+	}
+	return result;
+}
+
+Database::Data::queue_forecast Database::SQLite3::get_queue_forecast(const std::string& host) {
+	Data::queue_forecast result;
+	auto stmt = m_prepared["getQueueForecast"];
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		const unsigned int films = sqlite3_column_int(stmt, 4);
+		const unsigned int with_duration = sqlite3_column_int(stmt, 5);
+		// Speed is looked up once per kind as time is linear in duration
+		std::optional<double> estimation;
+		if (with_duration > 0 && sqlite3_column_type(stmt, 0) != SQLITE_NULL && sqlite3_column_type(stmt, 1) != SQLITE_NULL) {
+			estimation = estimate_encode_time(
+				static_cast<Data::film::stream::codec>(sqlite3_column_int(stmt, 0)),
+				sqlite3_column_int(stmt, 1),
+				sqlite3_column_int(stmt, 2),
+				sqlite3_column_int(stmt, 3),
+				sqlite3_column_double(stmt, 6),
+				host
+			);
+		}
+		if (estimation) {
+			result.m_estimated += with_duration;
+			result.m_unknown += films - with_duration;
+			result.m_seconds += *estimation;
+		}
+		else
+			result.m_unknown += films;
+	}
+	reset_stmt(stmt);
+	return result;
+}
+
+std::optional<unsigned int> Database::SQLite3::insert_finalization(const Data::finalization& finalization) {
+	std::optional<unsigned int> result;
+	auto stmt = m_prepared["insertFinalization"];
+	sqlite3_bind_int(stmt, 1, finalization.m_film_id);
+	sqlite3_bind_text(stmt, 2, finalization.m_input_file.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 3, finalization.m_work_file.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 4, finalization.m_output_file.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int(stmt, 5, finalization.m_action);
+	if (finalization.m_group)
+		sqlite3_bind_int(stmt, 6, finalization.m_group->id);
+	else
+		sqlite3_bind_null(stmt, 6);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		result = sqlite3_column_int(stmt, 0);
+	reset_stmt(stmt);
+	return result;
+}
+
+std::list<Database::Data::finalization> Database::SQLite3::get_pending_finalizations() {
+	std::list<Data::finalization> result;
+	std::list<std::pair<Data::finalization, std::optional<unsigned int>>> pending; // Groups are read after finishing this statement
+	auto stmt = m_prepared["getPendingFinalizations"];
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		Data::finalization finalization;
+		finalization.m_id			= sqlite3_column_int(stmt, 0);
+		finalization.m_film_id		= sqlite3_column_int(stmt, 1);
+		finalization.m_input_file	= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+		finalization.m_work_file	= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+		finalization.m_output_file	= reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+		finalization.m_action		= static_cast<Data::finalization::action>(sqlite3_column_int(stmt, 5));
+		std::optional<unsigned int> group_id;
+		if (sqlite3_column_type(stmt, 6) != SQLITE_NULL)
+			group_id = sqlite3_column_int(stmt, 6);
+		pending.push_back({ std::move(finalization), group_id });
+	}
+	reset_stmt(stmt);
+
+	for (auto it = pending.begin(); it != pending.end(); it++) {
+		if (it->second)
+			it->first.m_group = get_group_data(*it->second);
+		result.push_back(std::move(it->first));
+	}
+	return result;
+}
+
+void Database::SQLite3::finish_finalization(const Data::finalization& finalization, const bool& status) {
+	begin_exclusive_transaction();
+
+	auto stmt = m_prepared["setFinalizationStatus"];
+	sqlite3_bind_int(stmt, 1, status ? Data::finalization::DONE : Data::finalization::FAILED);
+	sqlite3_bind_int(stmt, 2, *finalization.m_id);
+	sqlite3_step(stmt);
+	reset_stmt(stmt);
+
+	if (status) {
+		insert_converted_content(finalization.m_film_id);
+		delete_film(finalization.m_film_id);
+	}
+	else
+		set_film_unsupported_status(finalization.m_film_id, true);
+
+	commit_transaction();
+}
+
+Utils::Walker::index_t Database::SQLite3::get_scan_index(const Types::path_t& folder, const Data::scan_index& index_name) {
+	Utils::Walker::index_t result;
+	const std::string path = folder.string();
+	// Root folder is stored as empty string and "\xF8" sorts after any UTF-8 text
+	const std::string lower = path.empty() ? "" : path + "/", upper = path.empty() ? "\xF8" : path + "0";
+
+	auto stmt = scan_statement("getScanFolders", index_name);
+	sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, lower.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 3, upper.c_str(), -1, SQLITE_STATIC);
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		Utils::Walker::folder_index& index = result[reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))];
+		index.m_mtime = sqlite3_column_int64(stmt, 1);
+		index.m_inode = sqlite3_column_int64(stmt, 2);
+	}
+	reset_stmt(stmt);
+
+	stmt = scan_statement("getScanFiles", index_name);
+	sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, lower.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 3, upper.c_str(), -1, SQLITE_STATIC);
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		auto it = result.find(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+		if (it != result.end())
+			it->second.m_files[reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))] = { static_cast<uintmax_t>(sqlite3_column_int64(stmt, 2)), sqlite3_column_int64(stmt, 3) };
+	}
+	reset_stmt(stmt);
+
+	// Subfolders are not stored as they are known from their own rows
+	for (auto it = result.begin(); it != result.end(); it++) {
+		if (it->first.empty()) continue;
+		auto parent = result.find(it->first.parent_path());
+		if (parent != result.end())
+			parent->second.m_folders.insert(it->first.filename());
+	}
+
+	return result;
+}
+
+void Database::SQLite3::update_scan_index(const Utils::Walker::scan_result& scan, const Data::scan_index& index_name) {
+	begin_transaction();
+
+	for (auto it = scan.m_removed.begin(); it != scan.m_removed.end(); it++) {
+		set_scan_folder_files(*it, {}, index_name);
+		auto stmt = scan_statement("deleteScanFolder", index_name);
+		sqlite3_bind_text(stmt, 1, it->c_str(), -1, SQLITE_STATIC);
+		sqlite3_step(stmt);
+		reset_stmt(stmt);
+	}
+
+	for (auto it = scan.m_updated.begin(); it != scan.m_updated.end(); it++) {
+		auto stmt = scan_statement("setScanFolder", index_name);
+		sqlite3_bind_text(stmt, 1, it->first.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(stmt, 2, it->second.m_mtime);
+		sqlite3_bind_int64(stmt, 3, it->second.m_inode);
+		sqlite3_step(stmt);
+		reset_stmt(stmt);
+		set_scan_folder_files(it->first, it->second.m_files, index_name);
+	}
+
+	commit_transaction();
+}
+
+void Database::SQLite3::set_scan_folder_files(const Types::path_t& folder, const std::map<std::string, Utils::Walker::file_signature>& files, const Data::scan_index& index_name) {
+	auto stmt = scan_statement("deleteScanFiles", index_name);
+	sqlite3_bind_text(stmt, 1, folder.c_str(), -1, SQLITE_STATIC);
+	sqlite3_step(stmt);
+	reset_stmt(stmt);
+
+	stmt = scan_statement("insertScanFile", index_name);
+	for (auto it = files.begin(); it != files.end(); it++) {
+		sqlite3_bind_text(stmt, 1, folder.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, it->first.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(stmt, 3, it->second.m_size);
+		sqlite3_bind_int64(stmt, 4, it->second.m_mtime);
+		sqlite3_step(stmt);
+		reset_stmt(stmt);
+	}
+}
+
+sqlite3_stmt* Database::SQLite3::scan_statement(std::string name, const Data::scan_index& index_name) {
+	// Sweep index statements are named as add index ones with Sweep instead of Scan
+	if (index_name == Data::SWEEP_INDEX)
+		name.replace(name.find("Scan"), 4, "Sweep");
+	return m_prepared[name];
+}
+
+std::optional<Database::Data::duplicate> Database::SQLite3::find_duplicate(const Data::film::content& content) {
+	std::optional<Data::duplicate> result;
+	auto stmt = m_prepared["getQueuedDuplicate"];
+	sqlite3_bind_int64(stmt, 1, content.m_size);
+	sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(content.m_fingerprint));
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		result = { reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)), sqlite3_column_int(stmt, 1) ? Data::duplicate::PROCESSING : Data::duplicate::QUEUED };
+	reset_stmt(stmt);
+
+	if (!result) {
+		stmt = m_prepared["getConvertedDuplicate"];
+		sqlite3_bind_int64(stmt, 1, content.m_size);
+		sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(content.m_fingerprint));
+		if (sqlite3_step(stmt) == SQLITE_ROW)
+			result = { reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)), Data::duplicate::CONVERTED };
+		reset_stmt(stmt);
+	}
+	return result;
+}
+
+std::optional<Database::Data::probe_cache> Database::SQLite3::get_probe_cache(const Types::path_t& file, const uintmax_t& size, const int64_t& mtime) {
+	std::optional<Data::probe_cache> result;
+	auto stmt = m_prepared["getProbeCache"];
+	sqlite3_bind_text(stmt, 1, file.c_str(), -1, SQLITE_STATIC);
+	sqlite3_bind_int64(stmt, 2, size);
+	sqlite3_bind_int64(stmt, 3, mtime);
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		Data::probe_cache probe;
+		probe.m_file	= file;
+		probe.m_size	= size;
+		probe.m_mtime	= mtime;
+		if (sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+			probe.m_video_codec = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+		if (sqlite3_column_type(stmt, 1) != SQLITE_NULL)
+			probe.m_height = sqlite3_column_int(stmt, 1);
+		if (sqlite3_column_type(stmt, 2) != SQLITE_NULL)
+			probe.m_bitrate = sqlite3_column_int64(stmt, 2);
+		if (sqlite3_column_type(stmt, 3) != SQLITE_NULL)
+			probe.m_duration = sqlite3_column_double(stmt, 3);
+		if (sqlite3_column_type(stmt, 4) != SQLITE_NULL)
+			probe.m_frame_rate = sqlite3_column_double(stmt, 4);
+		probe.m_is_HDR = sqlite3_column_int(stmt, 5);
+		result = std::move(probe);
+	}
+	reset_stmt(stmt);
+	return result;
+}
+
+void Database::SQLite3::set_probe_cache(const std::list<Data::probe_cache>& probes) {
+	begin_transaction();
+	auto stmt = m_prepared["setProbeCache"];
+	for (auto it = probes.begin(); it != probes.end(); it++) {
+		sqlite3_bind_text(stmt, 1, it->m_file.c_str(), -1, SQLITE_STATIC);
+		sqlite3_bind_int64(stmt, 2, it->m_size);
+		sqlite3_bind_int64(stmt, 3, it->m_mtime);
+		if (it->m_video_codec)
+			sqlite3_bind_text(stmt, 4, it->m_video_codec->c_str(), -1, SQLITE_STATIC);
+		else
+			sqlite3_bind_null(stmt, 4);
+		if (it->m_height)
+			sqlite3_bind_int(stmt, 5, *it->m_height);
+		else
+			sqlite3_bind_null(stmt, 5);
+		if (it->m_bitrate)
+			sqlite3_bind_int64(stmt, 6, *it->m_bitrate);
+		else
+			sqlite3_bind_null(stmt, 6);
+		if (it->m_duration)
+			sqlite3_bind_double(stmt, 7, *it->m_duration);
+		else
+			sqlite3_bind_null(stmt, 7);
+		if (it->m_frame_rate)
+			sqlite3_bind_double(stmt, 8, *it->m_frame_rate);
+		else
+			sqlite3_bind_null(stmt, 8);
+		sqlite3_bind_int(stmt, 9, it->m_is_HDR);
+		sqlite3_step(stmt);
+		reset_stmt(stmt);
+	}
+	commit_transaction();
+}
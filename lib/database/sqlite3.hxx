@@ -1,17 +1,23 @@
 #pragma once
 
 #include "data.hxx"
+#include "profiler.hxx"
 #include "ffmpeg/ffmpeg.hxx"
 #include "utils/logger.hxx"
+#include "utils/walker.hxx"
 
 #include <filesystem>
 #include <map>
+#include <set>
+#include <chrono>
+#include <vector>
 #include <sqlite3.h>
 
 namespace StormByte::VideoConvert::Database {
 	class SQLite3 {
 		public:
-			SQLite3(const Types::path_t& dbfile, Types::logger_t logger = Types::logger_t());
+			/* Every statement run is accounted in profiler when given */
+			SQLite3(const Types::path_t& dbfile, Types::logger_t logger = Types::logger_t(), Types::profiler_t profiler = Types::profiler_t());
 			SQLite3(const SQLite3& db) = delete;
 			SQLite3(SQLite3&& db) = delete;
 			SQLite3& operator=(const SQLite3& db) = delete;
@@ -23,26 +29,67 @@ namespace StormByte::VideoConvert::Database {
 			bool is_film_in_database(const Types::path_t& file);
 			bool is_group_in_database(const Types::path_t& path);
 			bool is_group_empty(const Data::film::group& group);
+			std::optional<double> estimate_encode_time(const Data::film& film, const std::string& host);
+			std::optional<double> estimate_encode_time(const FFmpeg& ffmpeg, const std::string& host);
+			Data::queue_forecast get_queue_forecast(const std::string& host);
+			std::list<Data::film> get_next_films(const unsigned int& count); // Only id and file are filled
+			std::optional<uintmax_t> get_peak_memory(const FFmpeg& ffmpeg); // Highest recently measured for same profile
+			unsigned int get_queue_size(); // Films waiting to be processed
+			std::optional<Data::duplicate> find_duplicate(const Data::film::content& content); // Queued, being processed or already converted film with same content
+			std::optional<Data::probe_cache> get_probe_cache(const Types::path_t& file, const uintmax_t& size, const int64_t& mtime); // Only if file did not change
+			Utils::Walker::index_t get_scan_index(const Types::path_t& folder, const Data::scan_index& index_name = Data::ADD_INDEX); // Indexed folder and everything under it
 
 			/* Write data */
-			std::optional<FFmpeg> get_film_for_process();
-			void finish_film_process(const FFmpeg& ffmpeg, const bool& status);
+			std::optional<FFmpeg> get_film_for_process(const std::set<unsigned int>& skipped = {}); // Skipped ones are left for the next candidate
+			inline void finish_film_process(const FFmpeg& ffmpeg, const bool& status) { finish_film_process(ffmpeg.get_film_id(), status); }
+			void finish_film_process(const unsigned int& film_id, const bool& status);
+			void release_film_process(const FFmpeg& ffmpeg); // Film was claimed but can not be processed now
+			/* Returns film to queue after a delay doubled on every stall, marking it unsupported once it stalled max_stalls times (no value then) */
+			std::optional<std::chrono::seconds> retry_stalled_film(const FFmpeg& ffmpeg, const unsigned int& max_stalls, const std::chrono::seconds& delay);
 			void reset_processing_films();
 			std::optional<unsigned int> insert_film(const Data::film& film);
 			bool insert_films(const std::list<Data::film>& films);
+			/* Films already in database are skipped instead of failing the whole insert, returns their files (no value on error) */
+			std::optional<std::list<Types::path_t>> insert_new_films(const std::list<Data::film>& films);
 			std::optional<Data::film::group> insert_group(const Types::path_t& folder);
 			void delete_group(const Data::film::group& group);
+			/* Both only affect films not being processed, returning false otherwise */
+			bool set_film_priority(const unsigned int& film_id, const Data::film::priority& priority);
+			bool delete_queued_film(const unsigned int& film_id);
+			void insert_encode_history(const Data::encode_history& history);
+			std::optional<unsigned int> insert_finalization(const Data::finalization& finalization);
+			std::list<Data::finalization> get_pending_finalizations();
+			void finish_finalization(const Data::finalization& finalization, const bool& status);
+			void update_scan_index(const Utils::Walker::scan_result& scan, const Data::scan_index& index_name = Data::ADD_INDEX);
+			void set_probe_cache(const std::list<Data::probe_cache>& probes);
 
 		private:
+			/* Schema changes for databases created by older versions, applied in order according to PRAGMA user_version */
+			struct migration {
+				std::list<std::pair<std::string, std::string>> m_columns; // Table and column definition, only added when missing
+				std::list<std::string> m_statements; // Must be idempotent (IF NOT EXISTS)
+			};
+
 			sqlite3* m_database;
 			std::map<std::string, sqlite3_stmt*> m_prepared;
 			Types::logger_t m_logger;
+			Types::profiler_t m_profiler;
+			std::map<sqlite3_stmt*, std::string> m_statement_names; // Prepared ones, others are named by their SQL
+			std::map<sqlite3_stmt*, uintmax_t> m_statement_rows; // Returned by statements still running
+			std::optional<std::chrono::steady_clock::time_point> m_exclusive_start;
 			static const std::string DATABASE_CREATE_SQL;
+			static const std::vector<migration> DATABASE_MIGRATIONS; // Migration N upgrades database from version N to N + 1
 			static const std::map<std::string, std::string> DATABASE_PREPARED_SENTENCES;
+			static const unsigned int ENCODE_HISTORY_SAMPLES;
+			static const int BUSY_TIMEOUT;
 
 			/* Database internals */
 			bool check_database();
 			void init_database();
+			void migrate_database();
+			int get_database_version();
+			void set_database_version(const int& version);
+			bool has_column(const std::string& table, const std::string& column);
 			void prepare_sentences();
 			void throw_error(char* err_msg);
 			void reset_stmt(sqlite3_stmt*);
@@ -50,9 +97,11 @@ namespace StormByte::VideoConvert::Database {
 			void begin_exclusive_transaction();
 			void commit_transaction();
 			void rollback_transaction();
+			void end_exclusive_transaction();
+			static int trace(unsigned int type, void* context, void* statement, void* data);
 
 			/* Data managing internal functions */
-			std::optional<unsigned int> get_film_id_for_process();
+			std::optional<unsigned int> get_film_id_for_process(const std::set<unsigned int>& skipped);
 			std::optional<Data::film> get_film_data(const unsigned int& film_id);
 			std::optional<Data::film::group> get_group_data(const unsigned int& group_id);
 			std::list<Data::film::stream> get_film_streams(const unsigned int& film_id);
@@ -60,10 +109,16 @@ namespace StormByte::VideoConvert::Database {
 			void set_film_stream_HDR(const unsigned int& film_id, Data::film::stream& stream);
 			void insert_stream(const unsigned int& film_id, const Data::film::stream& stream);
 			void insert_HDR(const unsigned int& film_id, const Data::film::stream& stream);
+			void insert_converted_content(const unsigned int& film_id); // Keeps content fingerprint after film is deleted
 			void delete_film(const unsigned int& film_id);
 			void delete_film_stream(const unsigned int& film_id);
 			void delete_film_stream_HDR(const unsigned int& film_id);
 			void set_film_processing_status(const unsigned int& film_id, const bool& status);
 			void set_film_unsupported_status(const unsigned int& film_id, const bool& status);
+			void set_scan_folder_files(const Types::path_t& folder, const std::map<std::string, Utils::Walker::file_signature>& files, const Data::scan_index& index_name);
+			sqlite3_stmt* scan_statement(std::string name, const Data::scan_index& index_name);
+			std::optional<double> get_encode_speed(const Data::film::stream::codec& codec, const unsigned short& resolution, const bool& is_HDR, const bool& is_animation, const std::string& host);
+			std::optional<double> get_encode_speed(sqlite3_stmt* stmt);
+			std::optional<double> estimate_encode_time(const Data::film::stream::codec& codec, const unsigned short& resolution, const bool& is_HDR, const bool& is_animation, const double& duration, const std::string& host);
 	};
 }
\ No newline at end of file
@@ -1,8 +1,15 @@
 #include "ffmpeg.hxx"
 #include "utils/logger.hxx"
+#include "ffprobe/ffprobe.hxx"
+
+#include <algorithm>
 
 using namespace StormByte::VideoConvert;
 
+const double FFmpeg::OUTPUT_SIZE_MARGIN = 1.1; // Max rate is not strictly followed and non video streams are not accounted
+const uintmax_t FFmpeg::BASE_MEMORY_USAGE = 256 * 1024 * 1024; // Decoder, demuxer and muxer
+const unsigned int FFmpeg::ENCODER_FRAMES_IN_MEMORY = 80; // Lookahead, reference and frame threads buffers with analysis data
+
 FFmpeg::FFmpeg(const unsigned int& film_id, const Types::path_t& input_file, const std::optional<Database::Data::film::group>& group): m_film_id(film_id), m_input_file(input_file), m_group(group), m_container("mkv"), m_video_position(0), m_audio_position(0), m_subtitle_position(0) {}
 
 FFmpeg::FFmpeg(unsigned int&& film_id, Types::path_t&& input_file, std::optional<Database::Data::film::group>&& group): m_film_id(film_id), m_input_file(std::move(input_file)), m_group(std::move(group)), m_container("mkv"), m_video_position(0), m_audio_position(0), m_subtitle_position(0) {}
@@ -28,3 +35,70 @@ Types::path_t FFmpeg::get_output_file() const {
 	auto result = parent / (m_title ? m_title->filename() : m_input_file.filename());
 	return result.replace_extension(m_container);
 }
+
+std::optional<Database::Data::film::stream::codec> FFmpeg::get_video_codec() const {
+	auto video = get_video_stream();
+	return video ? video->get_codec() : std::optional<Database::Data::film::stream::codec>();
+}
+
+bool FFmpeg::is_HDR() const {
+	auto video = get_video_stream();
+	return video && video->is_HDR();
+}
+
+bool FFmpeg::is_animation() const {
+	auto video = get_video_stream();
+	return video && video->is_animation();
+}
+
+std::shared_ptr<const Stream::Video::Base> FFmpeg::get_video_stream() const {
+	std::shared_ptr<const Stream::Video::Base> result;
+	for (auto it = m_streams.begin(); it != m_streams.end() && !result; it++) {
+		if ((*it)->get_type() == 'v')
+			result = std::dynamic_pointer_cast<const Stream::Video::Base>(*it);
+	}
+	return result;
+}
+
+uintmax_t FFmpeg::estimate_output_size(const uintmax_t& input_size) const {
+	// Copied streams keep their size, so input size is the estimation unless video is reencoded with a known max rate
+	double result = input_size;
+	auto video = get_video_stream();
+	if (video && video->get_codec() != Database::Data::film::stream::VIDEO_COPY && video->get_max_rate() && m_duration) {
+		auto max_rate = bitrate_to_bits(*video->get_max_rate());
+		if (max_rate)
+			result = std::min(result, *m_duration * *max_rate / 8);
+	}
+	return static_cast<uintmax_t>(result * OUTPUT_SIZE_MARGIN);
+}
+
+std::optional<uintmax_t> FFmpeg::estimate_memory_usage() const {
+	std::optional<uintmax_t> result;
+	auto video = get_video_stream();
+	if (!video || video->get_codec() == Database::Data::film::stream::VIDEO_COPY)
+		result = BASE_MEMORY_USAGE;
+	else if (m_resolution && FFprobe::stream::RESOLUTION_MAX_HEIGHT.contains(static_cast<FFprobe::stream::RESOLUTION>(*m_resolution))) {
+		// Assuming 16:9 frames with 16 bit 4:2:0 pixels as used internally by 10 bit encoders
+		const uintmax_t height = FFprobe::stream::RESOLUTION_MAX_HEIGHT.at(static_cast<FFprobe::stream::RESOLUTION>(*m_resolution));
+		const uintmax_t frame_size = (height * 16 / 9) * height * 3;
+		result = BASE_MEMORY_USAGE + frame_size * ENCODER_FRAMES_IN_MEMORY;
+	}
+	return result;
+}
+
+std::optional<double> FFmpeg::bitrate_to_bits(const std::string& bitrate) {
+	std::optional<double> result;
+	try {
+		size_t pos;
+		double value = std::stod(bitrate, &pos);
+		const std::string suffix = bitrate.substr(pos);
+		if (suffix.empty()) result = value;
+		else if (suffix == "k" || suffix == "K") result = value * 1000;
+		else if (suffix == "m" || suffix == "M") result = value * 1000 * 1000;
+		else if (suffix == "g" || suffix == "G") result = value * 1000 * 1000 * 1000;
+	}
+	catch (const std::exception&) {
+		// Unknown format, it is ignored
+	}
+	return result;
+}
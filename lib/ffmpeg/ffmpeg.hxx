@@ -49,9 +49,20 @@ namespace StormByte::VideoConvert {
 			inline Types::path_t get_input_file() const { return m_input_file; }
 			Types::path_t get_output_file() const;
 			inline const auto& get_streams() const { return m_streams; }
+			std::optional<Database::Data::film::stream::codec> get_video_codec() const;
+			bool is_HDR() const;
+			bool is_animation() const;
+			inline std::optional<double> get_duration() const { return m_duration; }
+			inline std::optional<unsigned short> get_resolution() const { return m_resolution; }
+			inline std::optional<double> get_frame_rate() const { return m_frame_rate; }
+			uintmax_t estimate_output_size(const uintmax_t& input_size) const;
+			std::optional<uintmax_t> estimate_memory_usage() const; // Rough guess used until real usage is measured
 
 			/* Setters */
 			inline void set_title(const Types::path_t& title) { m_title = title; }
+			inline void set_duration(const double& duration) { m_duration = duration; }
+			inline void set_resolution(const unsigned short& resolution) { m_resolution = resolution; }
+			inline void set_frame_rate(const double& frame_rate) { m_frame_rate = frame_rate; }
 
 		private:
 			unsigned int m_film_id;
@@ -61,5 +72,14 @@ namespace StormByte::VideoConvert {
 			Types::path_t m_container; // For future
 			std::list<std::shared_ptr<StormByte::VideoConvert::Stream::Base>> m_streams;
 			unsigned short m_video_position, m_audio_position, m_subtitle_position;
+			std::optional<double> m_duration, m_frame_rate;
+			std::optional<unsigned short> m_resolution;
+
+			std::shared_ptr<const Stream::Video::Base> get_video_stream() const;
+			static std::optional<double> bitrate_to_bits(const std::string& bitrate);
+
+			static const double OUTPUT_SIZE_MARGIN;
+			static const uintmax_t BASE_MEMORY_USAGE;
+			static const unsigned int ENCODER_FRAMES_IN_MEMORY;
 	};
 }
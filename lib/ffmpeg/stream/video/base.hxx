@@ -15,7 +15,10 @@ namespace StormByte::VideoConvert::Stream::Video {
 			
 			virtual std::list<std::string> ffmpeg_parameters() const override;
 			inline void set_tune_animation() { m_is_animation = true; }
+			inline bool is_animation() const { return m_is_animation; }
+			virtual inline bool is_HDR() const { return false; }
 			inline void set_max_rate(const std::string& max_rate) { m_max_rate = max_rate; }
+			inline std::optional<std::string> get_max_rate() const { return m_max_rate; }
 
 		protected:
 			bool m_is_animation;
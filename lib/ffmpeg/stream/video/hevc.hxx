@@ -56,6 +56,7 @@ namespace StormByte::VideoConvert::Stream::Video {
 			inline void set_HDR(HDR&& hdr) { m_hdr = std::move(hdr); }
 			inline void set_HDR(const Database::Data::film::stream::hdr& hdr) { m_hdr = hdr; }
 			inline void set_HDR(Database::Data::film::stream::hdr&& hdr) { m_hdr = std::move(hdr); }
+			inline bool is_HDR() const override { return m_hdr.has_value(); }
 			std::list<std::string> ffmpeg_parameters() const override;
 			
 			static const HDR DEFAULT_HDR;
@@ -36,20 +36,59 @@ FFprobe FFprobe::from_file(const Types::path_t& file) noexcept {
 	return probe;
 }
 
-void FFprobe::initialize(const Types::path_t& file) noexcept {
-	std::unique_ptr<Task::Execute::FFprobe::Base> task;
-
-	task.reset(new Task::Execute::FFprobe::VideoColor(file));
-	if (task->run() == Task::HALT_OK)
-		initialize_video_color_data(task->get_stdout());
-	for (const auto type : { stream::VIDEO, stream::AUDIO, stream::SUBTITLE }) {
-		task.reset(new Task::Execute::FFprobe::Stream(file, type));
-		if (task->run() == Task::HALT_OK)
-			initialize_stream_data(task->get_stdout(), type);
+FFprobe FFprobe::resolution_from_file(const Types::path_t& file) noexcept {
+	FFprobe probe;
+	Task::Execute::FFprobe::VideoResolution task(file);
+	if (task.run() == Task::HALT_OK)
+		probe.initialize_video_resolution(task.get_stdout());
+	return probe;
+}
+
+std::vector<FFprobe> FFprobe::resolution_from_files(const std::vector<Types::path_t>& files) noexcept {
+	std::vector<FFprobe> probes(files.size());
+	std::vector<Task::Execute::FFprobe::VideoResolution> tasks;
+	tasks.reserve(files.size()); // Pointers to them are taken below
+	std::vector<Task::Async::Base*> pointers;
+	for (const auto& file: files) {
+		tasks.emplace_back(file);
+		pointers.push_back(&tasks.back());
 	}
-	task.reset(new Task::Execute::FFprobe::VideoResolution(file));
-	if (task->run() == Task::HALT_OK)
-		initialize_video_resolution(task->get_stdout());
+
+	const auto status = Task::Async::Base::run_all(pointers);
+	for (size_t i = 0; i < files.size(); i++)
+		if (status[i] == Task::HALT_OK)
+			probes[i].initialize_video_resolution(tasks[i].get_stdout());
+	return probes;
+}
+
+FFprobe FFprobe::from_outputs(const std::string& color, const std::string& video, const std::string& audio, const std::string& subtitle, const std::string& resolution) noexcept {
+	FFprobe probe;
+	probe.initialize_video_color_data(color);
+	probe.initialize_stream_data(video, stream::VIDEO);
+	probe.initialize_stream_data(audio, stream::AUDIO);
+	probe.initialize_stream_data(subtitle, stream::SUBTITLE);
+	probe.initialize_video_resolution(resolution);
+	return probe;
+}
+
+void FFprobe::initialize(const Types::path_t& file) noexcept {
+	Task::Execute::FFprobe::VideoColor color_task(file);
+	Task::Execute::FFprobe::Stream video_task(file, stream::VIDEO), audio_task(file, stream::AUDIO), subtitle_task(file, stream::SUBTITLE);
+	Task::Execute::FFprobe::VideoResolution resolution_task(file);
+
+	// All probes are independent so they are run concurrently
+	const auto status = Task::Async::Base::run_all({ &color_task, &video_task, &audio_task, &subtitle_task, &resolution_task });
+
+	if (status[0] == Task::HALT_OK)
+		initialize_video_color_data(color_task.get_stdout());
+	if (status[1] == Task::HALT_OK)
+		initialize_stream_data(video_task.get_stdout(), stream::VIDEO);
+	if (status[2] == Task::HALT_OK)
+		initialize_stream_data(audio_task.get_stdout(), stream::AUDIO);
+	if (status[3] == Task::HALT_OK)
+		initialize_stream_data(subtitle_task.get_stdout(), stream::SUBTITLE);
+	if (status[4] == Task::HALT_OK)
+		initialize_video_resolution(resolution_task.get_stdout());
 }
 
 void FFprobe::initialize_video_color_data(const std::string& json) {
@@ -104,6 +143,23 @@ void FFprobe::initialize_video_resolution(const std::string& json) {
 				for (auto it2 = it->begin(); it2 != it->end(); it2++)
 					if (it2.key() == "height" && it2->isUInt()) m_height = it2->asUInt();
 					else if (it2.key() == "width" && it2->isUInt()) m_width = it2->asUInt();
+					else if (it2.key() == "codec_name" && it2->isString()) m_video_codec = it2->asString();
+					else if (it2.key() == "color_transfer" && it2->isString()) m_color_transfer = it2->asString();
+					else if (it2.key() == "r_frame_rate" && it2->isString()) {
+						// Frame rate comes as a fraction like 24000/1001
+						const std::string frame_rate = it2->asString();
+						const size_t slash = frame_rate.find("/");
+						const double numerator = std::stod(frame_rate.substr(0, slash));
+						const double denominator = slash == std::string::npos ? 1.0 : std::stod(frame_rate.substr(slash + 1));
+						if (numerator > 0 && denominator > 0) m_frame_rate = numerator / denominator;
+					}
+
+			// Duration is only reliable at container level (streams in mkv do not have it)
+			const auto format = (*root)["format"];
+			if (format.isObject() && format["duration"].isString())
+				m_duration = std::stod(format["duration"].asString());
+			if (format.isObject() && format["bit_rate"].isString())
+				m_bitrate = std::stoull(format["bit_rate"].asString());
 		}
 		catch(const std::exception& e) {
 			// We just ignore
@@ -140,21 +196,24 @@ void FFprobe::initialize_stream_data(const std::string& json, const stream::TYPE
 }
 
 std::optional<FFprobe::stream::RESOLUTION> FFprobe::get_resolution() const {
+	// Width is ignored
+	// The protection is needed because somehow video resolution might not be detected by FFprobe, just in case...
+	return m_height ? resolution_from_height(*m_height) : std::optional<stream::RESOLUTION>();
+}
+
+std::optional<FFprobe::stream::RESOLUTION> FFprobe::resolution_from_height(const unsigned short& height) {
 	std::optional<FFprobe::stream::RESOLUTION> res;
 
-	if (m_height) { // Width is ignored
-		// The protection is needed because somehow video resolution might not be detected by FFprobe, just in case...
-		if (*m_height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_480P))
-			res = stream::RES_480P;
-		else if (*m_height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_720P))
-			res = stream::RES_720P;
-		else if (*m_height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_1080P))
-			res = stream::RES_1080P;
-		else if (*m_height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_4K))
-			res = stream::RES_4K;
-		else if (*m_height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_8K))
-			res = stream::RES_8K;
-	}
+	if (height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_480P))
+		res = stream::RES_480P;
+	else if (height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_720P))
+		res = stream::RES_720P;
+	else if (height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_1080P))
+		res = stream::RES_1080P;
+	else if (height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_4K))
+		res = stream::RES_4K;
+	else if (height <= stream::RESOLUTION_MAX_HEIGHT.at(stream::RES_8K))
+		res = stream::RES_8K;
 
 	return res;
 }
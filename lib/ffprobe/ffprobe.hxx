@@ -18,6 +18,12 @@ namespace StormByte::VideoConvert {
 			~FFprobe() = default;
 
 			static FFprobe from_file(const Types::path_t&) noexcept;
+			/* Only probes first video stream (codec, resolution, frame rate and color transfer) and container duration and bitrate in a single run */
+			static FFprobe resolution_from_file(const Types::path_t&) noexcept;
+			/* Same for several files, running all probes concurrently */
+			static std::vector<FFprobe> resolution_from_files(const std::vector<Types::path_t>&) noexcept;
+			/* From already captured ffprobe outputs (same probes as initialize runs), used for recorded fixtures */
+			static FFprobe from_outputs(const std::string& color, const std::string& video, const std::string& audio, const std::string& subtitle, const std::string& resolution) noexcept;
 
 			struct stream {
 				enum TYPE: char { VIDEO = 'v', AUDIO = 'a', SUBTITLE = 's' };
@@ -40,7 +46,13 @@ namespace StormByte::VideoConvert {
 			inline std::optional<std::string>		get_color_transfer() const { return m_color_transfer; }
 			inline const auto&						get_stream(const stream::TYPE& type) const { return m_streams.at(type); }
 			inline std::optional<unsigned short>	get_width() const { return m_width; }
+			inline std::optional<unsigned short>	get_height() const { return m_height; }
 			std::optional<stream::RESOLUTION>		get_resolution() const;
+			static std::optional<stream::RESOLUTION>	resolution_from_height(const unsigned short& height);
+			inline std::optional<double>			get_duration() const { return m_duration; }
+			inline std::optional<double>			get_frame_rate() const { return m_frame_rate; }
+			inline std::optional<std::string>		get_video_codec() const { return m_video_codec; }
+			inline std::optional<uintmax_t>			get_bitrate() const { return m_bitrate; } // Whole container in bits per second
 
 
 			#ifdef ENABLE_HEVC
@@ -57,6 +69,9 @@ namespace StormByte::VideoConvert {
 			
 			std::optional<std::string> m_pix_fmt, m_color_space, m_color_primaries, m_color_transfer;
 			std::optional<unsigned short> m_width, m_height;
+			std::optional<double> m_duration, m_frame_rate;
+			std::optional<std::string> m_video_codec;
+			std::optional<uintmax_t> m_bitrate;
 			/* HDR */
 			#ifdef ENABLE_HEVC
 			std::optional<std::string> m_red_x, m_red_y, m_green_x, m_green_y, m_blue_x, m_blue_y, m_white_point_x, m_white_point_y, m_min_luminance, m_max_luminance, m_max_content, m_max_average;
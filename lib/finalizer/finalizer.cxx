@@ -0,0 +1,211 @@
+#include "finalizer.hxx"
+#include "utils/filesystem.hxx"
+#include "utils/display.hxx"
+
+#include <csignal>
+#include <pthread.h>
+
+using namespace StormByte::VideoConvert;
+
+Finalizer::Finalizer(const Types::path_t& dbfile, const Types::path_t& input_folder, Types::storage_pool_t storage, Types::logger_t logger, Types::profiler_t profiler):m_input_folder(input_folder), m_storage(storage), m_logger(logger), m_database(new Database::SQLite3(dbfile, logger, profiler)), m_stop(false) {}
+
+Finalizer::~Finalizer() {
+	stop();
+}
+
+void Finalizer::start() {
+	auto pending = m_database->get_pending_finalizations();
+	if (!pending.empty())
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Recovering ", pending.size(), " pending finalization(s)");
+	for (auto it = pending.begin(); it != pending.end(); it++)
+		enqueue(*it);
+
+	// Signals have to be delivered to main thread so they can interrupt its sleep
+	sigset_t all_signals, previous_signals;
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_BLOCK, &all_signals, &previous_signals);
+	m_thread = std::thread(&Finalizer::worker, this);
+	pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+}
+
+void Finalizer::stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+		if (!m_queue.empty())
+			m_logger->message_line(Utils::Logger::LEVEL_NOTICE, m_queue.size(), " finalization(s) will be resumed on next start");
+	}
+	m_condition.notify_all();
+	if (m_thread.joinable()) {
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Waiting for finalizer to finish");
+		m_thread.join();
+	}
+}
+
+void Finalizer::enqueue(const Database::Data::finalization& finalization) {
+	// Published files are renamed in the same filesystem so they do not need extra space
+	std::error_code error;
+	uintmax_t reserved = 0;
+	if (finalization.m_action != Database::Data::finalization::PUBLISH) {
+		reserved = std::filesystem::file_size(finalization.m_work_file, error);
+		if (error) reserved = 0;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push(finalization);
+		m_reserved_output_space[*finalization.m_id] = reserved;
+	}
+	m_condition.notify_one();
+}
+
+uintmax_t Finalizer::get_reserved_output_space() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uintmax_t result = 0;
+	for (auto it = m_reserved_output_space.begin(); it != m_reserved_output_space.end(); it++)
+		result += it->second;
+	return result;
+}
+
+void Finalizer::worker() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_condition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+		if (m_stop) break;
+
+		Database::Data::finalization finalization = std::move(m_queue.front());
+		m_queue.pop();
+		lock.unlock();
+
+		auto phase_start = std::chrono::steady_clock::now();
+		Utils::Display::timings timings;
+		const bool status = finalize(finalization);
+		Utils::Display::add_timing(timings, "finalize", phase_start);
+		m_database->finish_finalization(finalization, status);
+		if (status && finalization.m_group && m_database->is_group_empty(*finalization.m_group))
+			cleanup_group(*finalization.m_group);
+		Utils::Display::add_timing(timings, "finalize_record", phase_start);
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Timings for ", finalization.m_input_file, " (ms): ", Utils::Display::timings_to_string(timings));
+
+		lock.lock();
+		m_reserved_output_space.erase(*finalization.m_id);
+	}
+}
+
+bool Finalizer::finalize(const Database::Data::finalization& finalization) {
+	bool io_failed = false;
+	std::list<Types::path_t> mirror_files = get_pending_mirror_files(finalization.m_output_file);
+	bool mirrors_written = mirror_files.empty();
+	std::list<Types::path_t> used_paths = { finalization.m_work_file, finalization.m_output_file };
+	used_paths.insert(used_paths.end(), mirror_files.begin(), mirror_files.end());
+	// Waits if any of the devices is already at its concurrency limit
+	Storage::Pool::Lease lease = m_storage->acquire(used_paths);
+	const uintmax_t max_rate = m_storage->get_bandwidth(used_paths);
+
+	try {
+		if (!std::filesystem::exists(finalization.m_work_file) && std::filesystem::exists(finalization.m_output_file)) {
+			// Daemon was stopped after the file was moved but before database was updated
+			m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Output ", finalization.m_output_file, " already exists, skipping move/copy");
+		}
+		else {
+			if (!std::filesystem::exists(finalization.m_output_file.parent_path())) {
+				m_logger->message_line(Utils::Logger::LEVEL_NOTICE, "Create output path: ", finalization.m_output_file.parent_path());
+				std::filesystem::create_directories(finalization.m_output_file.parent_path());
+			}
+			if (finalization.m_action == Database::Data::finalization::PUBLISH) {
+				// No fallback here: if destination exists it must not be overwritten
+				m_logger->message_line(Utils::Logger::LEVEL_INFO, "Publish: ", finalization.m_work_file, " -> ", finalization.m_output_file);
+				Utils::Filesystem::publish_file(finalization.m_work_file, finalization.m_output_file);
+			}
+			else if (finalization.m_action == Database::Data::finalization::MOVE) {
+				try {
+					m_logger->message_line(Utils::Logger::LEVEL_INFO, "Move: ", finalization.m_work_file, " -> ", finalization.m_output_file);
+					std::filesystem::rename(finalization.m_work_file, finalization.m_output_file);
+				}
+				catch (const std::exception& e) {
+					m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Move failed because ", e.what(), " attempting copy");
+					io_failed = true;
+				}
+			}
+			if (io_failed || finalization.m_action == Database::Data::finalization::COPY) {
+				try {
+					// Mirrors are written in the same pass so work file is read only once
+					std::list<Types::path_t> destinations = { finalization.m_output_file };
+					destinations.insert(destinations.end(), mirror_files.begin(), mirror_files.end());
+					m_logger->message_line(Utils::Logger::LEVEL_INFO, "Copy: ", finalization.m_work_file, " -> ", finalization.m_output_file, (mirror_files.empty() ? "" : " and " + std::to_string(mirror_files.size()) + " mirror(s)"));
+					auto failed = Utils::Filesystem::copy_file(finalization.m_work_file, destinations, max_rate);
+					mirrors_written = true;
+					if (failed.contains(finalization.m_output_file)) {
+						m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Copy failed because ", failed.at(finalization.m_output_file));
+						failed.erase(finalization.m_output_file);
+						io_failed = true;
+					}
+					else {
+						m_logger->message_line(Utils::Logger::LEVEL_INFO, "Delete work: ", finalization.m_work_file);
+						std::filesystem::remove(finalization.m_work_file);
+						io_failed = false;
+					}
+					log_mirror_failures(failed);
+				}
+				catch (const std::exception& e) {
+					m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Copy failed because ", e.what());
+					io_failed = true;
+				}
+			}
+		}
+		if (!io_failed && !mirrors_written) {
+			m_logger->message_line(Utils::Logger::LEVEL_INFO, "Mirror: ", finalization.m_output_file, " -> ", mirror_files.size(), " mirror(s)");
+			log_mirror_failures(Utils::Filesystem::copy_file(finalization.m_output_file, mirror_files, max_rate));
+		}
+		if (!io_failed) {
+			m_logger->message_line(Utils::Logger::LEVEL_INFO, "Delete input: ", finalization.m_input_file);
+			std::filesystem::remove(finalization.m_input_file);
+		}
+	}
+	catch (const std::exception& e) {
+		m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Finalization for ", finalization.m_input_file, " failed because ", e.what());
+		io_failed = true;
+	}
+
+	return !io_failed;
+}
+
+void Finalizer::cleanup_group(const Database::Data::film::group& group) {
+	try {
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Deleting group input folder: ", m_input_folder / group.folder, " recursivelly");
+		std::filesystem::remove_all(m_input_folder / group.folder);
+		for (const Storage::root& root: m_storage->get_roots(Storage::root::WORK)) {
+			if (std::filesystem::exists(root.m_path / group.folder)) {
+				m_logger->message_line(Utils::Logger::LEVEL_INFO, "Deleting group work folder: ", root.m_path / group.folder, " recursivelly");
+				std::filesystem::remove_all(root.m_path / group.folder);
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Group cleanup failed because ", e.what());
+	}
+	m_database->delete_group(group);
+}
+
+std::list<Types::path_t> Finalizer::get_pending_mirror_files(const Types::path_t& output_file) const {
+	std::list<Types::path_t> result;
+	auto output_root = m_storage->find_root(output_file);
+	if (!output_root) return result;
+
+	// Mirrors keep the same layout than output root
+	const Types::path_t relative = output_file.lexically_relative(output_root->m_path);
+	for (const Storage::root& root: m_storage->get_roots(Storage::root::MIRROR)) {
+		const Types::path_t mirror_file = root.m_path / relative;
+		if (std::filesystem::exists(mirror_file)) continue; // Written before a restart, copies only appear at their final path once complete
+		std::error_code error;
+		std::filesystem::create_directories(mirror_file.parent_path(), error);
+		result.push_back(mirror_file);
+	}
+	return result;
+}
+
+void Finalizer::log_mirror_failures(const std::map<Types::path_t, std::string>& failed) const {
+	// Film is already in output so a failed mirror does not fail the finalization
+	for (auto it = failed.begin(); it != failed.end(); it++)
+		m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Mirror ", it->first, " failed because ", it->second);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "database/sqlite3.hxx"
+#include "utils/logger.hxx"
+#include "storage/pool.hxx"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <map>
+
+namespace StormByte::VideoConvert {
+	/* Moves/copies converted films to output and does the cleanup in background so next conversion can start */
+	class Finalizer {
+		public:
+			Finalizer(const Types::path_t& dbfile, const Types::path_t& input_folder, Types::storage_pool_t storage, Types::logger_t logger, Types::profiler_t profiler);
+			Finalizer(const Finalizer&) = delete;
+			Finalizer(Finalizer&&) = delete;
+			Finalizer& operator=(const Finalizer&) = delete;
+			Finalizer& operator=(Finalizer&&) = delete;
+			~Finalizer();
+
+			/* Starts the worker recovering pending finalizations from database */
+			void start();
+			/* Ends current finalization (if any), queued ones will be recovered on next start */
+			void stop();
+			void enqueue(const Database::Data::finalization& finalization);
+			/* Bytes still to be written in output by queued and running finalizations */
+			uintmax_t get_reserved_output_space();
+
+		private:
+			void worker();
+			bool finalize(const Database::Data::finalization& finalization);
+			void cleanup_group(const Database::Data::film::group& group);
+			/* Files in mirror roots not yet written for this output file */
+			std::list<Types::path_t> get_pending_mirror_files(const Types::path_t& output_file) const;
+			void log_mirror_failures(const std::map<Types::path_t, std::string>& failed) const;
+
+			Types::path_t m_input_folder;
+			Types::storage_pool_t m_storage;
+			Types::logger_t m_logger;
+			Types::database_t m_database; // Own connection as it is used from worker thread
+			std::thread m_thread;
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			std::queue<Database::Data::finalization> m_queue;
+			std::map<unsigned int, uintmax_t> m_reserved_output_space; // Finalization id -> bytes
+			bool m_stop;
+	};
+}
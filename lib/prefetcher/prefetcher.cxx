@@ -0,0 +1,174 @@
+#include "prefetcher.hxx"
+#include "utils/filesystem.hxx"
+
+#include <csignal>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+
+using namespace StormByte::VideoConvert;
+
+const Types::path_t Prefetcher::STAGING_FOLDER = ".prefetch";
+
+Prefetcher::Prefetcher(const Types::path_t& input_folder, Types::storage_pool_t storage, const uintmax_t& max_rate, admit_t admit, Types::logger_t logger):m_input_folder(input_folder), m_storage(storage), m_max_rate(max_rate), m_admit(admit), m_logger(logger), m_reserved(0), m_cancel(false), m_stop(false) {}
+
+Prefetcher::~Prefetcher() {
+	stop();
+}
+
+void Prefetcher::start() {
+	// Staged files are not tracked between runs
+	for (const Storage::root& root: m_storage->get_roots(Storage::root::WORK)) {
+		std::error_code error;
+		std::filesystem::remove_all(root.m_path / STAGING_FOLDER, error);
+		std::filesystem::create_directories(root.m_path / STAGING_FOLDER);
+	}
+
+	// Signals have to be delivered to main thread so they can interrupt its sleep
+	sigset_t all_signals, previous_signals;
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_BLOCK, &all_signals, &previous_signals);
+	m_thread = std::thread(&Prefetcher::worker, this);
+	pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+}
+
+void Prefetcher::stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+		m_cancel = true;
+	}
+	m_condition.notify_all();
+	if (m_thread.joinable()) {
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Waiting for prefetcher to finish");
+		m_thread.join();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto it = m_staged.begin(); it != m_staged.end(); it++)
+			discard(it->second);
+		m_staged.clear();
+	}
+}
+
+void Prefetcher::prefetch(const std::list<Database::Data::film>& films, const uintmax_t& reserved) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_wanted = films;
+		m_reserved = reserved;
+		for (auto it = m_staged.begin(); it != m_staged.end();) {
+			if (!is_wanted(it->first)) {
+				discard(it->second);
+				it = m_staged.erase(it);
+			}
+			else
+				it++;
+		}
+		if (m_current && !is_wanted(*m_current))
+			m_cancel = true;
+	}
+	m_condition.notify_one();
+}
+
+Types::optional_path_t Prefetcher::take(const unsigned int& film_id) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Types::optional_path_t result;
+	m_wanted.remove_if([&film_id](const Database::Data::film& film) { return *film.m_id == film_id; });
+	if (m_current && *m_current == film_id) {
+		// Waiting would be slower than reading from input directly
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Film ", film_id, " was not fully staged, cancelling");
+		m_cancel = true;
+	}
+	auto staged = m_staged.find(film_id);
+	if (staged != m_staged.end()) {
+		result = staged->second;
+		m_staged.erase(staged);
+	}
+	return result;
+}
+
+void Prefetcher::worker() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		auto next = m_wanted.end();
+		m_condition.wait(lock, [this, &next] {
+			next = std::find_if(m_wanted.begin(), m_wanted.end(), [this](const Database::Data::film& film) { return !m_staged.contains(*film.m_id); });
+			return m_stop || next != m_wanted.end();
+		});
+		if (m_stop) break;
+
+		const Database::Data::film film = *next;
+		m_current = *film.m_id;
+		m_cancel = false;
+		lock.unlock();
+
+		Types::optional_path_t staged = stage(film);
+
+		lock.lock();
+		m_current.reset();
+		if (is_wanted(*film.m_id))
+			m_staged[*film.m_id] = staged;
+		else
+			discard(staged);
+	}
+}
+
+Types::optional_path_t Prefetcher::stage(const Database::Data::film& film) {
+	const Types::path_t input_file = m_input_folder / film.m_file;
+	Types::optional_path_t result;
+
+	if (!Utils::Filesystem::is_network_filesystem(input_file)) {
+		// Local disks are fast enough so only read ahead is requested to the kernel
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Hinting read ahead for ", input_file);
+		int fd = open(input_file.c_str(), O_RDONLY);
+		if (fd != -1) {
+			posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+			close(fd);
+		}
+		return result;
+	}
+
+	std::error_code error;
+	const uintmax_t size = std::filesystem::file_size(input_file, error);
+	if (error) return result;
+	uintmax_t reserved;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		reserved = m_reserved;
+	}
+	// Same admission than encodes so staging never takes the space running encode was admitted for
+	auto root = m_storage->select(Storage::root::WORK, [&](const Storage::root& candidate) {
+		return m_admit(candidate.m_path, size + reserved);
+	});
+	if (!root) {
+		m_logger->message_line(Utils::Logger::LEVEL_INFO, "Not staging ", input_file, " as there is not enough free space");
+		return result;
+	}
+
+	const Types::path_t staging_folder = root->m_path / STAGING_FOLDER;
+	const Types::path_t staged_file = staging_folder / (std::to_string(*film.m_id) + film.m_file.extension().string());
+	Storage::Pool::Lease lease = m_storage->acquire({ staged_file });
+	// Lowest of configured and device limits
+	const uintmax_t device_rate = m_storage->get_bandwidth({ staged_file });
+	const uintmax_t max_rate = m_max_rate == 0 || (device_rate > 0 && device_rate < m_max_rate) ? device_rate : m_max_rate;
+	m_logger->message_line(Utils::Logger::LEVEL_INFO, "Staging ", input_file, " -> ", staged_file);
+	try {
+		Utils::Filesystem::copy_file(input_file, staged_file, max_rate, [this] { return m_cancel.load(); });
+		result = staged_file;
+	}
+	catch (const std::exception& e) {
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Staging of ", input_file, " not completed: ", e.what());
+	}
+	return result;
+}
+
+bool Prefetcher::is_wanted(const unsigned int& film_id) const {
+	return std::find_if(m_wanted.begin(), m_wanted.end(), [&film_id](const Database::Data::film& film) { return *film.m_id == film_id; }) != m_wanted.end();
+}
+
+void Prefetcher::discard(const Types::optional_path_t& file) const {
+	if (file) {
+		m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Discarding staged file ", *file);
+		std::error_code error;
+		std::filesystem::remove(*file, error);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "database/data.hxx"
+#include "storage/pool.hxx"
+#include "utils/logger.hxx"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <list>
+#include <map>
+#include <functional>
+
+namespace StormByte::VideoConvert {
+	/* Stages next queued films from (slow) input storage into work storage in background so encodes read from local disk */
+	class Prefetcher {
+		public:
+			/* Whether folder can take needed bytes keeping the configured free space */
+			using admit_t = std::function<bool(const Types::path_t& folder, const uintmax_t& needed)>;
+
+			/* Files are staged in work roots of storage accepted by admit, sharing their device limits */
+			Prefetcher(const Types::path_t& input_folder, Types::storage_pool_t storage, const uintmax_t& max_rate, admit_t admit, Types::logger_t logger);
+			Prefetcher(const Prefetcher&) = delete;
+			Prefetcher(Prefetcher&&) = delete;
+			Prefetcher& operator=(const Prefetcher&) = delete;
+			Prefetcher& operator=(Prefetcher&&) = delete;
+			~Prefetcher();
+
+			/* Starts the worker discarding staged files from previous runs */
+			void start();
+			void stop();
+			/* Sets the films which will be needed next, in order, previously staged films not in list are discarded */
+			/* Reserved bytes (what running encode will still write) are kept free when admitting staged files */
+			void prefetch(const std::list<Database::Data::film>& films, const uintmax_t& reserved);
+			/* Returns staged copy of a film (if completed), caller owns the file afterwards */
+			Types::optional_path_t take(const unsigned int& film_id);
+
+		private:
+			void worker();
+			Types::optional_path_t stage(const Database::Data::film& film);
+			bool is_wanted(const unsigned int& film_id) const;
+			void discard(const Types::optional_path_t& file) const;
+
+			Types::path_t m_input_folder;
+			Types::storage_pool_t m_storage;
+			uintmax_t m_max_rate; // Bytes per second, 0 means unlimited
+			admit_t m_admit;
+			Types::logger_t m_logger;
+			std::thread m_thread;
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			std::list<Database::Data::film> m_wanted;
+			std::map<unsigned int, Types::optional_path_t> m_staged; // Film id -> staged file (no value if file was just hinted to kernel)
+			std::optional<unsigned int> m_current;
+			uintmax_t m_reserved;
+			std::atomic<bool> m_cancel;
+			bool m_stop;
+
+			static const Types::path_t STAGING_FOLDER; // Inside every work root
+	};
+}
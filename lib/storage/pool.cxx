@@ -0,0 +1,113 @@
+#include "pool.hxx"
+#include "utils/filesystem.hxx"
+
+#include <algorithm>
+
+using namespace StormByte::VideoConvert;
+
+Storage::Pool::Lease::Lease(Pool* pool, std::list<std::string>&& devices):m_pool(pool), m_devices(std::move(devices)) {}
+
+Storage::Pool::Lease::Lease(Lease&& lease) noexcept:m_pool(lease.m_pool), m_devices(std::move(lease.m_devices)) {
+	lease.m_pool = nullptr;
+}
+
+Storage::Pool::Lease::~Lease() {
+	if (m_pool) m_pool->release(m_devices);
+}
+
+Storage::Pool::Pool(const std::list<root>& roots):m_roots(roots) {
+	// When a device is defined several times the most restrictive limit applies
+	for (auto it = m_roots.begin(); it != m_roots.end(); it++) {
+		auto concurrency = m_device_concurrency.find(it->m_device);
+		if (concurrency == m_device_concurrency.end())
+			m_device_concurrency[it->m_device] = it->m_concurrency;
+		else if (it->m_concurrency > 0 && (concurrency->second == 0 || it->m_concurrency < concurrency->second))
+			concurrency->second = it->m_concurrency;
+		auto bandwidth = m_device_bandwidth.find(it->m_device);
+		if (bandwidth == m_device_bandwidth.end())
+			m_device_bandwidth[it->m_device] = it->m_bandwidth;
+		else if (it->m_bandwidth > 0 && (bandwidth->second == 0 || it->m_bandwidth < bandwidth->second))
+			bandwidth->second = it->m_bandwidth;
+		m_device_users[it->m_device] = 0;
+	}
+}
+
+std::list<Storage::root> Storage::Pool::get_roots(const root::role& role) const {
+	std::list<root> result;
+	std::copy_if(m_roots.begin(), m_roots.end(), std::back_inserter(result), [&role](const root& r) { return r.m_role == role; });
+	return result;
+}
+
+std::optional<Storage::root> Storage::Pool::select(const root::role& role, const std::function<bool(const root&)>& accept) {
+	std::optional<root> result;
+	std::optional<std::pair<unsigned int, uintmax_t>> best_load; // Device users and free space
+	for (const root& candidate: get_roots(role)) {
+		if (!accept(candidate)) continue;
+
+		unsigned int users;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			users = m_device_users[candidate.m_device];
+		}
+		const uintmax_t free_space = Utils::Filesystem::get_free_space(candidate.m_path).value_or(0);
+		if (!best_load || users < best_load->first || (users == best_load->first && free_space > best_load->second)) {
+			best_load = std::make_pair(users, free_space);
+			result = candidate;
+		}
+	}
+	return result;
+}
+
+Storage::Pool::Lease Storage::Pool::acquire(const std::list<Types::path_t>& paths) {
+	std::list<std::string> devices;
+	for (auto it = paths.begin(); it != paths.end(); it++) {
+		auto r = find_root(*it);
+		if (r && std::find(devices.begin(), devices.end(), r->m_device) == devices.end())
+			devices.push_back(r->m_device);
+	}
+
+	// All slots are taken at once so two holders can never wait for each other
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condition.wait(lock, [this, &devices] {
+		return std::all_of(devices.begin(), devices.end(), [this](const std::string& device) {
+			return m_device_concurrency[device] == 0 || m_device_users[device] < m_device_concurrency[device];
+		});
+	});
+	for (auto it = devices.begin(); it != devices.end(); it++)
+		m_device_users[*it]++;
+
+	return Lease(this, std::move(devices));
+}
+
+uintmax_t Storage::Pool::get_bandwidth(const std::list<Types::path_t>& paths) const {
+	uintmax_t result = 0;
+	for (auto it = paths.begin(); it != paths.end(); it++) {
+		auto r = find_root(*it);
+		if (!r) continue;
+		const uintmax_t bandwidth = m_device_bandwidth.at(r->m_device);
+		if (bandwidth > 0 && (result == 0 || bandwidth < result))
+			result = bandwidth;
+	}
+	return result;
+}
+
+std::optional<Storage::root> Storage::Pool::find_root(const Types::path_t& path) const {
+	// Most specific root wins in case of nested roots
+	std::optional<root> result;
+	const std::string full_path = path.lexically_normal().string();
+	for (auto it = m_roots.begin(); it != m_roots.end(); it++) {
+		const std::string root_path = (it->m_path.lexically_normal() / "").string();
+		if (full_path.rfind(root_path, 0) == 0 && (!result || root_path.size() > (result->m_path.lexically_normal() / "").string().size()))
+			result = *it;
+	}
+	return result;
+}
+
+void Storage::Pool::release(const std::list<std::string>& devices) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto it = devices.begin(); it != devices.end(); it++)
+			m_device_users[*it]--;
+	}
+	m_condition.notify_all();
+}
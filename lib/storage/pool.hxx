@@ -0,0 +1,70 @@
+#pragma once
+
+#include "types.hxx"
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace StormByte::VideoConvert::Storage {
+	struct root {
+		enum role: unsigned short {
+			WORK = 0,
+			OUTPUT,
+			MIRROR // Every finished film is also written here
+		};
+
+		Types::path_t m_path;
+		role m_role;
+		std::string m_device; // Roots sharing device also share its limits
+		unsigned int m_concurrency = 0; // Maximum concurrent users of device, 0 means unlimited
+		uintmax_t m_bandwidth = 0; // Bytes per second for copies, 0 means unlimited
+	};
+
+	/* Work and output roots with per device I/O limits, shared between daemon and finalizer */
+	class Pool {
+		public:
+			/* Keeps device slots while alive */
+			class Lease {
+				public:
+					Lease(Pool* pool, std::list<std::string>&& devices);
+					Lease(const Lease&) = delete;
+					Lease(Lease&& lease) noexcept;
+					Lease& operator=(const Lease&) = delete;
+					Lease& operator=(Lease&&) = delete;
+					~Lease();
+
+				private:
+					Pool* m_pool;
+					std::list<std::string> m_devices;
+			};
+
+			Pool(const std::list<root>& roots);
+			Pool(const Pool&) = delete;
+			Pool(Pool&&) = delete;
+			Pool& operator=(const Pool&) = delete;
+			Pool& operator=(Pool&&) = delete;
+			~Pool() = default;
+
+			std::list<root> get_roots(const root::role& role) const;
+			/* Least loaded root (by device users, then by free space) of those accepted */
+			std::optional<root> select(const root::role& role, const std::function<bool(const root&)>& accept);
+			/* Blocks until all devices holding paths have a free slot */
+			Lease acquire(const std::list<Types::path_t>& paths);
+			/* Lowest bandwidth limit of devices holding paths, 0 means unlimited */
+			uintmax_t get_bandwidth(const std::list<Types::path_t>& paths) const;
+			/* Root holding path, if any */
+			std::optional<root> find_root(const Types::path_t& path) const;
+
+		private:
+			void release(const std::list<std::string>& devices);
+
+			std::list<root> m_roots;
+			std::map<std::string, unsigned int> m_device_concurrency, m_device_users;
+			std::map<std::string, uintmax_t> m_device_bandwidth;
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+	};
+}
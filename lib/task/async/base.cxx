@@ -0,0 +1,65 @@
+#include "base.hxx"
+
+#include <assert.h>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+using namespace StormByte::VideoConvert;
+
+boost::asio::awaitable<Task::STATUS> Task::Async::Base::async_run() {
+	std::optional<pid_t> useless;
+	co_return co_await async_run(useless);
+}
+
+boost::asio::awaitable<Task::STATUS> Task::Async::Base::async_run(std::optional<pid_t>& worker) {
+	STATUS status = HALT_ERROR;
+
+	m_start = std::chrono::steady_clock::now();
+	status = pre_run_actions();
+
+	if (status == RUNNING) {
+		try {
+			status = co_await async_do_work(worker);
+		}
+		catch (const std::exception&) {
+			status = HALT_ERROR;
+		}
+	}
+
+	m_end = std::chrono::steady_clock::now();
+	status = post_run_actions(status);
+
+	assert(status == HALT_OK || status == HALT_ERROR);
+	co_return status;
+}
+
+std::vector<Task::STATUS> Task::Async::Base::run_all(const std::vector<Base*>& tasks) {
+	boost::asio::io_context ios;
+	std::vector<STATUS> result(tasks.size(), HALT_ERROR);
+
+	for (size_t i = 0; i < tasks.size(); i++)
+		boost::asio::co_spawn(ios, tasks[i]->async_run(), [&result, i](std::exception_ptr error, STATUS status) {
+			if (!error) result[i] = status;
+		});
+	ios.run();
+
+	return result;
+}
+
+Task::STATUS Task::Async::Base::do_work(std::optional<pid_t>& worker) noexcept {
+	boost::asio::io_context ios;
+	STATUS status = HALT_ERROR;
+
+	try {
+		boost::asio::co_spawn(ios, async_do_work(worker), [&status](std::exception_ptr error, STATUS result) {
+			if (!error) status = result;
+		});
+		ios.run();
+	}
+	catch (const std::exception&) {
+		status = HALT_ERROR;
+	}
+
+	return status;
+}
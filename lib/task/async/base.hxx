@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../base.hxx"
+
+#include <vector>
+#include <utility> // Boost 1.74 awaitable.hpp uses std::exchange without including it
+#include <boost/asio/awaitable.hpp>
+
+namespace StormByte::VideoConvert::Task::Async {
+	/* Task whose work is a coroutine so many of them can share a single event loop */
+	class Base: public Task::Base {
+		public:
+			Base() = default;
+			Base(const Base&) = default;
+			Base(Base&&) noexcept = default;
+			Base& operator=(const Base&) = default;
+			Base& operator=(Base&&) noexcept = default;
+			virtual ~Base() noexcept = default;
+
+			/* Same steps as run() but it must be awaited from a coroutine running on an io_context */
+			boost::asio::awaitable<STATUS> async_run(std::optional<pid_t>&);
+			boost::asio::awaitable<STATUS> async_run();
+
+			/* Runs all tasks concurrently in a single thread, statuses are returned in the same order */
+			static std::vector<STATUS> run_all(const std::vector<Base*>& tasks);
+
+		protected:
+			/* Synchronous run just drives async_do_work in its own event loop */
+			virtual STATUS do_work(std::optional<pid_t>&) noexcept override;
+			virtual boost::asio::awaitable<STATUS> async_do_work(std::optional<pid_t>&) = 0;
+	};
+}
@@ -1,4 +1,5 @@
 #include "base.hxx"
+#include "utils/display.hxx"
 
 #include <assert.h>
 
@@ -39,17 +40,5 @@ Task::STATUS Task::Base::post_run_actions(const STATUS& prev_status) noexcept {
 }
 
 std::string Task::Base::elapsed_time_string() const {
-	/* NOTE: Until C++20's <format> support is complete, I just use this aproach */
-	std::string result = "";
-
-	auto elapsed = std::chrono::hh_mm_ss(m_end - m_start);
-	auto h = elapsed.hours().count(), m = elapsed.minutes().count(), s = elapsed.seconds().count();
-
-	result += std::to_string(h) + ":";
-	if (m < 10) result += "0";
-	result += std::to_string(m) + ":";
-	if (s < 10) result += "0";
-	result += std::to_string(s);
-
-	return result;;
+	return Utils::Display::duration_to_string(std::chrono::duration_cast<std::chrono::seconds>(elapsed_time()));
 }
\ No newline at end of file
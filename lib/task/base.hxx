@@ -25,6 +25,7 @@ namespace StormByte::VideoConvert::Task {
 			inline void ask_stop() { m_status = HALTED; }
 			
 			std::string elapsed_time_string() const;
+			inline std::chrono::steady_clock::duration elapsed_time() const { return m_end - m_start; }
 
 		protected:
 			/* Actions */
@@ -35,8 +36,6 @@ namespace StormByte::VideoConvert::Task {
 			virtual STATUS post_run_actions(const STATUS&) noexcept;
 
 			volatile STATUS m_status;
-
-		private:
 			std::chrono::steady_clock::time_point m_start, m_end;
 	};
 }
\ No newline at end of file
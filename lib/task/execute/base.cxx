@@ -1,106 +1,254 @@
 #include "base.hxx"
 #include "utils/logger.hxx"
+#include "utils/system.hxx"
 
 #include <unistd.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <cstring>
 #include <fcntl.h>
+#include <csignal>
 #include <vector>
 #include <boost/process.hpp>
 #include <boost/asio.hpp>
 
 using namespace StormByte::VideoConvert;
+namespace asio = boost::asio;
 
-Task::Execute::Base::Base(const Types::path_t& program, const std::string& arguments):Task::Base(), m_executables({ Executable(program, arguments) }) {}
+const std::chrono::seconds Task::Execute::Base::USAGE_SAMPLE_INTERVAL = std::chrono::seconds(5);
+const std::chrono::milliseconds Task::Execute::Base::EXIT_POLL_INTERVAL = std::chrono::milliseconds(100);
+const std::chrono::seconds Task::Execute::Base::STALL_CHECK_INTERVAL = std::chrono::seconds(10);
+const std::chrono::seconds Task::Execute::Base::STALL_KILL_GRACE = std::chrono::seconds(30);
 
-Task::Execute::Base::Base(Types::path_t&& program, std::string&& arguments):Task::Base(), m_executables({ Executable(std::move(program), std::move(arguments)) }) {}
+Task::Execute::Base::Base(const Types::path_t& program, const std::string& arguments):Task::Async::Base(), m_executables({ Executable(program, arguments) }) {}
 
-Task::Execute::Base::Base(const std::vector<Executable>& execs):Task::Base(), m_executables(execs) {}
+Task::Execute::Base::Base(Types::path_t&& program, std::string&& arguments):Task::Async::Base(), m_executables({ Executable(std::move(program), std::move(arguments)) }) {}
 
-Task::Execute::Base::Base(std::vector<Executable>&& execs):Task::Base(), m_executables(std::move(execs)) {}
+Task::Execute::Base::Base(const std::vector<Executable>& execs):Task::Async::Base(), m_executables(execs) {}
 
+Task::Execute::Base::Base(std::vector<Executable>&& execs):Task::Async::Base(), m_executables(std::move(execs)) {}
 
-Task::STATUS Task::Execute::Base::do_work(std::optional<pid_t>& worker) noexcept {
+
+boost::asio::awaitable<Task::STATUS> Task::Execute::Base::async_do_work(std::optional<pid_t>& worker) {
 	using namespace boost;
 
 	STATUS status = STOPPED;
 
 	if (!m_executables.empty()) {
-		asio::io_service ios;
-
+		auto executor = co_await asio::this_coro::executor;
+		// Process pipes need the io_context itself, not only its executor
+		auto& ios = static_cast<asio::io_context&>(asio::query(executor, asio::execution::context));
+
+		process::async_pipe pipeOut(ios), pipeErr(ios), pipeIn(ios);
+
+		if (m_logger)
+			m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Executing ", m_executables[0].m_program, " ", m_executables[0].m_arguments);
+
+		process::child c(
+			m_executables[0].m_program.string() + " " + m_executables[0].m_arguments,
+			process::std_out > pipeOut,
+			process::std_err > pipeErr,
+			process::std_in < pipeIn
+		);
+		worker = c.id();
+		if (m_worker_callback) m_worker_callback(c.id());
+
+		// Child side ends are already closed so we keep only ours
+		asio::posix::stream_descriptor out = std::move(pipeOut).source();
+		asio::posix::stream_descriptor err = std::move(pipeErr).source();
+		asio::posix::stream_descriptor in = std::move(pipeIn).sink();
+
+		// Helpers run concurrently and cancel this timer when the last one finishes
+		asio::steady_timer helpersDone(executor, asio::steady_timer::time_point::max());
+		asio::steady_timer usageTimer(executor), watchdogTimer(executor);
+		bool exited = false;
+		unsigned short pendingHelpers = 0;
+		auto spawn_helper = [&](asio::awaitable<void>&& helper) {
+			pendingHelpers++;
+			asio::co_spawn(executor, std::move(helper), [&](std::exception_ptr) {
+				if (--pendingHelpers == 0) helpersDone.cancel();
+			});
+		};
+
+		spawn_helper(read_pipe(out, m_stdout));
+		spawn_helper(read_pipe(err, m_stderr));
+		spawn_helper(write_pipe(in, m_stdin));
+		spawn_helper(sample_usage(c.id(), usageTimer));
+		if (m_stall_timeout.count() > 0)
+			spawn_helper(watch_progress(c.id(), watchdogTimer, exited));
+
+		// Nothing can leave this frame while helpers run as they reference our locals, so errors are rethrown after cleaning up
+		std::exception_ptr error;
 		try {
-			
-			std::vector<char> vOut(128 << 10);
-			std::vector<char> vErr(128 << 10);
-			auto outBuffer{ asio::buffer(vOut) };
-			auto errBuffer{ asio::buffer(vErr) };
-			auto inBuffer{ asio::buffer(m_stdin) };
-
-			// stdout setup
-			process::async_pipe pipeOut(ios);
-
-			std::function<void(const system::error_code & ec, std::size_t n)> onStdOut;
-			onStdOut = [&](const system::error_code & ec, size_t n)
-			{
-				m_stdout.reserve(m_stdout.size() + n);
-				m_stdout.insert(m_stdout.end(), vOut.begin(), vOut.begin() + n);
-				if (!ec) {
-					asio::async_read(pipeOut, outBuffer, onStdOut);
-				}
-			};
-
-			// stderr setup
-			process::async_pipe pipeErr(ios);
-
-			std::function<void(const system::error_code & ec, std::size_t n)> onStdErr;
-			onStdErr = [&](const system::error_code & ec, size_t n) {
-				m_stderr.reserve(m_stderr.size() + n);
-				m_stderr.insert(m_stderr.end(), vErr.begin(), vErr.begin() + n);
-				if (!ec)
-				{
-					asio::async_read(pipeErr, errBuffer, onStdErr);
-				}
-			};
-
-			// stdin setup
-			process::async_pipe pipeIn(ios);
-
-			if (m_logger)
-				m_logger->message_line(Utils::Logger::LEVEL_DEBUG, "Executing " + m_executables[0].m_program.string() + " " + m_executables[0].m_arguments);
-
-			process::child c(
-				m_executables[0].m_program.string() + " " + m_executables[0].m_arguments,
-				process::std_out > pipeOut, 
-				process::std_err > pipeErr, 
-				process::std_in < pipeIn
-			);
-
-			
-			asio::async_write(pipeIn, inBuffer, 
-				[&](const system::error_code&, std::size_t) {
-					pipeIn.async_close(); //  tells the child we have no more data
-				});
-
-			asio::async_read(pipeOut, outBuffer, onStdOut);
-			asio::async_read(pipeErr, errBuffer, onStdErr);
-			
-			// We update worker BEFORE this is run as this is a blocking call
-			worker = c.id();
-			ios.run();
-			c.wait();
-			if (c.exit_code() == 0) status = HALT_OK; else status = HALT_ERROR;
+			co_await wait_exit(c.id());
 		}
-		catch (const std::exception&) {
-			status = HALT_ERROR;
+		catch (...) {
+			error = std::current_exception();
+			if (m_logger)
+				m_logger->message_line(Utils::Logger::LEVEL_ERROR, "Can not wait for process ", c.id(), ", killing it");
+			kill(c.id(), SIGKILL);
 		}
+		exited = true;
+		usageTimer.cancel();
+		watchdogTimer.cancel();
+
+		// Once reaped its pid can be reused, so nobody must signal it anymore
 		worker.reset();
+		if (m_worker_callback) m_worker_callback({});
+		// Child has exited (or was just killed) so this reaps it, we do it ourselves to get its resource usage
+		c.detach();
+		status = reap(c.id()) && !m_stalled && !error ? HALT_OK : HALT_ERROR;
+
+		// Pipes may still hold unread data, unless we failed: then it is discarded so helpers end now
+		system::error_code ec;
+		if (error) {
+			out.close(ec);
+			err.close(ec);
+			in.close(ec);
+		}
+		if (pendingHelpers > 0)
+			co_await helpersDone.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	co_return status;
+}
+
+asio::awaitable<void> Task::Execute::Base::read_pipe(asio::posix::stream_descriptor& pipe, std::string& output) {
+	std::vector<char> buffer(128 << 10);
+	boost::system::error_code ec;
+	while (!ec) {
+		const size_t n = co_await pipe.async_read_some(asio::buffer(buffer), asio::redirect_error(asio::use_awaitable, ec));
+		output.append(buffer.data(), n);
 	}
+}
+
+asio::awaitable<void> Task::Execute::Base::write_pipe(asio::posix::stream_descriptor& pipe, const std::string& input) {
+	boost::system::error_code ec;
+	co_await asio::async_write(pipe, asio::buffer(input), asio::redirect_error(asio::use_awaitable, ec));
+	// Tells the child we have no more data
+	pipe.close(ec);
+}
 
-	return status;
+asio::awaitable<void> Task::Execute::Base::sample_usage(pid_t pid, asio::steady_timer& timer) {
+	// Sampled while running as they are lost when child is reaped
+	boost::system::error_code ec;
+	while (!ec) {
+		timer.expires_after(USAGE_SAMPLE_INTERVAL);
+		co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+		// VmHWM never decreases so last sample is the best we can get
+		auto peak = Utils::System::get_peak_memory(pid);
+		if (!peak) break; // Child is gone even if we missed the cancellation
+		m_peak_memory = peak;
+		sample_io(pid);
+	}
+}
+
+void Task::Execute::Base::sample_io(pid_t pid) {
+	// I/O counters only grow too
+	auto io_bytes = Utils::System::get_io_bytes(pid);
+	if (io_bytes) m_io_bytes = io_bytes;
+}
+
+bool Task::Execute::Base::reap(pid_t pid) {
+	// Zombie still has its final I/O counters until reaped
+	sample_io(pid);
+
+	int wait_status;
+	struct rusage usage;
+	if (wait4(pid, &wait_status, 0, &usage) != pid)
+		return false;
+
+	resource_usage result;
+	result.m_user_time		= usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+	result.m_system_time	= usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+	result.m_max_rss		= static_cast<uintmax_t>(usage.ru_maxrss) * 1024;
+	if (m_io_bytes) {
+		result.m_read_bytes		= m_io_bytes->first;
+		result.m_write_bytes	= m_io_bytes->second;
+	}
+	m_resource_usage = result;
+	// Exact peak, samples could have missed a short spike
+	if (!m_peak_memory || *m_peak_memory < result.m_max_rss)
+		m_peak_memory = result.m_max_rss;
+
+	return WIFEXITED(wait_status) && WEXITSTATUS(wait_status) == 0;
+}
+
+asio::awaitable<void> Task::Execute::Base::watch_progress(pid_t pid, asio::steady_timer& timer, const bool& exited) {
+	boost::system::error_code ec;
+	auto progress = get_progress(pid);
+	auto last_progress = std::chrono::steady_clock::now();
+	while (true) {
+		timer.expires_after(STALL_CHECK_INTERVAL);
+		co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+		if (ec || exited) co_return;
+
+		auto current = get_progress(pid);
+		if (current != progress) {
+			progress = current;
+			last_progress = std::chrono::steady_clock::now();
+		}
+		else if (std::chrono::steady_clock::now() - last_progress >= m_stall_timeout)
+			break;
+	}
+
+	// Interrupt first as FFmpeg then closes its output properly
+	m_stalled = true;
+	if (m_logger)
+		m_logger->message_line(Utils::Logger::LEVEL_WARNING, "Process ", pid, " made no progress in ", m_stall_timeout.count(), " seconds, interrupting it");
+	kill(pid, SIGINT);
+
+	timer.expires_after(STALL_KILL_GRACE);
+	co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+	if (ec || exited) co_return;
+	if (m_logger)
+		m_logger->message_line(Utils::Logger::LEVEL_WARNING, "Process ", pid, " did not stop after ", STALL_KILL_GRACE.count(), " seconds, killing it");
+	kill(pid, SIGKILL);
+}
+
+uintmax_t Task::Execute::Base::get_progress(pid_t pid) const {
+	// Only compared with previous value, so any of these growing means progress
+	uintmax_t result = Utils::System::get_io_activity(pid).value_or(0) + m_stdout.size() + m_stderr.size();
+	if (m_progress_file) {
+		std::error_code error;
+		const uintmax_t size = std::filesystem::file_size(*m_progress_file, error);
+		if (!error) result += size;
+	}
+	return result;
+}
+
+asio::awaitable<void> Task::Execute::Base::wait_exit(pid_t pid) {
+	auto executor = co_await asio::this_coro::executor;
+	auto pidfd = Utils::System::open_pidfd(pid);
+
+	if (pidfd) {
+		// Becomes readable once the child exits, no SIGCHLD handling nor blocking wait needed
+		asio::posix::stream_descriptor descriptor(executor, *pidfd);
+		boost::system::error_code ec;
+		co_await descriptor.async_wait(asio::posix::stream_descriptor::wait_read, asio::redirect_error(asio::use_awaitable, ec));
+	}
+	else {
+		// Older kernels: poll without reaping so exit status is still available
+		asio::steady_timer timer(executor);
+		siginfo_t info;
+		while (true) {
+			info.si_pid = 0;
+			if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0 || info.si_pid != 0)
+				break;
+			timer.expires_after(EXIT_POLL_INTERVAL);
+			co_await timer.async_wait(asio::use_awaitable);
+		}
+	}
 }
 
 Task::STATUS Task::Execute::Base::pre_run_actions() noexcept {
 	m_stdout = "";
 	m_stdin = "";
+	m_peak_memory.reset();
+	m_io_bytes.reset();
+	m_resource_usage.reset();
+	m_stalled = false;
 	return RUNNING;
 }
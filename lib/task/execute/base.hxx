@@ -1,19 +1,28 @@
 #pragma once
 
-#include "../base.hxx"
+#include "../async/base.hxx"
 #include "types.hxx"
 
+#include <functional>
 #include <vector>
 #include <boost/algorithm/string/join.hpp> // As it is common in everything that executes
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 namespace StormByte::VideoConvert::Task::Execute {
-	class Base: public Task::Base {
+	class Base: public Task::Async::Base {
 		public:
 			struct Executable {
 				Executable(const Types::path_t& program, const std::string& arguments = ""): m_program(program), m_arguments(arguments) {}
 				Types::path_t m_program;
 				std::string m_arguments;
 			};
+			/* Accounted when child is reaped */
+			struct resource_usage {
+				double m_user_time = 0, m_system_time = 0; // CPU seconds
+				uintmax_t m_max_rss = 0; // Bytes
+				std::optional<uintmax_t> m_read_bytes, m_write_bytes; // Only I/O which reached storage
+			};
 			Base() = default;
 			Base(const Types::path_t&, const std::string& args = "");
 			Base(Types::path_t&&, std::string&& args = "");
@@ -29,16 +38,46 @@ namespace StormByte::VideoConvert::Task::Execute {
 
 			inline std::string get_stdout() const { return m_stdout; }
 			inline std::string get_stderr() const { return m_stderr; }
+			inline std::optional<uintmax_t> get_peak_memory() const { return m_peak_memory; } // Peak RSS in bytes
+			inline std::optional<resource_usage> get_resource_usage() const { return m_resource_usage; }
 			inline void set_logger(Types::logger_t logger) { m_logger = logger; }
+			/* Child is interrupted (and killed if it does not stop) when it makes no progress for this long, zero disables it */
+			inline void set_stall_timeout(const std::chrono::seconds& timeout) { m_stall_timeout = timeout; }
+			inline bool is_stalled() const { return m_stalled; }
+			/* Told child pid when it starts and no value right before it is reaped, for other threads which must not read worker */
+			inline void set_worker_callback(std::function<void(const std::optional<pid_t>&)> callback) { m_worker_callback = callback; }
 
 		protected:
-			virtual STATUS do_work(std::optional<pid_t>& worker) noexcept override;
+			virtual boost::asio::awaitable<STATUS> async_do_work(std::optional<pid_t>& worker) override;
 			virtual STATUS pre_run_actions() noexcept override;
 
 			std::vector<Executable> m_executables;
 			Types::logger_t m_logger;
+			Types::optional_path_t m_progress_file; // Its growth also counts as progress
 
 		private:
 			std::string m_stdout, m_stderr, m_stdin;
+			std::optional<uintmax_t> m_peak_memory;
+			std::optional<std::pair<uintmax_t, uintmax_t>> m_io_bytes; // Last sample of read and written bytes
+			std::optional<resource_usage> m_resource_usage;
+			std::chrono::seconds m_stall_timeout = std::chrono::seconds(0);
+			bool m_stalled = false;
+			std::function<void(const std::optional<pid_t>&)> m_worker_callback;
+
+			/* Helper coroutines, all of them are awaited before the child state goes out of scope */
+			static boost::asio::awaitable<void> read_pipe(boost::asio::posix::stream_descriptor& pipe, std::string& output);
+			static boost::asio::awaitable<void> write_pipe(boost::asio::posix::stream_descriptor& pipe, const std::string& input);
+			boost::asio::awaitable<void> sample_usage(pid_t pid, boost::asio::steady_timer& timer);
+			void sample_io(pid_t pid);
+			/* Helpers can still be woken once child exited, so they check exited before touching its pid */
+			boost::asio::awaitable<void> watch_progress(pid_t pid, boost::asio::steady_timer& timer, const bool& exited);
+			uintmax_t get_progress(pid_t pid) const;
+			/* Child must have exited already */
+			bool reap(pid_t pid);
+			static boost::asio::awaitable<void> wait_exit(pid_t pid);
+
+			static const std::chrono::seconds USAGE_SAMPLE_INTERVAL;
+			static const std::chrono::milliseconds EXIT_POLL_INTERVAL;
+			static const std::chrono::seconds STALL_CHECK_INTERVAL, STALL_KILL_GRACE;
 	};
 }
@@ -5,6 +5,7 @@
 namespace StormByte::VideoConvert::Task::Execute::FFmpeg {
 	class Convert: public FFmpeg::Base {
 		public:
+			/* Both in and out are full file paths */
 			Convert(const VideoConvert::FFmpeg&, const Types::path_t& in, const Types::path_t& out);
 			Convert(VideoConvert::FFmpeg&&, Types::path_t&& in, Types::path_t&& out);
 			Convert(const Convert&) = default;
@@ -16,6 +17,6 @@ namespace StormByte::VideoConvert::Task::Execute::FFmpeg {
 		private:
 			STATUS pre_run_actions() noexcept override;
 
-			Types::path_t m_inpath, m_outpath;
+			Types::path_t m_infile, m_outfile;
 	};
 }
@@ -2,7 +2,7 @@
 
 using namespace StormByte::VideoConvert;
 
-const std::list<std::string> Task::Execute::FFprobe::VideoResolution::BASE_ARGUMENTS { "-select_streams", "v:0", "-show_entries", "stream=width,height" };
+const std::list<std::string> Task::Execute::FFprobe::VideoResolution::BASE_ARGUMENTS { "-select_streams", "v:0", "-show_entries", "stream=codec_name,width,height,r_frame_rate,color_transfer:format=duration,bit_rate" };
 
 Task::Execute::FFprobe::VideoResolution::VideoResolution(const Types::path_t& file):FFprobe::Base(file) {}
 
@@ -6,7 +6,11 @@
 /* Forward declarations */
 namespace StormByte::VideoConvert::Configuration { class Base; }
 namespace StormByte::VideoConvert::Utils { class Logger; }
-namespace StormByte::VideoConvert::Database { class SQLite3; }
+namespace StormByte::VideoConvert::Database { class SQLite3; class Profiler; }
+namespace StormByte::VideoConvert { class Finalizer; }
+namespace StormByte::VideoConvert { class Prefetcher; }
+namespace StormByte::VideoConvert::Storage { class Pool; }
+namespace StormByte::VideoConvert::Control { class Server; }
 
 namespace StormByte::VideoConvert::Types {
 	using path_t											= std::filesystem::path;
@@ -14,4 +18,9 @@ namespace StormByte::VideoConvert::Types {
 	using config_t											= std::shared_ptr<Configuration::Base>;
 	using logger_t											= std::shared_ptr<Utils::Logger>;
 	using database_t										= std::unique_ptr<Database::SQLite3>;
+	using profiler_t										= std::shared_ptr<Database::Profiler>;
+	using finalizer_t										= std::unique_ptr<Finalizer>;
+	using prefetcher_t										= std::unique_ptr<Prefetcher>;
+	using storage_pool_t									= std::shared_ptr<Storage::Pool>;
+	using control_server_t									= std::unique_ptr<Control::Server>;
 }
@@ -1,5 +1,7 @@
 #include "display.hxx"
 
+#include <cstdio>
+
 using namespace StormByte::VideoConvert;
 
 std::string Utils::Display::list_to_string(const std::list<std::string>& list_of_strings, const std::string& pre, const std::string& separator, const std::string& post) {
@@ -27,3 +29,38 @@ std::string Utils::Display::list_to_string(const std::list<int>& list_of_ints, c
 
 	return result;
 }
+
+std::string Utils::Display::duration_to_string(const std::chrono::seconds& duration) {
+	/* NOTE: Until C++20's <format> support is complete, I just use this aproach */
+	std::string result = "";
+
+	auto elapsed = std::chrono::hh_mm_ss(duration);
+	auto h = elapsed.hours().count(), m = elapsed.minutes().count(), s = elapsed.seconds().count();
+
+	result += std::to_string(h) + ":";
+	if (m < 10) result += "0";
+	result += std::to_string(m) + ":";
+	if (s < 10) result += "0";
+	result += std::to_string(s);
+
+	return result;
+}
+
+std::string Utils::Display::timings_to_string(const timings& phases) {
+	std::string result = "";
+
+	for (auto it = phases.begin(); it != phases.end(); it++) {
+		if (it != phases.begin()) result += " ";
+		char milliseconds[32];
+		std::snprintf(milliseconds, sizeof(milliseconds), "%.3f", std::chrono::duration<double, std::milli>(it->second).count());
+		result += it->first + "=" + milliseconds;
+	}
+
+	return result;
+}
+
+void Utils::Display::add_timing(timings& phases, const std::string& name, std::chrono::steady_clock::time_point& start) {
+	const auto now = std::chrono::steady_clock::now();
+	phases.push_back({ name, now - start });
+	start = now;
+}
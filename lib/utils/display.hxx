@@ -2,11 +2,21 @@
 
 #include <string>
 #include <list>
+#include <chrono>
+#include <utility>
 
 namespace StormByte::VideoConvert::Utils {
 	class Display {
 		public:
+			/* Named phases in the order they were measured */
+			using timings = std::list<std::pair<std::string, std::chrono::steady_clock::duration>>;
+
 			static std::string list_to_string(const std::list<std::string>& list_of_strings, const std::string& pre = "[ ", const std::string& separator = ",", const std::string& post = " ]");
 			static std::string list_to_string(const std::list<int>& list_of_ints, const std::string& pre = "[ ", const std::string& separator = ",", const std::string& post = " ]");
+			static std::string duration_to_string(const std::chrono::seconds& duration);
+			/* As name=milliseconds pairs so logs can be parsed by benchmark tools */
+			static std::string timings_to_string(const timings& phases);
+			/* Adds elapsed time since start as a phase and restarts start for the next one */
+			static void add_timing(timings& phases, const std::string& name, std::chrono::steady_clock::time_point& start);
 	};
 }
@@ -1,10 +1,38 @@
 #include "filesystem.hxx"
+#include "hash.hxx"
 
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/vfs.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
 
 using namespace StormByte::VideoConvert;
 
+const size_t Utils::Filesystem::COPY_BUFFER_SIZE = 8 << 20; // 8 MiB
+const size_t Utils::Filesystem::FINGERPRINT_BLOCK_SIZE = 256 << 10; // 256 KiB
+const unsigned int Utils::Filesystem::FINGERPRINT_BLOCKS = 8; // Head, tail and 6 in between
+const std::list<unsigned long> Utils::Filesystem::NETWORK_FILESYSTEMS = {
+	0x6969,		// NFS
+	0x517B,		// SMB
+	0xFF534D42,	// CIFS
+	0xFE534D42,	// SMB2
+	0x65735546,	// FUSE (sshfs, rclone...)
+	0x00C36400,	// Ceph
+	0x5346414F,	// AFS
+	0x73757245	// Coda
+};
+
 bool Utils::Filesystem::is_folder_writable(const Types::path_t& fullpath, const bool& use_cerr) {
 	if (access(fullpath.c_str(), W_OK) == 0)
 		return true;
@@ -40,3 +68,377 @@ bool Utils::Filesystem::exists_file(const Types::path_t& fullpath, const bool& u
 		return false;
 	}
 }
+
+void Utils::Filesystem::copy_file(const Types::path_t& source, const Types::path_t& destination, const uintmax_t& max_rate, const cancel_t& cancel) {
+	int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+	if (in < 0) throw_errno("Can not open " + source.string());
+
+	struct stat in_stat;
+	if (fstat(in, &in_stat) != 0) {
+		close(in);
+		throw_errno("Can not stat " + source.string());
+	}
+
+	// As std::filesystem::copy_file, we refuse to overwrite an existing file (checked again when renaming)
+	if (std::filesystem::exists(destination)) {
+		close(in);
+		throw std::runtime_error("Can not create " + destination.string() + ": File exists");
+	}
+	// Partial file left by an interrupted copy is overwritten
+	const Types::path_t partial = get_partial_path(destination);
+	int out = open(partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, in_stat.st_mode & 0777);
+	if (out < 0) {
+		close(in);
+		throw_errno("Can not create " + partial.string());
+	}
+
+	try {
+		const off_t size = in_stat.st_size;
+		off_t offset = 0;
+
+		// Each method continues where the previous one left if it turns out not to be supported
+		if (!copy_reflink(in, out) && !copy_range(in, out, offset, size, max_rate, cancel) && !copy_sendfile(in, out, offset, size, max_rate, cancel))
+			copy_buffered(in, out, offset, size, max_rate, cancel);
+
+		struct stat out_stat;
+		if (fstat(out, &out_stat) != 0)
+			throw_errno("Can not stat " + destination.string());
+		if (out_stat.st_size != size)
+			throw std::runtime_error("Copy size mismatch: " + std::to_string(out_stat.st_size) + " bytes written but " + std::to_string(size) + " were expected");
+
+		// Single sync at the end instead of flushing during the copy
+		if (fsync(out) != 0)
+			throw_errno("Can not sync " + destination.string());
+	}
+	catch (const std::exception&) {
+		close(in);
+		close(out);
+		unlink(partial.c_str());
+		throw;
+	}
+
+	close(in);
+	if (close(out) != 0) {
+		unlink(partial.c_str());
+		throw_errno("Can not close " + destination.string());
+	}
+	try {
+		publish_file(partial, destination);
+	}
+	catch (const std::exception&) {
+		unlink(partial.c_str());
+		throw;
+	}
+}
+
+std::map<Types::path_t, std::string> Utils::Filesystem::copy_file(const Types::path_t& source, const std::list<Types::path_t>& destinations, const uintmax_t& max_rate) {
+	std::map<Types::path_t, std::string> failed;
+	if (destinations.size() == 1) {
+		// Nothing to share so zero copy methods are better
+		try {
+			copy_file(source, destinations.front(), max_rate);
+		}
+		catch (const std::exception& e) {
+			failed[destinations.front()] = e.what();
+		}
+		return failed;
+	}
+
+	int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+	if (in < 0) throw_errno("Can not open " + source.string());
+	struct stat in_stat;
+	if (fstat(in, &in_stat) != 0) {
+		close(in);
+		throw_errno("Can not stat " + source.string());
+	}
+
+	std::map<Types::path_t, int> outputs;
+	for (auto it = destinations.begin(); it != destinations.end(); it++) {
+		int out = -1;
+		if (std::filesystem::exists(*it))
+			failed[*it] = "Can not create " + it->string() + ": File exists";
+		else if ((out = open(get_partial_path(*it).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, in_stat.st_mode & 0777)) < 0)
+			failed[*it] = "Can not create " + get_partial_path(*it).string() + ": " + std::strerror(errno);
+		else
+			outputs[*it] = out;
+	}
+
+	// Drops a destination keeping the others going
+	auto fail_output = [&failed, &outputs](std::map<Types::path_t, int>::iterator output, const std::string& error) {
+		close(output->second);
+		unlink(get_partial_path(output->first).c_str());
+		failed[output->first] = error;
+		return outputs.erase(output);
+	};
+
+	std::vector<char> buffer(COPY_BUFFER_SIZE);
+	const auto start = std::chrono::steady_clock::now();
+	const off_t size = in_stat.st_size;
+	off_t offset = 0;
+	std::optional<off_t> previous_chunk;
+	try {
+		posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+		while (offset < size && !outputs.empty()) {
+			ssize_t read_bytes = pread(in, buffer.data(), buffer.size(), offset);
+			if (read_bytes < 0) {
+				if (errno == EINTR) continue;
+				throw_errno("read failed");
+			}
+			else if (read_bytes == 0)
+				break;
+
+			// Writes land in page cache so destinations are written in turn while their devices write back in parallel
+			for (auto it = outputs.begin(); it != outputs.end();) {
+				try {
+					write_all(it->second, buffer.data(), read_bytes, offset);
+					writeback(it->second, offset, read_bytes, previous_chunk);
+					it++;
+				}
+				catch (const std::exception& e) {
+					it = fail_output(it, e.what());
+				}
+			}
+			posix_fadvise(in, offset, read_bytes, POSIX_FADV_DONTNEED);
+			previous_chunk = offset;
+			offset += read_bytes;
+			throttle(start, offset, max_rate);
+		}
+	}
+	catch (const std::exception&) {
+		close(in);
+		for (auto it = outputs.begin(); it != outputs.end();)
+			it = fail_output(it, "Source read failed");
+		throw;
+	}
+	close(in);
+
+	// Every destination is verified independently
+	for (auto it = outputs.begin(); it != outputs.end();) {
+		struct stat out_stat;
+		if (fstat(it->second, &out_stat) != 0 || out_stat.st_size != size)
+			it = fail_output(it, "Copy size mismatch for " + it->first.string());
+		else if (fsync(it->second) != 0)
+			it = fail_output(it, "Can not sync " + it->first.string() + ": " + std::strerror(errno));
+		else if (close(it->second) != 0) {
+			unlink(get_partial_path(it->first).c_str());
+			failed[it->first] = "Can not close " + it->first.string() + ": " + std::strerror(errno);
+			it = outputs.erase(it);
+		}
+		else {
+			try {
+				publish_file(get_partial_path(it->first), it->first);
+			}
+			catch (const std::exception& e) {
+				unlink(get_partial_path(it->first).c_str());
+				failed[it->first] = e.what();
+			}
+			it = outputs.erase(it);
+		}
+	}
+	return failed;
+}
+
+Types::path_t Utils::Filesystem::get_partial_path(const Types::path_t& destination) {
+	// Same folder so it is renamed atomically, hidden as prefetcher staged files
+	return destination.parent_path() / ("." + destination.filename().string() + ".part");
+}
+
+void Utils::Filesystem::publish_file(const Types::path_t& source, const Types::path_t& destination) {
+	if (renameat2(AT_FDCWD, source.c_str(), AT_FDCWD, destination.c_str(), RENAME_NOREPLACE) != 0) {
+		if (errno != EINVAL && errno != ENOSYS)
+			throw_errno("Can not publish " + source.string() + " as " + destination.string());
+
+		// Filesystem does not support renameat2 flags: link fails as well if destination exists
+		if (link(source.c_str(), destination.c_str()) == 0)
+			unlink(source.c_str());
+		else if ((errno == EPERM || errno == EOPNOTSUPP) && !std::filesystem::exists(destination)) {
+			// Nor hard links (some network filesystems), so destination can only be checked right before
+			if (rename(source.c_str(), destination.c_str()) != 0)
+				throw_errno("Can not publish " + source.string() + " as " + destination.string());
+		}
+		else
+			throw_errno("Can not publish " + source.string() + " as " + destination.string());
+	}
+}
+
+bool Utils::Filesystem::is_same_filesystem(const Types::path_t& path1, const Types::path_t& path2) {
+	struct stat stat1, stat2;
+	return stat(path1.c_str(), &stat1) == 0 && stat(path2.c_str(), &stat2) == 0 && stat1.st_dev == stat2.st_dev;
+}
+
+std::optional<uintmax_t> Utils::Filesystem::get_free_space(const Types::path_t& path) {
+	std::optional<uintmax_t> result;
+	struct statvfs fs_stat;
+	if (statvfs(path.c_str(), &fs_stat) == 0)
+		result = static_cast<uintmax_t>(fs_stat.f_bavail) * fs_stat.f_frsize;
+	return result;
+}
+
+bool Utils::Filesystem::is_network_filesystem(const Types::path_t& path) {
+	struct statfs fs_stat;
+	if (statfs(path.c_str(), &fs_stat) != 0)
+		return false;
+	return std::find(NETWORK_FILESYSTEMS.begin(), NETWORK_FILESYSTEMS.end(), static_cast<unsigned long>(fs_stat.f_type)) != NETWORK_FILESYSTEMS.end();
+}
+
+std::pair<uintmax_t, uint64_t> Utils::Filesystem::fingerprint(const Types::path_t& file) {
+	const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) throw_errno("Can not open " + file.string());
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw_errno("Can not stat " + file.string());
+	}
+	const uintmax_t size = info.st_size;
+
+	// Small files are read whole, otherwise blocks are spread evenly from head to tail
+	std::vector<char> buffer(std::min<uintmax_t>(size, FINGERPRINT_BLOCK_SIZE * FINGERPRINT_BLOCKS));
+	std::vector<std::pair<off_t, size_t>> blocks;
+	if (buffer.size() == size)
+		blocks.push_back({ 0, size });
+	else {
+		const uintmax_t step = (size - FINGERPRINT_BLOCK_SIZE) / (FINGERPRINT_BLOCKS - 1);
+		for (unsigned int i = 0; i < FINGERPRINT_BLOCKS; i++)
+			blocks.push_back({ static_cast<off_t>(i * step), FINGERPRINT_BLOCK_SIZE });
+		blocks.back().first = size - FINGERPRINT_BLOCK_SIZE;
+	}
+
+	// Each block is read with as few preads as possible and without polluting page cache
+	posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+	size_t filled = 0;
+	for (auto it = blocks.begin(); it != blocks.end(); it++) {
+		size_t done = 0;
+		while (done < it->second) {
+			const ssize_t read_bytes = pread(fd, buffer.data() + filled + done, it->second - done, it->first + done);
+			if (read_bytes < 0 && errno == EINTR) continue;
+			if (read_bytes <= 0) {
+				close(fd);
+				if (read_bytes == 0) throw std::runtime_error("File " + file.string() + " was truncated while being read");
+				throw_errno("Can not read " + file.string());
+			}
+			done += read_bytes;
+		}
+		posix_fadvise(fd, it->first, it->second, POSIX_FADV_DONTNEED);
+		filled += done;
+	}
+	close(fd);
+
+	return { size, Hash::xxh64(buffer.data(), filled, size) };
+}
+
+bool Utils::Filesystem::copy_reflink(const int& in, const int& out) {
+	// Only works on CoW filesystems like btrfs or xfs and when both files are in the same filesystem
+	return ioctl(out, FICLONE, in) == 0;
+}
+
+bool Utils::Filesystem::copy_range(const int& in, const int& out, off_t& offset, const off_t& size, const uintmax_t& max_rate, const cancel_t& cancel) {
+	const auto start = std::chrono::steady_clock::now();
+	const off_t start_offset = offset;
+	while (offset < size) {
+		check_cancel(cancel);
+		loff_t in_offset = offset, out_offset = offset;
+		const size_t chunk = get_chunk_size(size - offset, max_rate, cancel);
+		ssize_t copied = copy_file_range(in, &in_offset, out, &out_offset, chunk, 0);
+		if (copied < 0) {
+			if (errno == EINTR) continue;
+			if (is_copy_unsupported_error(errno)) return false;
+			throw_errno("copy_file_range failed");
+		}
+		else if (copied == 0) // Source was truncated while copying
+			break;
+		offset += copied;
+		throttle(start, offset - start_offset, max_rate);
+	}
+	return true;
+}
+
+bool Utils::Filesystem::copy_sendfile(const int& in, const int& out, off_t& offset, const off_t& size, const uintmax_t& max_rate, const cancel_t& cancel) {
+	const auto start = std::chrono::steady_clock::now();
+	const off_t start_offset = offset;
+	// sendfile writes at the current out position
+	if (lseek(out, offset, SEEK_SET) < 0) throw_errno("lseek failed");
+	while (offset < size) {
+		check_cancel(cancel);
+		const size_t chunk = get_chunk_size(size - offset, max_rate, cancel);
+		ssize_t copied = sendfile(out, in, &offset, chunk);
+		if (copied < 0) {
+			if (errno == EINTR) continue;
+			if (is_copy_unsupported_error(errno)) return false;
+			throw_errno("sendfile failed");
+		}
+		else if (copied == 0)
+			break;
+		throttle(start, offset - start_offset, max_rate);
+	}
+	return true;
+}
+
+void Utils::Filesystem::copy_buffered(const int& in, const int& out, off_t& offset, const off_t& size, const uintmax_t& max_rate, const cancel_t& cancel) {
+	const auto start = std::chrono::steady_clock::now();
+	const off_t start_offset = offset;
+	std::vector<char> buffer(COPY_BUFFER_SIZE);
+	std::optional<off_t> previous_chunk;
+
+	posix_fadvise(in, offset, 0, POSIX_FADV_SEQUENTIAL);
+	while (offset < size) {
+		check_cancel(cancel);
+		ssize_t read_bytes = pread(in, buffer.data(), buffer.size(), offset);
+		if (read_bytes < 0) {
+			if (errno == EINTR) continue;
+			throw_errno("read failed");
+		}
+		else if (read_bytes == 0)
+			break;
+
+		write_all(out, buffer.data(), read_bytes, offset);
+		writeback(out, offset, read_bytes, previous_chunk);
+		posix_fadvise(in, offset, read_bytes, POSIX_FADV_DONTNEED);
+		previous_chunk = offset;
+		offset += read_bytes;
+		throttle(start, offset - start_offset, max_rate);
+	}
+}
+
+void Utils::Filesystem::write_all(const int& fd, const char* data, const size_t& size, const off_t& offset) {
+	for (size_t written = 0; written < size;) {
+		ssize_t result = pwrite(fd, data + written, size - written, offset + written);
+		if (result < 0) {
+			if (errno == EINTR) continue;
+			throw_errno("write failed");
+		}
+		written += result;
+	}
+}
+
+size_t Utils::Filesystem::get_chunk_size(const off_t& remaining, const uintmax_t& max_rate, const cancel_t& cancel) {
+	// Chunks let us wait or stop between them
+	return max_rate > 0 || cancel ? std::min<off_t>(COPY_BUFFER_SIZE, remaining) : remaining;
+}
+
+void Utils::Filesystem::check_cancel(const cancel_t& cancel) {
+	if (cancel && cancel())
+		throw std::runtime_error("Copy was cancelled");
+}
+
+void Utils::Filesystem::writeback(const int& fd, const off_t& offset, const size_t& size, const std::optional<off_t>& previous_chunk) {
+	// Start writeback for this chunk and drop the previous one from page cache once it is on disk
+	sync_file_range(fd, offset, size, SYNC_FILE_RANGE_WRITE);
+	if (previous_chunk) {
+		sync_file_range(fd, *previous_chunk, COPY_BUFFER_SIZE, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+		posix_fadvise(fd, *previous_chunk, COPY_BUFFER_SIZE, POSIX_FADV_DONTNEED);
+	}
+}
+
+void Utils::Filesystem::throttle(const std::chrono::steady_clock::time_point& start, const off_t& copied, const uintmax_t& max_rate) {
+	// Sleeps until the time copied data should have taken at max rate
+	if (max_rate > 0)
+		std::this_thread::sleep_until(start + std::chrono::microseconds(static_cast<uintmax_t>(copied) * 1000000 / max_rate));
+}
+
+bool Utils::Filesystem::is_copy_unsupported_error(const int& error) {
+	return error == EXDEV || error == ENOSYS || error == EOPNOTSUPP || error == EINVAL || error == EBADF;
+}
+
+void Utils::Filesystem::throw_errno(const std::string& message) {
+	throw std::runtime_error(message + ": " + std::strerror(errno));
+}
@@ -2,12 +2,55 @@
 
 #include "types.hxx"
 
+#include <list>
+#include <map>
+#include <chrono>
+#include <functional>
+#include <sys/types.h>
+
 namespace StormByte::VideoConvert::Utils {
 	class Filesystem {
 		public:
+			/* Polled between copied chunks, copy is abandoned when it returns true */
+			using cancel_t = std::function<bool()>;
+
 			static bool is_folder_writable(const Types::path_t& fullpath, const bool& use_cerr = false);
 			static bool is_folder_readable(const Types::path_t& fullpath, const bool& use_cerr = false);
 			static bool is_folder_readable_and_writable(const Types::path_t& fullpath, const bool& use_cerr = false);
 			static bool exists_file(const Types::path_t& fullpath, const bool& use_cerr = false);
+			/* Copies trying reflink, then in kernel copy and finally a buffered copy which does not pollute page cache, throws on error */
+			/* Both copy_file write a hidden partial file renamed into place once complete, so an interrupted copy never looks finished */
+			static void copy_file(const Types::path_t& source, const Types::path_t& destination, const uintmax_t& max_rate = 0, const cancel_t& cancel = nullptr); // In bytes per second, 0 means unlimited
+			/* Reads source once writing it to all destinations, returns failed destinations with their error (throws if source fails) */
+			static std::map<Types::path_t, std::string> copy_file(const Types::path_t& source, const std::list<Types::path_t>& destinations, const uintmax_t& max_rate = 0);
+			/* Atomically renames without replacing destination (both need to be in the same filesystem), throws on error */
+			static void publish_file(const Types::path_t& source, const Types::path_t& destination);
+			static bool is_same_filesystem(const Types::path_t& path1, const Types::path_t& path2);
+			/* Bytes available for unprivileged users, no value if it can not be queried */
+			static std::optional<uintmax_t> get_free_space(const Types::path_t& path);
+			/* NFS, SMB/CIFS, FUSE and similar remote filesystems */
+			static bool is_network_filesystem(const Types::path_t& path);
+			/* Size and hash of head, tail and evenly spaced blocks so equal content is recognized without reading whole file, throws on error */
+			static std::pair<uintmax_t, uint64_t> fingerprint(const Types::path_t& file);
+
+		private:
+			static const size_t COPY_BUFFER_SIZE;
+			static const std::list<unsigned long> NETWORK_FILESYSTEMS;
+			static const size_t FINGERPRINT_BLOCK_SIZE;
+			static const unsigned int FINGERPRINT_BLOCKS;
+
+			static Types::path_t get_partial_path(const Types::path_t& destination);
+			static bool copy_reflink(const int& in, const int& out);
+			static bool copy_range(const int& in, const int& out, off_t& offset, const off_t& size, const uintmax_t& max_rate, const cancel_t& cancel);
+			static bool copy_sendfile(const int& in, const int& out, off_t& offset, const off_t& size, const uintmax_t& max_rate, const cancel_t& cancel);
+			static void copy_buffered(const int& in, const int& out, off_t& offset, const off_t& size, const uintmax_t& max_rate, const cancel_t& cancel);
+			/* Whole file in a single call unless it has to be throttled or cancelled */
+			static size_t get_chunk_size(const off_t& remaining, const uintmax_t& max_rate, const cancel_t& cancel);
+			static void check_cancel(const cancel_t& cancel);
+			static void write_all(const int& fd, const char* data, const size_t& size, const off_t& offset);
+			static void writeback(const int& fd, const off_t& offset, const size_t& size, const std::optional<off_t>& previous_chunk);
+			static void throttle(const std::chrono::steady_clock::time_point& start, const off_t& copied, const uintmax_t& max_rate);
+			static bool is_copy_unsupported_error(const int& error);
+			[[noreturn]] static void throw_errno(const std::string& message);
 	};
 }
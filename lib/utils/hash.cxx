@@ -0,0 +1,95 @@
+#include "hash.hxx"
+
+#include <cstring>
+
+using namespace StormByte::VideoConvert;
+
+const uint64_t Utils::Hash::PRIME64_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t Utils::Hash::PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t Utils::Hash::PRIME64_3 = 0x165667B19E3779F9ULL;
+const uint64_t Utils::Hash::PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t Utils::Hash::PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+uint64_t Utils::Hash::xxh64(const void* data, const size_t& size, const uint64_t& seed) {
+	const unsigned char* input = static_cast<const unsigned char*>(data);
+	const unsigned char* const end = input + size;
+	uint64_t result;
+
+	if (size >= 32) {
+		const unsigned char* const limit = end - 32;
+		uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+		uint64_t v2 = seed + PRIME64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - PRIME64_1;
+		do {
+			v1 = round(v1, read64(input));		input += 8;
+			v2 = round(v2, read64(input));		input += 8;
+			v3 = round(v3, read64(input));		input += 8;
+			v4 = round(v4, read64(input));		input += 8;
+		} while (input <= limit);
+
+		result = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		result = merge_round(result, v1);
+		result = merge_round(result, v2);
+		result = merge_round(result, v3);
+		result = merge_round(result, v4);
+	}
+	else
+		result = seed + PRIME64_5;
+
+	result += static_cast<uint64_t>(size);
+
+	while (input + 8 <= end) {
+		result ^= round(0, read64(input));
+		result = rotl(result, 27) * PRIME64_1 + PRIME64_4;
+		input += 8;
+	}
+	if (input + 4 <= end) {
+		result ^= static_cast<uint64_t>(read32(input)) * PRIME64_1;
+		result = rotl(result, 23) * PRIME64_2 + PRIME64_3;
+		input += 4;
+	}
+	while (input < end) {
+		result ^= (*input) * PRIME64_5;
+		result = rotl(result, 11) * PRIME64_1;
+		input++;
+	}
+
+	// Avalanche
+	result ^= result >> 33;
+	result *= PRIME64_2;
+	result ^= result >> 29;
+	result *= PRIME64_3;
+	result ^= result >> 32;
+	return result;
+}
+
+uint64_t Utils::Hash::round(uint64_t accumulator, const uint64_t& input) {
+	accumulator += input * PRIME64_2;
+	accumulator = rotl(accumulator, 31);
+	return accumulator * PRIME64_1;
+}
+
+uint64_t Utils::Hash::merge_round(uint64_t accumulator, const uint64_t& value) {
+	accumulator ^= round(0, value);
+	return accumulator * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t Utils::Hash::rotl(const uint64_t& value, const int& bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t Utils::Hash::read64(const unsigned char* data) {
+	// Specification is little endian
+	uint64_t result = 0;
+	for (int i = 7; i >= 0; i--)
+		result = (result << 8) | data[i];
+	return result;
+}
+
+uint32_t Utils::Hash::read32(const unsigned char* data) {
+	uint32_t result = 0;
+	for (int i = 3; i >= 0; i--)
+		result = (result << 8) | data[i];
+	return result;
+}
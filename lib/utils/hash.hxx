@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace StormByte::VideoConvert::Utils {
+	/* Non cryptographic hashing, values are stored in database so the algorithm must never change */
+	class Hash {
+		public:
+			/* XXH64 as specified by xxHash, so values match the reference implementation */
+			static uint64_t xxh64(const void* data, const size_t& size, const uint64_t& seed = 0);
+
+		private:
+			static const uint64_t PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME64_5;
+
+			static uint64_t round(uint64_t accumulator, const uint64_t& input);
+			static uint64_t merge_round(uint64_t accumulator, const uint64_t& value);
+			static uint64_t rotl(const uint64_t& value, const int& bits);
+			static uint64_t read64(const unsigned char* data);
+			static uint32_t read32(const unsigned char* data);
+	};
+}
@@ -1,83 +1,185 @@
 #include "logger.hxx"
 
 #include <exception>
+#include <stdexcept>
+#include <ctime>
+#include <cstdio>
+#include <csignal>
+#include <pthread.h>
 
 using namespace StormByte::VideoConvert;
 
-Utils::Logger::Logger(const Types::path_t& logfile, LEVEL display_level):m_display_level(display_level) {
+const size_t Utils::Logger::RING_SIZE = 4096; // Needs to be a power of 2
+const std::string Utils::Logger::LEVEL_NAMES[] = { "DEBUG", "WARNING", "NOTICE", "INFO", "ERROR", "FATAL" };
+
+Utils::Logger::Logger(const Types::path_t& logfile, LEVEL display_level, FORMAT format):m_display_level(display_level), m_format(format), m_ring(new slot[RING_SIZE]), m_enqueue_position(0), m_dequeue_position(0), m_pushed(0), m_dropped(0), m_stop(false), m_partial_level(LEVEL_DEBUG) {
 	m_logfile.open(logfile, std::fstream::out | std::fstream::app);
 	if (!m_logfile) throw std::runtime_error("Log file could not be opened for write");
+	for (size_t i = 0; i < RING_SIZE; i++)
+		m_ring[i].m_sequence.store(i, std::memory_order_relaxed);
+
+	// Signals have to be delivered to main thread so they can interrupt its sleep
+	sigset_t all_signals, previous_signals;
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_BLOCK, &all_signals, &previous_signals);
+	m_writer = std::thread(&Logger::writer, this);
+	pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
 }
 
 Utils::Logger::~Logger() {
+	// Writer drains everything pushed before stopping
+	m_stop.store(true, std::memory_order_release);
+	m_pushed.fetch_add(1, std::memory_order_release);
+	m_pushed.notify_one();
+	if (m_writer.joinable()) m_writer.join();
 	m_logfile.close();
 }
 
 void Utils::Logger::message_part_begin(const LEVEL& log_level, const std::string& msg) {
 	if (m_display_level <= log_level) {
-		header(log_level);
-		m_logfile << msg;
+		std::lock_guard<std::mutex> lock(m_partial_mutex);
+		m_partial = msg;
+		m_partial_level = log_level;
 	}
 }
 
 void Utils::Logger::message_part_continue(const LEVEL& log_level, const std::string& msg) {
-	if (m_display_level <= log_level)
-		m_logfile << msg;
+	if (m_display_level <= log_level) {
+		std::lock_guard<std::mutex> lock(m_partial_mutex);
+		m_partial += msg;
+	}
 }
 
 void Utils::Logger::message_part_end(const LEVEL& log_level, const std::string& msg) {
 	if (m_display_level <= log_level) {
-		m_logfile << msg;
-		end_line(log_level);
+		std::lock_guard<std::mutex> lock(m_partial_mutex);
+		push(m_partial_level, m_partial + msg);
+		m_partial.clear();
 	}
 }
 
-void Utils::Logger::message_line(const LEVEL& log_level, const std::string& msg) {
-	header(log_level);
-	message_part_end(log_level, msg);
+void Utils::Logger::end_line(const LEVEL& log_level) {
+	if (m_display_level <= log_level) {
+		std::lock_guard<std::mutex> lock(m_partial_mutex);
+		push(m_partial_level, m_partial);
+		m_partial.clear();
+	}
 }
 
-void Utils::Logger::end_line(const LEVEL& log_level) {
-	if (m_display_level <= log_level)
-		m_logfile << std::endl;
+void Utils::Logger::push(const LEVEL& level, const std::string& msg) {
+	std::string record = format_record(level, msg);
+	size_t position = m_enqueue_position.load(std::memory_order_relaxed);
+	slot* target;
+	while (true) {
+		target = &m_ring[position & (RING_SIZE - 1)];
+		const size_t sequence = target->m_sequence.load(std::memory_order_acquire);
+		const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+		if (difference == 0) {
+			if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0) {
+			// Ring is full: record is dropped instead of blocking the caller unless it is an error
+			if (level < LEVEL_ERROR) {
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			std::this_thread::yield();
+			position = m_enqueue_position.load(std::memory_order_relaxed);
+		}
+		else
+			position = m_enqueue_position.load(std::memory_order_relaxed);
+	}
+	target->m_record = std::move(record);
+	target->m_sequence.store(position + 1, std::memory_order_release);
+
+	m_pushed.fetch_add(1, std::memory_order_release);
+	m_pushed.notify_one();
 }
 
-void Utils::Logger::header(const LEVEL& loglevel) {
-	if (m_display_level <= loglevel) {
-		timestamp();
-		loglevel_display(loglevel);
+bool Utils::Logger::pop(std::string& record) {
+	slot& source = m_ring[m_dequeue_position & (RING_SIZE - 1)];
+	if (source.m_sequence.load(std::memory_order_acquire) != m_dequeue_position + 1)
+		return false;
+	record = std::move(source.m_record);
+	source.m_record.clear();
+	source.m_sequence.store(m_dequeue_position + RING_SIZE, std::memory_order_release);
+	m_dequeue_position++;
+	return true;
+}
+
+void Utils::Logger::writer() {
+	std::string batch, record;
+	while (true) {
+		const unsigned int seen = m_pushed.load(std::memory_order_acquire);
+		while (pop(record))
+			batch += record;
+		const size_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped > 0)
+			batch += format_record(LEVEL_WARNING, std::to_string(dropped) + " log record(s) dropped because logger could not keep up");
+
+		// One write and flush for everything queued since last time
+		if (!batch.empty()) {
+			m_logfile << batch;
+			m_logfile.flush();
+			batch.clear();
+		}
+
+		if (m_stop.load(std::memory_order_acquire)) {
+			// Last drain for records pushed while writing
+			while (pop(record))
+				m_logfile << record;
+			m_logfile.flush();
+			break;
+		}
+		m_pushed.wait(seen, std::memory_order_acquire);
 	}
 }
 
-void Utils::Logger::timestamp() {
-	auto t = std::time(nullptr);
-	auto tm = *std::localtime(&t);
+std::string Utils::Logger::format_record(const LEVEL& level, const std::string& msg) const {
+	const std::string& level_name = level < LEVEL_MAX ? LEVEL_NAMES[level] : LEVEL_NAMES[LEVEL_FATAL];
+	if (m_format == FORMAT_JSON)
+		return "{\"time\":\"" + timestamp() + "\",\"level\":\"" + level_name + "\",\"message\":\"" + json_escape(msg) + "\"}\n";
+	else
+		return timestamp() + ": [" + level_name + "] " + msg + "\n";
+}
+
+const std::string& Utils::Logger::timestamp() const {
+	// localtime is only called once per second and thread
+	thread_local std::time_t cached_second[2] = { -1, -1 };
+	thread_local std::string cached_text[2];
 
-	m_logfile << std::put_time(&tm, "%d-%m-%Y %H:%M:%S") << ": ";
+	const std::time_t now = std::time(nullptr);
+	if (cached_second[m_format] != now) {
+		std::tm tm;
+		localtime_r(&now, &tm);
+		char buffer[32];
+		const size_t size = std::strftime(buffer, sizeof(buffer), m_format == FORMAT_JSON ? "%Y-%m-%dT%H:%M:%S%z" : "%d-%m-%Y %H:%M:%S", &tm);
+		cached_text[m_format].assign(buffer, size);
+		cached_second[m_format] = now;
+	}
+	return cached_text[m_format];
 }
 
-void Utils::Logger::loglevel_display(const LEVEL& level) {
-	switch(level) {
-		case LEVEL_DEBUG:
-			m_logfile << "[DEBUG]";
-			break;
-		case LEVEL_WARNING:
-			m_logfile << "[WARNING]";
-			break;
-		case LEVEL_NOTICE:
-			m_logfile << "[NOTICE]";
-			break;
-		case LEVEL_INFO:
-			m_logfile << "[INFO]";
-			break;
-		case LEVEL_ERROR:
-			m_logfile << "[ERROR]";
-			break;
-		case LEVEL_FATAL:
-			m_logfile << "[FATAL]";
-			break;
-		case LEVEL_MAX:
-			break;
+std::string Utils::Logger::json_escape(const std::string& text) {
+	std::string result;
+	result.reserve(text.size());
+	for (const char& c: text) {
+		switch (c) {
+			case '"':	result += "\\\""; break;
+			case '\\':	result += "\\\\"; break;
+			case '\n':	result += "\\n"; break;
+			case '\r':	result += "\\r"; break;
+			case '\t':	result += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char buffer[8];
+					std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+					result += buffer;
+				}
+				else
+					result += c;
+		}
 	}
-	m_logfile << " ";
+	return result;
 }
@@ -3,8 +3,14 @@
 #include "types.hxx"
 
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <type_traits>
 
 namespace StormByte::VideoConvert::Utils {
+	/* Records are formatted by callers and written by a background thread so logging never blocks on disk */
 	class Logger {
 		public:
 			enum LEVEL:unsigned short {
@@ -16,7 +22,11 @@ namespace StormByte::VideoConvert::Utils {
 				LEVEL_FATAL,
 				LEVEL_MAX
 			};
-			Logger(const Types::path_t& logfile, LEVEL display_level);
+			enum FORMAT:unsigned short {
+				FORMAT_TEXT = 0,
+				FORMAT_JSON // One JSON object per line
+			};
+			Logger(const Types::path_t& logfile, LEVEL display_level, FORMAT format = FORMAT_TEXT);
 			Logger(const Logger&) = delete;
 			Logger(Logger&&) = delete;
 			Logger& operator=(const Logger&) = delete;
@@ -26,16 +36,54 @@ namespace StormByte::VideoConvert::Utils {
 			void message_part_begin(const LEVEL& level, const std::string& msg);
 			void message_part_continue(const LEVEL& level, const std::string& msg);
 			void message_part_end(const LEVEL& level, const std::string& msg);
-			void message_line(const LEVEL& level, const std::string& msg);
+			/* Arguments (strings, paths or numbers) are only converted and joined if level is going to be logged */
+			template<typename... Args>
+			inline void message_line(const LEVEL& level, const Args&... args) {
+				if (m_display_level <= level) {
+					std::string msg;
+					(append(msg, args), ...);
+					push(level, msg);
+				}
+			}
 			void end_line(const LEVEL& level);
 			
 
 		private:
+			struct slot {
+				std::atomic<size_t> m_sequence;
+				std::string m_record;
+			};
+
 			std::ofstream m_logfile;
 			LEVEL m_display_level;
+			FORMAT m_format;
+			/* Bounded multi producer ring buffer, only the writer thread consumes */
+			std::unique_ptr<slot[]> m_ring;
+			std::atomic<size_t> m_enqueue_position;
+			size_t m_dequeue_position;
+			std::atomic<unsigned int> m_pushed; // Writer waits on it
+			std::atomic<size_t> m_dropped;
+			std::atomic<bool> m_stop;
+			std::thread m_writer;
+			std::mutex m_partial_mutex; // Only for messages built in parts
+			std::string m_partial;
+			LEVEL m_partial_level;
+
+			void push(const LEVEL& level, const std::string& msg);
+			bool pop(std::string& record);
+			void writer();
+			std::string format_record(const LEVEL& level, const std::string& msg) const;
+			const std::string& timestamp() const;
+			static std::string json_escape(const std::string& text);
+
+			inline static void append(std::string& msg, const std::string& value)			{ msg += value; }
+			inline static void append(std::string& msg, const char* value)					{ msg += value; }
+			inline static void append(std::string& msg, const char& value)					{ msg += value; }
+			inline static void append(std::string& msg, const Types::path_t& value)		{ msg += value.string(); }
+			template<typename T> requires std::is_arithmetic_v<T>
+			inline static void append(std::string& msg, const T& value)						{ msg += std::to_string(value); }
 
-			void header(const LEVEL& log_level);
-			void timestamp();
-			void loglevel_display(const LEVEL& level);
+			static const size_t RING_SIZE;
+			static const std::string LEVEL_NAMES[];
 	};
 }
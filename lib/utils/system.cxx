@@ -0,0 +1,136 @@
+#include "system.hxx"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <climits>
+#include <fstream>
+#include <algorithm>
+
+using namespace StormByte::VideoConvert;
+
+std::string Utils::System::get_hostname() {
+	char hostname[HOST_NAME_MAX + 1] = { 0 };
+	if (gethostname(hostname, sizeof(hostname)) != 0)
+		return "localhost";
+	return hostname;
+}
+
+std::optional<uintmax_t> Utils::System::get_available_memory() {
+	std::optional<uintmax_t> result = read_kb_value("/proc/meminfo", "MemAvailable:");
+	auto cgroup = get_cgroup_available_memory();
+	if (cgroup)
+		result = result ? std::min(*result, *cgroup) : *cgroup;
+	return result;
+}
+
+std::optional<uintmax_t> Utils::System::get_total_memory() {
+	std::optional<uintmax_t> result = read_kb_value("/proc/meminfo", "MemTotal:");
+	auto cgroup = get_cgroup_memory_limit();
+	if (cgroup)
+		result = result ? std::min(*result, *cgroup) : *cgroup;
+	return result;
+}
+
+std::optional<uintmax_t> Utils::System::get_peak_memory(const pid_t& pid) {
+	return read_kb_value("/proc/" + std::to_string(pid) + "/status", "VmHWM:");
+}
+
+std::optional<std::pair<uintmax_t, uintmax_t>> Utils::System::get_io_bytes(const pid_t& pid) {
+	// Unlike rchar/wchar these do not count page cache hits, so they tell how much the disks were used
+	std::ifstream input("/proc/" + std::to_string(pid) + "/io");
+	std::string key;
+	uintmax_t value;
+	std::optional<uintmax_t> read, written;
+	while (input >> key >> value) {
+		if (key == "read_bytes:") read = value;
+		else if (key == "write_bytes:") written = value;
+	}
+	if (!read || !written) return {};
+	return std::make_pair(*read, *written);
+}
+
+std::optional<uintmax_t> Utils::System::get_io_activity(const pid_t& pid) {
+	std::ifstream input("/proc/" + std::to_string(pid) + "/io");
+	std::string key;
+	uintmax_t value;
+	std::optional<uintmax_t> result;
+	while (input >> key >> value) {
+		if (key == "rchar:" || key == "wchar:")
+			result = result.value_or(0) + value;
+	}
+	return result;
+}
+
+std::optional<int> Utils::System::open_pidfd(const pid_t& pid) {
+	#ifdef SYS_pidfd_open
+	const int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+	if (fd >= 0) return fd;
+	#endif
+	return {};
+}
+
+std::optional<std::string> Utils::System::get_cgroup_folder() {
+	// Only cgroup v2 (unified hierarchy) is supported, its entry is "0::/path"
+	std::ifstream cgroup_file("/proc/self/cgroup");
+	std::string line;
+	while (std::getline(cgroup_file, line)) {
+		if (line.rfind("0::", 0) == 0)
+			return "/sys/fs/cgroup" + line.substr(3);
+	}
+	return {};
+}
+
+std::optional<uintmax_t> Utils::System::get_cgroup_memory_limit() {
+	auto cgroup = get_cgroup_folder();
+	if (!cgroup) return {};
+
+	std::string max;
+	std::ifstream max_file(*cgroup + "/memory.max");
+	if (!(max_file >> max) || max == "max") return {};
+	try {
+		return std::stoull(max);
+	}
+	catch (const std::exception&) {
+		return {};
+	}
+}
+
+std::optional<uintmax_t> Utils::System::get_cgroup_available_memory() {
+	auto limit = get_cgroup_memory_limit();
+	if (!limit) return {};
+
+	const std::string cgroup = *get_cgroup_folder();
+	uintmax_t current;
+	std::ifstream current_file(cgroup + "/memory.current");
+	if (!(current_file >> current)) return {};
+
+	// Inactive page cache is charged to the cgroup but it is reclaimed before OOM happens
+	uintmax_t inactive_file = 0;
+	std::ifstream stat_file(cgroup + "/memory.stat");
+	std::string key;
+	uintmax_t value;
+	while (stat_file >> key >> value) {
+		if (key == "inactive_file") {
+			inactive_file = value;
+			break;
+		}
+	}
+	const uintmax_t used = current > inactive_file ? current - inactive_file : 0;
+	return *limit > used ? *limit - used : 0;
+}
+
+std::optional<uintmax_t> Utils::System::read_kb_value(const std::string& file, const std::string& key) {
+	std::ifstream input(file);
+	std::string line;
+	while (std::getline(input, line)) {
+		if (line.rfind(key, 0) == 0) {
+			try {
+				return std::stoull(line.substr(key.size())) * 1024;
+			}
+			catch (const std::exception&) {
+				return {};
+			}
+		}
+	}
+	return {};
+}
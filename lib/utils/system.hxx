@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace StormByte::VideoConvert::Utils {
+	class System {
+		public:
+			static std::string get_hostname();
+			/* Memory which can be used without swapping, limited by our cgroup (if any) */
+			static std::optional<uintmax_t> get_available_memory();
+			/* Memory this process could ever use: physical memory limited by our cgroup maximum (if any) */
+			static std::optional<uintmax_t> get_total_memory();
+			/* Peak resident memory (VmHWM) of a running process */
+			static std::optional<uintmax_t> get_peak_memory(const pid_t& pid);
+			/* Bytes read and written by a process which reached storage layer (read_bytes and write_bytes of /proc/<pid>/io) */
+			static std::optional<std::pair<uintmax_t, uintmax_t>> get_io_bytes(const pid_t& pid);
+			/* Bytes moved by read and write calls of a process (rchar plus wchar of /proc/<pid>/io), cached and network I/O included */
+			static std::optional<uintmax_t> get_io_activity(const pid_t& pid);
+			/* File descriptor which becomes readable when the child process exits (Linux >= 5.3) */
+			static std::optional<int> open_pidfd(const pid_t& pid);
+
+		private:
+			static std::optional<std::string> get_cgroup_folder();
+			static std::optional<uintmax_t> get_cgroup_memory_limit();
+			static std::optional<uintmax_t> get_cgroup_available_memory();
+			static std::optional<uintmax_t> read_kb_value(const std::string& file, const std::string& key);
+	};
+}
@@ -0,0 +1,244 @@
+#include "walker.hxx"
+
+#include <thread>
+#include <csignal>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+using namespace StormByte::VideoConvert;
+
+const size_t Utils::Walker::DIRENT_BUFFER_SIZE = 256 << 10; // 256 KiB, fewer round trips on network filesystems
+
+Utils::Walker::Walker(const Types::path_t& base, const unsigned int& threads):m_base(base), m_threads(threads) {
+	// Most time is spent waiting on storage (specially over NFS) so it is worth having more threads than cores
+	if (m_threads == 0)
+		m_threads = std::max(4u, std::thread::hardware_concurrency());
+}
+
+std::list<Types::path_t> Utils::Walker::find_files(const Types::path_t& folder) const {
+	std::mutex mutex;
+	std::list<Types::path_t> result;
+
+	walk(folder, [&](const Types::path_t& current, std::vector<char>& buffer, std::list<Types::path_t>& subfolders) {
+		const int fd = open_folder(current);
+		std::list<Types::path_t> files;
+		try {
+			read_entries(fd, current, buffer, [&](const char* name, const unsigned char& type) {
+				if (type == DT_DIR)
+					subfolders.push_back(current / name);
+				else if (type == DT_REG)
+					files.push_back(current / name);
+			});
+		}
+		catch (...) {
+			close(fd);
+			throw;
+		}
+		close(fd);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		result.splice(result.end(), files);
+	});
+
+	result.sort();
+	return result;
+}
+
+Utils::Walker::scan_result Utils::Walker::scan(const Types::path_t& folder, const index_t& index) const {
+	std::mutex mutex;
+	scan_result result;
+
+	walk(folder, [&](const Types::path_t& current, std::vector<char>& buffer, std::list<Types::path_t>& subfolders) {
+		const int fd = open_folder(current);
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			const int error = errno;
+			close(fd);
+			throw std::runtime_error("Can not stat directory " + (m_base / current).string() + ": " + std::strerror(error));
+		}
+
+		const auto indexed = index.find(current);
+		if (indexed != index.end() && indexed->second.m_mtime == to_nanoseconds(info.st_mtim) && indexed->second.m_inode == info.st_ino) {
+			// Nothing was added, removed or renamed here so there is no need to read it
+			close(fd);
+			std::list<Types::path_t> unchanged;
+			for (auto it = indexed->second.m_files.begin(); it != indexed->second.m_files.end(); it++)
+				unchanged.push_back(current / it->first);
+			for (const auto& name: indexed->second.m_folders)
+				subfolders.push_back(current / name);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			result.m_unchanged.splice(result.m_unchanged.end(), unchanged);
+			return;
+		}
+
+		folder_index contents;
+		contents.m_mtime = to_nanoseconds(info.st_mtim);
+		contents.m_inode = info.st_ino;
+		std::list<Types::path_t> changed, unchanged;
+		try {
+			read_entries(fd, current, buffer, [&](const char* name, const unsigned char& type) {
+				if (type == DT_DIR) {
+					contents.m_folders.insert(name);
+					subfolders.push_back(current / name);
+				}
+				else if (type == DT_REG) {
+					struct stat file_info;
+					if (fstatat(fd, name, &file_info, 0) != 0) return; // Vanished while reading
+					const file_signature signature { static_cast<uintmax_t>(file_info.st_size), to_nanoseconds(file_info.st_mtim) };
+					contents.m_files[name] = signature;
+
+					if (indexed != index.end() && indexed->second.m_files.contains(name) && indexed->second.m_files.at(name) == signature)
+						unchanged.push_back(current / name);
+					else
+						changed.push_back(current / name);
+				}
+			});
+		}
+		catch (...) {
+			close(fd);
+			throw;
+		}
+		close(fd);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		// Subfolders which are gone take their whole indexed subtree with them
+		if (indexed != index.end()) {
+			for (const auto& name: indexed->second.m_folders) {
+				if (contents.m_folders.contains(name)) continue;
+				const Types::path_t removed = current / name;
+				for (auto it = index.find(removed); it != index.end() && is_inside(it->first, removed); it++)
+					result.m_removed.push_back(it->first);
+			}
+		}
+		result.m_changed.splice(result.m_changed.end(), changed);
+		result.m_unchanged.splice(result.m_unchanged.end(), unchanged);
+		result.m_updated[current] = std::move(contents);
+	});
+
+	result.m_changed.sort();
+	result.m_unchanged.sort();
+	return result;
+}
+
+bool Utils::Walker::is_inside(const Types::path_t& path, const Types::path_t& folder) {
+	if (folder.empty()) return true;
+	auto path_it = path.begin();
+	for (auto it = folder.begin(); it != folder.end(); it++, path_it++) {
+		if (path_it == path.end() || *path_it != *it)
+			return false;
+	}
+	return true;
+}
+
+void Utils::Walker::walk(const Types::path_t& folder, const visitor_t& visit) const {
+	walk_state state;
+	state.m_pending.push(normalize(folder));
+
+	// Signals have to be delivered to main thread
+	std::vector<std::thread> threads;
+	sigset_t all_signals, previous_signals;
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_BLOCK, &all_signals, &previous_signals);
+	for (unsigned int i = 1; i < m_threads; i++)
+		threads.emplace_back(&Walker::worker, this, std::ref(state), std::cref(visit));
+	pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+
+	worker(state, visit);
+	for (auto& thread: threads)
+		thread.join();
+
+	if (state.m_error)
+		throw std::runtime_error(*state.m_error);
+}
+
+void Utils::Walker::worker(walk_state& state, const visitor_t& visit) const {
+	std::vector<char> buffer(DIRENT_BUFFER_SIZE);
+	std::unique_lock<std::mutex> lock(state.m_mutex);
+	while (true) {
+		// Nothing pending while nobody is reading means the whole tree was walked
+		state.m_condition.wait(lock, [&state] { return !state.m_pending.empty() || state.m_busy == 0 || state.m_error; });
+		if (state.m_pending.empty() || state.m_error) break;
+
+		const Types::path_t folder = std::move(state.m_pending.front());
+		state.m_pending.pop();
+		state.m_busy++;
+		lock.unlock();
+
+		std::list<Types::path_t> subfolders;
+		std::optional<std::string> error;
+		try {
+			visit(folder, buffer, subfolders);
+		}
+		catch (const std::exception& e) {
+			error = e.what();
+		}
+
+		lock.lock();
+		state.m_busy--;
+		if (error && !state.m_error)
+			state.m_error = std::move(error);
+		for (auto& subfolder: subfolders)
+			state.m_pending.push(std::move(subfolder));
+		state.m_condition.notify_all();
+	}
+}
+
+int Utils::Walker::open_folder(const Types::path_t& folder) const {
+	const Types::path_t full_path = m_base / folder;
+	const int fd = open(full_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd == -1)
+		throw std::runtime_error("Can not open directory " + full_path.string() + ": " + std::strerror(errno));
+	return fd;
+}
+
+void Utils::Walker::read_entries(const int& fd, const Types::path_t& folder, std::vector<char>& buffer, const entry_callback_t& callback) {
+	long read_bytes;
+	while ((read_bytes = syscall(SYS_getdents64, fd, buffer.data(), buffer.size())) > 0) {
+		for (long offset = 0; offset < read_bytes;) {
+			// glibc's dirent64 has the same layout than kernel's linux_dirent64
+			const struct dirent64* entry = reinterpret_cast<const struct dirent64*>(buffer.data() + offset);
+			offset += entry->d_reclen;
+			if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) continue;
+
+			unsigned char type = entry->d_type;
+			if (type == DT_UNKNOWN)
+				type = stat_type(fd, entry->d_name, false);
+			if (type == DT_LNK) {
+				type = stat_type(fd, entry->d_name, true);
+				// As std::filesystem, symlinked directories are not followed
+				if (type == DT_DIR) continue;
+			}
+			callback(entry->d_name, type);
+		}
+	}
+	if (read_bytes == -1)
+		throw std::runtime_error("Can not read directory " + folder.string() + ": " + std::strerror(errno));
+}
+
+unsigned char Utils::Walker::stat_type(const int& folder_fd, const char* name, const bool& follow) {
+	struct stat info;
+	if (fstatat(folder_fd, name, &info, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+		return DT_UNKNOWN; // Broken link or vanished file
+	return IFTODT(info.st_mode);
+}
+
+int64_t Utils::Walker::to_nanoseconds(const struct timespec& time) {
+	return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+Types::path_t Utils::Walker::normalize(const Types::path_t& folder) {
+	Types::path_t result = folder.lexically_normal();
+	if (result == ".") result.clear();
+	// Trailing separator would make it a different key than the one built while walking
+	if (!result.empty() && !result.has_filename())
+		result = result.parent_path();
+	return result;
+}
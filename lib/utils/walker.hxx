@@ -0,0 +1,80 @@
+#pragma once
+
+#include "types.hxx"
+
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <queue>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace StormByte::VideoConvert::Utils {
+	/* Lists directory trees in parallel from raw directory entries so files are only stat'ed when filesystem does not report their type */
+	class Walker {
+		public:
+			struct file_signature {
+				uintmax_t m_size;
+				int64_t m_mtime; // In nanoseconds
+				inline bool operator==(const file_signature&) const = default;
+			};
+			struct folder_index {
+				int64_t m_mtime = 0; // In nanoseconds
+				uint64_t m_inode = 0;
+				std::map<std::string, file_signature> m_files; // By file name
+				std::set<std::string> m_folders; // Subfolder names
+			};
+			using index_t = std::map<Types::path_t, folder_index>; // Folders relative to base
+			struct scan_result {
+				std::list<Types::path_t> m_changed; // New or modified files
+				std::list<Types::path_t> m_unchanged;
+				index_t m_updated; // Folders which had to be read again, with their current contents
+				std::list<Types::path_t> m_removed; // Indexed folders which no longer exist
+			};
+
+			Walker(const Types::path_t& base, const unsigned int& threads = 0); // 0 selects thread count automatically
+			Walker(const Walker&) = delete;
+			Walker(Walker&&) noexcept = delete;
+			Walker& operator=(const Walker&) = delete;
+			Walker& operator=(Walker&&) noexcept = delete;
+			~Walker() noexcept = default;
+
+			/* Regular files (and symlinks to them) under folder, relative to base and sorted, throws std::runtime_error if a directory can not be read */
+			std::list<Types::path_t> find_files(const Types::path_t& folder) const;
+			/**
+			 * Same than find_files but folders whose mtime and inode match index are not read at all, their indexed files are taken as unchanged.
+			 * So files modified in place (without being replaced) inside unchanged folders are not noticed
+			 */
+			scan_result scan(const Types::path_t& folder, const index_t& index) const;
+
+			/* True when path is folder itself or is inside it */
+			static bool is_inside(const Types::path_t& path, const Types::path_t& folder);
+
+		private:
+			using visitor_t = std::function<void(const Types::path_t& folder, std::vector<char>& buffer, std::list<Types::path_t>& subfolders)>;
+			using entry_callback_t = std::function<void(const char* name, const unsigned char& type)>;
+
+			struct walk_state {
+				std::mutex m_mutex;
+				std::condition_variable m_condition;
+				std::queue<Types::path_t> m_pending; // Directories waiting to be read
+				unsigned int m_busy = 0; // Directories being read right now
+				std::optional<std::string> m_error;
+			};
+
+			void walk(const Types::path_t& folder, const visitor_t& visit) const;
+			void worker(walk_state& state, const visitor_t& visit) const;
+			int open_folder(const Types::path_t& folder) const;
+			static void read_entries(const int& fd, const Types::path_t& folder, std::vector<char>& buffer, const entry_callback_t& callback);
+			static unsigned char stat_type(const int& folder_fd, const char* name, const bool& follow);
+			static int64_t to_nanoseconds(const struct timespec& time);
+			static Types::path_t normalize(const Types::path_t& folder);
+
+			Types::path_t m_base;
+			unsigned int m_threads;
+
+			static const size_t DIRENT_BUFFER_SIZE;
+	};
+}